@@ -0,0 +1,463 @@
+#include "Aggregate.hpp"
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+bool AggregateSpec::parse_function(const std::string& name, AggregateFunction& function) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+    static const std::pair<const char*, AggregateFunction> names[] = {
+        {"COUNT", AGG_COUNT}, {"SUM", AGG_SUM}, {"AVG", AGG_AVG}, {"MIN", AGG_MIN}, {"MAX", AGG_MAX}};
+    for (const auto& [text, value] : names) {
+        if (upper == text) {
+            function = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::map<std::string, std::string> AggregateSpec::schema() const {
+    static const char* const types[] = {"INT", "FLOAT", "VARCHAR"};
+    std::map<std::string, std::string> columns;
+    for (const Output& output : outputs) {
+        Expression::Domain domain = Expression::DOMAIN_INT;
+        if (output.group) {
+            domain = domains[output.index];
+        } else if (calls[output.index].function == AGG_AVG) {
+            domain = Expression::DOMAIN_FLOAT;
+        } else if (calls[output.index].function != AGG_COUNT) {
+            domain = domains[calls[output.index].input];
+        }
+        columns[output.name] = types[domain];
+    }
+    return columns;
+}
+
+static std::string format_real(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+}
+
+static void accumulate(Accumulator& state, AggregateFunction function, Expression::Domain domain, std::string_view value) {
+    int64_t integer = 0;
+    double real = 0;
+    if (domain == Expression::DOMAIN_INT ? !Expression::parse_integer(value, integer)
+        : domain == Expression::DOMAIN_FLOAT ? !Expression::parse_real(value, real)
+        : value.empty()) {
+        return;
+    }
+    bool first = state.count++ == 0;
+    switch (function) {
+    case AGG_COUNT:
+        break;
+    case AGG_SUM:
+    case AGG_AVG:
+        state.integer += integer;
+        state.real += real;
+        break;
+    case AGG_MIN:
+    case AGG_MAX: {
+        bool less = function == AGG_MIN;
+        if (domain == Expression::DOMAIN_INT && (first || (integer < state.integer) == less)) {
+            state.integer = integer;
+        } else if (domain == Expression::DOMAIN_FLOAT && (first || (real < state.real) == less)) {
+            state.real = real;
+        } else if (domain == Expression::DOMAIN_TEXT && (first || (value < state.text) == less)) {
+            state.text = value;
+        }
+        break;
+    }
+    }
+}
+
+static void combine(Accumulator& state, const Accumulator& other, AggregateFunction function, Expression::Domain domain) {
+    if (other.count == 0) {
+        return;
+    }
+    if (state.count == 0) {
+        state = other;
+        return;
+    }
+    state.count += other.count;
+    bool less = function == AGG_MIN;
+    if (function == AGG_SUM || function == AGG_AVG) {
+        state.integer += other.integer;
+        state.real += other.real;
+    } else if (function == AGG_MIN || function == AGG_MAX) {
+        if (domain == Expression::DOMAIN_INT && (other.integer < state.integer) == less && other.integer != state.integer) {
+            state.integer = other.integer;
+        } else if (domain == Expression::DOMAIN_FLOAT && (other.real < state.real) == less && other.real != state.real) {
+            state.real = other.real;
+        } else if (domain == Expression::DOMAIN_TEXT && (other.text < state.text) == less && other.text != state.text) {
+            state.text = other.text;
+        }
+    }
+}
+
+static std::string result(const Accumulator& state, AggregateFunction function, Expression::Domain domain) {
+    if (function == AGG_COUNT) {
+        return std::to_string(state.count);
+    }
+    if (state.count == 0) {
+        return "NULL";
+    }
+    if (function == AGG_AVG) {
+        return format_real((domain == Expression::DOMAIN_INT ? static_cast<double>(state.integer) : state.real) / state.count);
+    }
+    if (domain == Expression::DOMAIN_INT) {
+        return std::to_string(state.integer);
+    }
+    return domain == Expression::DOMAIN_FLOAT ? format_real(state.real) : state.text;
+}
+
+// Group key fields: a tag byte, then 8 bytes of int64 or double, or a 4 byte length and text.
+// Values that are not numbers of their column's type are kept as text.
+enum : char {
+    KEY_INT = 1,
+    KEY_REAL = 2,
+    KEY_TEXT = 3
+};
+
+static void append_key(std::string& key, Expression::Domain domain, std::string_view value) {
+    int64_t integer;
+    double real;
+    if (domain == Expression::DOMAIN_INT && Expression::parse_integer(value, integer)) {
+        key.push_back(KEY_INT);
+        key.append(reinterpret_cast<const char*>(&integer), sizeof(integer));
+    } else if (domain == Expression::DOMAIN_FLOAT && Expression::parse_real(value, real)) {
+        key.push_back(KEY_REAL);
+        key.append(reinterpret_cast<const char*>(&real), sizeof(real));
+    } else {
+        uint32_t length = static_cast<uint32_t>(value.size());
+        key.push_back(KEY_TEXT);
+        key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        key.append(value.data(), value.size());
+    }
+}
+
+static std::vector<std::string> split_key(const std::string& key) {
+    std::vector<std::string> values;
+    size_t offset = 0;
+    while (offset < key.size()) {
+        char tag = key[offset++];
+        if (tag == KEY_INT) {
+            int64_t integer;
+            std::memcpy(&integer, key.data() + offset, sizeof(integer));
+            values.push_back(std::to_string(integer));
+            offset += sizeof(integer);
+        } else if (tag == KEY_REAL) {
+            double real;
+            std::memcpy(&real, key.data() + offset, sizeof(real));
+            values.push_back(format_real(real));
+            offset += sizeof(real);
+        } else {
+            uint32_t length;
+            std::memcpy(&length, key.data() + offset, sizeof(length));
+            offset += sizeof(length);
+            values.push_back(key.substr(offset, length));
+            offset += length;
+        }
+    }
+    return values;
+}
+
+static void write_bytes(FILE* file, const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+        throw std::runtime_error("HashAggregate: cannot write to a spill file");
+    }
+}
+
+static void write_string(FILE* file, const std::string& text) {
+    uint32_t length = static_cast<uint32_t>(text.size());
+    write_bytes(file, &length, sizeof(length));
+    write_bytes(file, text.data(), text.size());
+}
+
+static bool read_string(FILE* file, std::string& text) {
+    uint32_t length;
+    if (std::fread(&length, sizeof(length), 1, file) != 1) {
+        return false;
+    }
+    text.resize(length);
+    return std::fread(text.data(), 1, length, file) == length;
+}
+
+
+AggregateTable::AggregateTable(const AggregateSpec& spec, size_t memoryBudget)
+    : spec(spec), memoryBudget(memoryBudget) {
+    clear();
+}
+
+AggregateTable::~AggregateTable() {
+    for (FILE* file : parts) {
+        if (file != nullptr) {
+            std::fclose(file);
+        }
+    }
+}
+
+void AggregateTable::clear() {
+    keys.clear();
+    states.clear();
+    slots.assign(16, Slot{0, 0});
+    mask = slots.size() - 1;
+    bytes = 0;
+}
+
+// The group of key, added with fresh accumulators when new.
+size_t AggregateTable::find(const std::string& key, uint64_t hash) {
+    size_t position = hash & mask;
+    while (slots[position].group != 0) {
+        const Slot& slot = slots[position];
+        if (slot.hash == hash && keys[slot.group - 1] == key) {
+            return slot.group - 1;
+        }
+        position = (position + 1) & mask;
+    }
+    slots[position] = Slot{hash, static_cast<uint32_t>(keys.size() + 1)};
+    keys.push_back(key);
+    states.resize(states.size() + spec.calls.size());
+    bytes += sizeof(std::string) + key.size() + spec.calls.size() * sizeof(Accumulator) + 2 * sizeof(Slot);
+    if (keys.size() * 2 > slots.size()) {
+        grow();
+    }
+    return keys.size() - 1;
+}
+
+// Doubles the slot array, keeping it at most half full.
+void AggregateTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, 0});
+    old.swap(slots);
+    mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.group == 0) {
+            continue;
+        }
+        size_t position = slot.hash & mask;
+        while (slots[position].group != 0) {
+            position = (position + 1) & mask;
+        }
+        slots[position] = slot;
+    }
+}
+
+void AggregateTable::add(const std::string_view* values) {
+    rowKey.clear();
+    for (size_t i = 0; i < spec.groups; i++) {
+        append_key(rowKey, spec.domains[i], values[i]);
+    }
+    size_t group = find(rowKey, HashIndex::hash(rowKey));
+    Accumulator* state = &states[group * spec.calls.size()];
+    for (size_t i = 0; i < spec.calls.size(); i++) {
+        const AggregateSpec::Call& call = spec.calls[i];
+        if (call.input < 0) {
+            state[i].count++;
+            continue;
+        }
+        size_t before = state[i].text.size();
+        accumulate(state[i], call.function, spec.domains[call.input], values[call.input]);
+        if (state[i].text.size() > before) {
+            bytes += state[i].text.size() - before;
+        }
+    }
+    if (bytes > memoryBudget && spec.groups > 0) {
+        spill();
+    }
+}
+
+void AggregateTable::merge(const AggregateTable& other) {
+    for (size_t group = 0; group < other.keys.size(); group++) {
+        absorb(other.keys[group], &other.states[group * spec.calls.size()]);
+    }
+}
+
+void AggregateTable::absorb(const std::string& groupKey, const Accumulator* incoming) {
+    size_t group = find(groupKey, HashIndex::hash(groupKey));
+    for (size_t i = 0; i < spec.calls.size(); i++) {
+        const AggregateSpec::Call& call = spec.calls[i];
+        combine(states[group * spec.calls.size() + i], incoming[i], call.function,
+                call.input < 0 ? Expression::DOMAIN_INT : spec.domains[call.input]);
+    }
+}
+
+void AggregateTable::add_empty() {
+    find("", HashIndex::hash(""));
+}
+
+// Writes every group, key then accumulators, to the partition of its key hash.
+void AggregateTable::spill() {
+    if (parts.empty()) {
+        for (size_t i = 0; i < PARTITIONS; i++) {
+            parts.push_back(std::tmpfile());
+            if (parts.back() == nullptr) {
+                throw std::runtime_error("HashAggregate: cannot create a spill file");
+            }
+        }
+    }
+    for (size_t group = 0; group < keys.size(); group++) {
+        FILE* file = parts[(HashIndex::hash(keys[group]) >> 60) % PARTITIONS];
+        write_string(file, keys[group]);
+        for (size_t i = 0; i < spec.calls.size(); i++) {
+            const Accumulator& state = states[group * spec.calls.size() + i];
+            write_bytes(file, &state.count, sizeof(state.count));
+            write_bytes(file, &state.integer, sizeof(state.integer));
+            write_bytes(file, &state.real, sizeof(state.real));
+            write_string(file, state.text);
+        }
+    }
+    clear();
+}
+
+void AggregateTable::load(const std::vector<std::unique_ptr<AggregateTable>>& tables, size_t part) {
+    clear();
+    std::vector<Accumulator> incoming(spec.calls.size());
+    std::string groupKey;
+    for (const auto& table : tables) {
+        if (!table->spilled()) {
+            continue;
+        }
+        FILE* file = table->parts[part];
+        std::rewind(file);
+        while (read_string(file, groupKey)) {
+            for (Accumulator& state : incoming) {
+                if (std::fread(&state.count, sizeof(state.count), 1, file) != 1 ||
+                    std::fread(&state.integer, sizeof(state.integer), 1, file) != 1 ||
+                    std::fread(&state.real, sizeof(state.real), 1, file) != 1 || !read_string(file, state.text)) {
+                    throw std::runtime_error("HashAggregate: truncated spill file");
+                }
+            }
+            absorb(groupKey, incoming.data());
+        }
+    }
+}
+
+void AggregateTable::row(size_t group, Tuple& tuple) const {
+    std::vector<std::string> values = split_key(keys[group]);
+    tuple.attributes.clear();
+    for (const AggregateSpec::Output& output : spec.outputs) {
+        std::string value;
+        if (output.group) {
+            value = output.index < values.size() ? values[output.index] : "";
+        } else {
+            const AggregateSpec::Call& call = spec.calls[output.index];
+            value = result(states[group * spec.calls.size() + output.index], call.function,
+                           call.input < 0 ? Expression::DOMAIN_INT : spec.domains[call.input]);
+        }
+        tuple.attributes.push_back({output.name, {Tuple::TYPE_STRING, std::move(value)}});
+    }
+}
+
+
+HashAggregate::HashAggregate(std::unique_ptr<Operator> child, AggregateSpec spec, size_t memoryBudget)
+    : child(std::move(child)), spec(std::move(spec)), memoryBudget(memoryBudget) {}
+
+HashAggregate::HashAggregate(HeapFile* heap, MorselPipeline pipeline, size_t parallelism, AggregateSpec spec, size_t memoryBudget)
+    : heap(heap), pipeline(std::move(pipeline)), parallelism(std::max<size_t>(parallelism, 1)), spec(std::move(spec)), memoryBudget(memoryBudget) {}
+
+void HashAggregate::open() {
+    partials.clear();
+    if (child) {
+        partials.push_back(std::make_unique<AggregateTable>(spec, memoryBudget));
+        consume(*partials[0]);
+    } else {
+        size_t morsels = ParallelScan::morsels(heap->get_table()->page_count);
+        size_t tasks = std::max<size_t>(std::min(parallelism, morsels), 1);
+        for (size_t i = 0; i < tasks; i++) {
+            partials.push_back(std::make_unique<AggregateTable>(spec, memoryBudget / tasks));
+        }
+        std::atomic<size_t> nextMorsel{0};
+        ThreadPool::shared().run(tasks, tasks, [&](size_t task) {
+            scan(*partials[task], nextMorsel, morsels);
+        });
+    }
+
+    spills = std::any_of(partials.begin(), partials.end(), [](const auto& table) { return table->spilled(); });
+    if (spills) {
+        for (auto& table : partials) {
+            table->spill();
+        }
+        result = std::make_unique<AggregateTable>(spec, SIZE_MAX);
+        result->load(partials, 0);
+    } else {
+        result = std::move(partials[0]);
+        for (size_t i = 1; i < partials.size(); i++) {
+            result->merge(*partials[i]);
+        }
+        partials.clear();
+    }
+    if (spec.groups == 0) {
+        result->add_empty();
+    }
+    position = 0;
+    partition = 0;
+}
+
+bool HashAggregate::next(Tuple& tuple) {
+    while (result && position == result->size()) {
+        if (!spills || ++partition == AggregateTable::PARTITIONS) {
+            return false;
+        }
+        result->load(partials, partition);
+        position = 0;
+    }
+    if (!result) {
+        return false;
+    }
+    result->row(position++, tuple);
+    return true;
+}
+
+void HashAggregate::close() {
+    partials.clear();
+    result.reset();
+    position = 0;
+}
+
+// Rows of another operator, their values looked up by column name.
+void HashAggregate::consume(AggregateTable& table) {
+    std::vector<std::string_view> values(spec.inputs.size());
+    Tuple tuple;
+    child->open();
+    while (child->next(tuple)) {
+        for (size_t i = 0; i < spec.inputs.size(); i++) {
+            values[i] = std::string_view();
+            for (const auto& attr : tuple.attributes) {
+                if (attr.first == spec.inputs[i]) {
+                    values[i] = attr.second.second;
+                    break;
+                }
+            }
+        }
+        table.add(values.data());
+    }
+    child->close();
+}
+
+// One task's share of the table: morsels taken in turn, rows read straight from the batches.
+void HashAggregate::scan(AggregateTable& table, std::atomic<size_t>& nextMorsel, size_t morsels) {
+    std::vector<std::string_view> values(spec.inputs.size());
+    std::vector<const ColumnVector*> columns(spec.inputs.size());
+    Batch batch;
+    for (size_t morsel = nextMorsel++; morsel < morsels; morsel = nextMorsel++) {
+        uint32_t first = static_cast<uint32_t>(morsel) * ParallelScan::MORSEL_PAGES + 1;
+        std::unique_ptr<BatchOperator> batches = pipeline(first, first + ParallelScan::MORSEL_PAGES - 1);
+        batches->open();
+        while (batches->next(batch)) {
+            for (size_t i = 0; i < spec.inputs.size(); i++) {
+                columns[i] = batch.column(spec.inputs[i]);
+            }
+            for (size_t i = 0; i < batch.selected; i++) {
+                uint32_t row = batch.dense ? static_cast<uint32_t>(i) : batch.selection[i];
+                for (size_t c = 0; c < columns.size(); c++) {
+                    values[c] = columns[c] != nullptr ? batch.value(*columns[c], row) : std::string_view();
+                }
+                table.add(values.data());
+            }
+        }
+        batches->close();
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef AGGREGATE_HPP
+#define AGGREGATE_HPP
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <map>
+#include "Operator.hpp"
+#include "Parallel.hpp"
+#include "Expression.hpp"
+
+enum AggregateFunction {
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_AVG,
+    AGG_MIN,
+    AGG_MAX
+};
+
+// What a grouped SELECT computes. The input columns are the group columns followed by the
+// aggregate arguments; the output lists the select list in order, each entry a group column or
+// an aggregate.
+struct AggregateSpec {
+    struct Call {
+        AggregateFunction function;
+        int input;  // into the input columns, -1 for COUNT(*)
+    };
+
+    struct Output {
+        std::string name;
+        bool group;
+        size_t index;
+    };
+
+    std::vector<std::string> inputs;
+    std::vector<Expression::Domain> domains;
+    size_t groups = 0;
+    std::vector<Call> calls;
+    std::vector<Output> outputs;
+
+    static bool parse_function(const std::string& name, AggregateFunction& function);
+
+    // The output columns with the types of their values, for clauses that refer to them.
+    std::map<std::string, std::string> schema() const;
+};
+
+// The running state of one aggregate of one group. Values that are not plain numbers of their
+// column's type, and empty text, are NULL and skipped, as SQL skips NULLs.
+struct Accumulator {
+    int64_t count = 0;
+    int64_t integer = 0;
+    double real = 0;
+    std::string text;
+};
+
+// Groups rows by the group columns in an open-addressing hash table keyed by the group values
+// in a binary form: integers and reals as 8 bytes, text as length and bytes. Past its memory
+// budget the table writes its groups to PARTITIONS temporary files by key hash and starts over,
+// so groups spilled more than once are merged again when the partitions are read back. A table
+// without group columns has one group and never spills.
+class AggregateTable {
+public:
+    static constexpr size_t PARTITIONS = 16;
+
+    AggregateTable(const AggregateSpec& spec, size_t memoryBudget);
+    ~AggregateTable();
+
+    // One row: values[i] is its value of spec.inputs[i].
+    void add(const std::string_view* values);
+    void merge(const AggregateTable& other);
+    // The one group of an aggregate without GROUP BY, which exists even when no row does.
+    void add_empty();
+
+    bool spilled() const { return !parts.empty(); }
+    void spill();
+    // Reads back partition part of every table, merging the groups into this one.
+    void load(const std::vector<std::unique_ptr<AggregateTable>>& tables, size_t part);
+
+    size_t size() const { return keys.size(); }
+    void clear();
+    void row(size_t group, Tuple& tuple) const;
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t group;
+    };
+
+    const AggregateSpec& spec;
+    size_t memoryBudget;
+    std::vector<std::string> keys;
+    std::vector<Accumulator> states;
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    size_t bytes = 0;
+    std::vector<FILE*> parts;
+    std::string rowKey;
+
+    size_t find(const std::string& key, uint64_t hash);
+    void grow();
+    void absorb(const std::string& groupKey, const Accumulator* incoming);
+};
+
+// GROUP BY and aggregates as hash aggregation. Fed by a table's morsel pipeline it runs on the
+// shared thread pool: each of up to parallelism tasks takes morsels one after another into its
+// own partial table, and the partial tables are merged at the end. Fed by any other operator it
+// aggregates that operator's rows on one thread. Either way open() consumes the whole input and
+// next() hands out one row per group; without GROUP BY there is always exactly one row.
+class HashAggregate : public Operator {
+public:
+    HashAggregate(std::unique_ptr<Operator> child, AggregateSpec spec, size_t memoryBudget);
+    HashAggregate(HeapFile* heap, MorselPipeline pipeline, size_t parallelism, AggregateSpec spec, size_t memoryBudget);
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "HashAggregate"; }
+
+    bool spilled() const { return spills; }
+
+private:
+    std::unique_ptr<Operator> child;
+    HeapFile* heap = nullptr;
+    MorselPipeline pipeline;
+    size_t parallelism = 1;
+    AggregateSpec spec;
+    size_t memoryBudget;
+
+    std::vector<std::unique_ptr<AggregateTable>> partials;
+    std::unique_ptr<AggregateTable> result;
+    size_t position = 0;
+    size_t partition = 0;
+    bool spills = false;
+
+    void consume(AggregateTable& table);
+    void scan(AggregateTable& table, std::atomic<size_t>& nextMorsel, size_t morsels);
+};
+
+#endif
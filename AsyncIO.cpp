@@ -0,0 +1,278 @@
+#include "AsyncIO.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+std::unique_ptr<AsyncIO> AsyncIO::create(unsigned depth, AsyncBackend preferred) {
+    if (preferred == ASYNC_URING) {
+        std::unique_ptr<UringIO> uring = std::make_unique<UringIO>(depth);
+        if (uring->ok()) {
+            return uring;
+        }
+    }
+    return std::make_unique<ThreadPoolIO>(std::min(depth, 4u));
+}
+
+
+UringIO::UringIO(unsigned depth) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, std::max(depth, 1u), &params));
+    if (fd < 0) {
+        return;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        close(fd);
+        return;
+    }
+    cqRing = singleMap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        munmap(sqRing, sqRingSize);
+        sqRing = cqRing = sqes = nullptr;
+        close(fd);
+        return;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = cq + params.cq_off.cqes;
+
+    entries = params.sq_entries;
+    ringFd = fd;
+}
+
+UringIO::~UringIO() {
+    if (ringFd < 0) {
+        return;
+    }
+    std::vector<IoCompletion> drained;
+    if (pending > 0) {
+        wait(drained, pending.load());
+    }
+    munmap(sqes, sqesSize);
+    if (cqRing != sqRing) {
+        munmap(cqRing, cqRingSize);
+    }
+    munmap(sqRing, sqRingSize);
+    close(ringFd);
+}
+
+int UringIO::enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    while (true) {
+        int result = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        if (result >= 0 || errno != EINTR) {
+            return result;
+        }
+    }
+}
+
+void UringIO::prepare(const IoRequest& request) {
+    std::lock_guard<std::mutex> lock(submitLock);
+    unsigned tail = *sqTail;
+    if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= entries) {
+        submitLocked();
+        tail = *sqTail;
+    }
+
+    unsigned index = tail & *sqMask;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = request.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(request.buffer);
+    sqe->len = static_cast<uint32_t>(request.length);
+    sqe->off = static_cast<uint64_t>(request.offset);
+    sqe->user_data = request.tag;
+    sqArray[index] = index;
+
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    queued++;
+    pending++;
+}
+
+int UringIO::submit() {
+    std::lock_guard<std::mutex> lock(submitLock);
+    return submitLocked();
+}
+
+int UringIO::submitLocked() {
+    if (queued == 0) {
+        return 0;
+    }
+    int submitted = enter(queued, 0, 0);
+    if (submitted < 0) {
+        std::cerr << "Error: io_uring submit failed: " << std::strerror(errno) << std::endl;
+        return 0;
+    }
+    queued -= submitted;
+    return submitted;
+}
+
+int UringIO::reap(std::vector<IoCompletion>& completions) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    int reaped = 0;
+    while (head != tail) {
+        const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(cqes) + (head & *cqMask);
+        completions.push_back({cqe->user_data, cqe->res});
+        head++;
+        reaped++;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    pending -= reaped;
+    return reaped;
+}
+
+int UringIO::poll(std::vector<IoCompletion>& completions) {
+    submit();
+    std::lock_guard<std::mutex> lock(reapLock);
+    return reap(completions);
+}
+
+int UringIO::wait(std::vector<IoCompletion>& completions, int minimum) {
+    submit();
+    std::lock_guard<std::mutex> lock(reapLock);
+    minimum = std::min(minimum, pending.load());
+    int reaped = reap(completions);
+    while (reaped < minimum) {
+        if (enter(0, minimum - reaped, IORING_ENTER_GETEVENTS) < 0) {
+            std::cerr << "Error: io_uring wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        reaped += reap(completions);
+    }
+    return reaped;
+}
+
+
+ThreadPoolIO::ThreadPoolIO(unsigned threads) {
+    for (unsigned i = 0; i < std::max(threads, 1u); i++) {
+        workers.emplace_back(&ThreadPoolIO::run, this);
+    }
+}
+
+ThreadPoolIO::~ThreadPoolIO() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPoolIO::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        IoRequest request = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        size_t done = 0;
+        int result = 0;
+        while (done < request.length) {
+            ssize_t n = request.write
+                ? pwrite(request.fd, request.buffer + done, request.length - done, request.offset + done)
+                : pread(request.fd, request.buffer + done, request.length - done, request.offset + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                result = -errno;
+                break;
+            }
+            if (n == 0) {
+                break;
+            }
+            done += n;
+        }
+        if (result == 0) {
+            result = static_cast<int>(done);
+        }
+
+        lock.lock();
+        this->done.push_back({request.tag, result});
+        finished.notify_all();
+    }
+}
+
+void ThreadPoolIO::prepare(const IoRequest& request) {
+    std::lock_guard<std::mutex> lock(mutex);
+    staged.push_back(request);
+    pending++;
+}
+
+int ThreadPoolIO::submit() {
+    int submitted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (staged.empty()) {
+            return 0;
+        }
+        submitted = static_cast<int>(staged.size());
+        queue.insert(queue.end(), staged.begin(), staged.end());
+        staged.clear();
+    }
+    work.notify_all();
+    return submitted;
+}
+
+int ThreadPoolIO::poll(std::vector<IoCompletion>& completions) {
+    submit();
+    std::lock_guard<std::mutex> lock(mutex);
+    int reaped = static_cast<int>(done.size());
+    completions.insert(completions.end(), done.begin(), done.end());
+    done.clear();
+    pending -= reaped;
+    if (reaped > 0) {
+        finished.notify_all();
+    }
+    return reaped;
+}
+
+int ThreadPoolIO::wait(std::vector<IoCompletion>& completions, int minimum) {
+    submit();
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return static_cast<int>(done.size()) >= std::min(minimum, pending.load()); });
+    int reaped = static_cast<int>(done.size());
+    completions.insert(completions.end(), done.begin(), done.end());
+    done.clear();
+    pending -= reaped;
+    finished.notify_all();
+    return reaped;
+}
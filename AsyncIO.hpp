@@ -0,0 +1,123 @@
+#ifndef ASYNC_IO_HPP
+#define ASYNC_IO_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+
+enum AsyncBackend {
+    ASYNC_URING,
+    ASYNC_THREADS
+};
+
+struct IoRequest {
+    int fd;
+    char* buffer;
+    size_t length;
+    off_t offset;
+    bool write;
+    uint64_t tag;
+};
+
+struct IoCompletion {
+    uint64_t tag;
+    int result;
+};
+
+// Queue of page reads and writes that run in the background. Requests are queued with
+// prepare() and handed to the kernel together by submit(); completions are collected
+// with poll() (never blocks) or wait(). Any thread may call any of these: submitters and
+// reapers take separate locks, so a thread blocked in wait() never stalls a submit.
+class AsyncIO {
+public:
+    virtual ~AsyncIO() = default;
+
+    virtual void prepare(const IoRequest& request) = 0;
+    virtual int submit() = 0;
+    virtual int poll(std::vector<IoCompletion>& completions) = 0;
+    virtual int wait(std::vector<IoCompletion>& completions, int minimum) = 0;
+
+    int inFlight() const { return pending.load(); }
+    virtual const char* name() const = 0;
+
+    static std::unique_ptr<AsyncIO> create(unsigned depth, AsyncBackend preferred = ASYNC_URING);
+
+protected:
+    std::atomic<int> pending{0};
+};
+
+// io_uring through the raw syscalls, so liburing is not needed.
+class UringIO : public AsyncIO {
+public:
+    explicit UringIO(unsigned depth);
+    ~UringIO() override;
+
+    bool ok() const { return ringFd >= 0; }
+
+    void prepare(const IoRequest& request) override;
+    int submit() override;
+    int poll(std::vector<IoCompletion>& completions) override;
+    int wait(std::vector<IoCompletion>& completions, int minimum) override;
+    const char* name() const override { return "io_uring"; }
+
+private:
+    int ringFd = -1;
+    unsigned entries = 0;
+    unsigned queued = 0;
+
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    void* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    void* cqes = nullptr;
+
+    std::mutex submitLock;
+    std::mutex reapLock;
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+    int submitLocked();
+    int reap(std::vector<IoCompletion>& completions);
+};
+
+// Fallback when io_uring is unavailable: worker threads doing pread/pwrite.
+class ThreadPoolIO : public AsyncIO {
+public:
+    explicit ThreadPoolIO(unsigned threads);
+    ~ThreadPoolIO() override;
+
+    void prepare(const IoRequest& request) override;
+    int submit() override;
+    int poll(std::vector<IoCompletion>& completions) override;
+    int wait(std::vector<IoCompletion>& completions, int minimum) override;
+    const char* name() const override { return "threads"; }
+
+private:
+    std::vector<std::thread> workers;
+    std::vector<IoRequest> staged;
+    std::deque<IoRequest> queue;
+    std::vector<IoCompletion> done;
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable finished;
+    bool stopping = false;
+
+    void run();
+};
+
+#endif
@@ -0,0 +1,440 @@
+#include "BPlusTree.hpp"
+#include <algorithm>
+#include <climits>
+#include <cctype>
+#include <iostream>
+#include <arpa/inet.h>
+
+static uint16_t read_u16(const char* src) {
+    uint16_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return ntohs(value);
+}
+
+static void write_u16(char* dst, uint16_t value) {
+    value = htons(value);
+    std::memcpy(dst, &value, sizeof(value));
+}
+
+static int read_i32(const char* src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return static_cast<int>(ntohl(value));
+}
+
+static void write_i32(char* dst, int value) {
+    uint32_t network = htonl(static_cast<uint32_t>(value));
+    std::memcpy(dst, &network, sizeof(network));
+}
+
+static bool integerKey(const std::string& key, long long& value) {
+    size_t start = !key.empty() && key[0] == '-' ? 1 : 0;
+    if (key.size() == start || key.size() - start > 18) {
+        return false;
+    }
+    for (size_t i = start; i < key.size(); i++) {
+        if (!std::isdigit(static_cast<unsigned char>(key[i]))) {
+            return false;
+        }
+    }
+    value = std::stoll(key);
+    return true;
+}
+
+
+BPlusTree::BPlusTree(BufferPool* pool, FileManager* files, const std::string& path)
+    : Index(pool, files, path) {}
+
+
+int BPlusTree::compareKeys(const std::string& a, const std::string& b) {
+    long long x, y;
+    bool aInteger = integerKey(a, x);
+    bool bInteger = integerKey(b, y);
+    if (aInteger && bInteger) {
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    if (aInteger != bInteger) {
+        return aInteger ? -1 : 1;
+    }
+    int c = a.compare(b);
+    return c < 0 ? -1 : (c > 0 ? 1 : 0);
+}
+
+
+int BPlusTree::compareEntries(const IndexEntry& a, const IndexEntry& b) {
+    int c = compareKeys(a.key, b.key);
+    if (c != 0) {
+        return c;
+    }
+    if (a.rid.page != b.rid.page) {
+        return a.rid.page < b.rid.page ? -1 : 1;
+    }
+    if (a.rid.slot != b.rid.slot) {
+        return a.rid.slot < b.rid.slot ? -1 : 1;
+    }
+    return 0;
+}
+
+
+// Entry: key length | key | record page | record slot, then the right child in inner nodes.
+int BPlusTree::entrySize(const IndexEntry& entry, bool leaf) {
+    return 2 + static_cast<int>(entry.key.size()) + 8 + (leaf ? 0 : 4);
+}
+
+
+int BPlusTree::nodeSize(const Node& node) {
+    int size = HEADER_SIZE;
+    for (const IndexEntry& entry : node.entries) {
+        size += entrySize(entry, node.leaf);
+    }
+    return size;
+}
+
+
+// Number of entries <= target; in an inner node, the child to follow is the one right of the
+// last of them (the link child if there is none).
+size_t BPlusTree::childIndex(const Node& node, const IndexEntry& target) {
+    auto it = std::upper_bound(node.entries.begin(), node.entries.end(), target,
+                               [](const IndexEntry& a, const IndexEntry& b) { return compareEntries(a, b) < 0; });
+    return it - node.entries.begin();
+}
+
+
+// Node header: leaf flag | unused | entry count | link, where link is the right sibling of a
+// leaf (0 for the last leaf) and the leftmost child of an inner node.
+BPlusTree::Node BPlusTree::readNode(int pageId) {
+    Node node;
+    Buffer_Page* frame = pool->requestPage(fileId, pageId, INDEX_PAGE);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not read index page " << pageId << " of " << filePath << std::endl;
+        return node;
+    }
+    frame->latch.lock_shared();
+    const char* data = frame->data;
+    node.leaf = data[0] != 0;
+    int count = read_u16(data + 2);
+    node.link = read_i32(data + 4);
+    int offset = HEADER_SIZE;
+    node.entries.resize(count);
+    for (IndexEntry& entry : node.entries) {
+        uint16_t length = read_u16(data + offset);
+        entry.key.assign(data + offset + 2, length);
+        offset += 2 + length;
+        entry.rid = {read_i32(data + offset), read_i32(data + offset + 4)};
+        offset += 8;
+        if (!node.leaf) {
+            node.children.push_back(read_i32(data + offset));
+            offset += 4;
+        }
+    }
+    frame->latch.unlock_shared();
+    pool->releasePage(frame);
+    return node;
+}
+
+
+void BPlusTree::writeNode(int pageId, const Node& node) {
+    Buffer_Page* frame = pool->requestPage(fileId, pageId, INDEX_PAGE, true);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not write index page " << pageId << " of " << filePath << std::endl;
+        return;
+    }
+    frame->latch.lock();
+    char* data = frame->data;
+    std::memset(data, 0, PAGE_SIZE);
+    data[0] = node.leaf ? 1 : 0;
+    write_u16(data + 2, static_cast<uint16_t>(node.entries.size()));
+    write_i32(data + 4, node.link);
+    int offset = HEADER_SIZE;
+    for (size_t i = 0; i < node.entries.size(); i++) {
+        const IndexEntry& entry = node.entries[i];
+        write_u16(data + offset, static_cast<uint16_t>(entry.key.size()));
+        std::memcpy(data + offset + 2, entry.key.data(), entry.key.size());
+        offset += 2 + static_cast<int>(entry.key.size());
+        write_i32(data + offset, entry.rid.page);
+        write_i32(data + offset + 4, entry.rid.slot);
+        offset += 8;
+        if (!node.leaf) {
+            write_i32(data + offset, node.children[i]);
+            offset += 4;
+        }
+    }
+    frame->markDirty();
+    frame->latch.unlock();
+    pool->releasePage(frame);
+}
+
+
+// Meta page: magic | root | page count | height | column length | column.
+bool BPlusTree::readMeta() {
+    Buffer_Page* frame = pool->requestPage(fileId, 0, INDEX_PAGE);
+    if (frame == nullptr) {
+        return false;
+    }
+    frame->latch.lock_shared();
+    const char* data = frame->data;
+    bool valid = read_i32(data) == MAGIC;
+    if (valid) {
+        root = read_i32(data + 4);
+        pageCount = read_i32(data + 8);
+        levels = read_i32(data + 12);
+        indexColumn.assign(data + 18, read_u16(data + 16));
+    }
+    frame->latch.unlock_shared();
+    pool->releasePage(frame);
+    return valid;
+}
+
+
+void BPlusTree::writeMeta() {
+    Buffer_Page* frame = pool->requestPage(fileId, 0, INDEX_PAGE, true);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not write the header of " << filePath << std::endl;
+        return;
+    }
+    frame->latch.lock();
+    char* data = frame->data;
+    std::memset(data, 0, PAGE_SIZE);
+    write_i32(data, MAGIC);
+    write_i32(data + 4, root);
+    write_i32(data + 8, pageCount);
+    write_i32(data + 12, levels);
+    write_u16(data + 16, static_cast<uint16_t>(indexColumn.size()));
+    std::memcpy(data + 18, indexColumn.data(), indexColumn.size());
+    frame->markDirty();
+    frame->latch.unlock();
+    pool->releasePage(frame);
+}
+
+
+bool BPlusTree::open() {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    if (fileId < 0 || !readMeta()) {
+        std::cerr << "Error: " << filePath << " is not an index file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Bottom-up bulk load: the sorted entries are packed into leaves filled to FILL_SIZE, left to
+// right, then each level of inner nodes is built over the first entries of the level below,
+// until one node is left. Every page is written once.
+bool BPlusTree::build(const std::string& column, std::vector<IndexEntry> entries) {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    if (fileId < 0) {
+        return false;
+    }
+    if (files->fileSize(fileId) > 0) {
+        std::cerr << "Error: Index file already exists: " << filePath << std::endl;
+        return false;
+    }
+    for (const IndexEntry& entry : entries) {
+        if (entry.key.size() > MAX_KEY_SIZE) {
+            std::cerr << "Error: Value of " << entry.key.size() << " bytes is too long to index" << std::endl;
+            return false;
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) { return compareEntries(a, b) < 0; });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) { return compareEntries(a, b) == 0; }),
+                  entries.end());
+
+    indexColumn = column;
+    pageCount = 0;
+    levels = 1;
+    std::vector<std::pair<IndexEntry, int>> level;
+    Node leaf;
+    int leafId = ++pageCount;
+    for (IndexEntry& entry : entries) {
+        if (!leaf.entries.empty() && nodeSize(leaf) + entrySize(entry, true) > FILL_SIZE) {
+            int next = ++pageCount;
+            leaf.link = next;
+            writeNode(leafId, leaf);
+            level.push_back({leaf.entries.front(), leafId});
+            leaf = Node();
+            leafId = next;
+        }
+        leaf.entries.push_back(std::move(entry));
+    }
+    writeNode(leafId, leaf);
+    level.push_back({leaf.entries.empty() ? IndexEntry{} : leaf.entries.front(), leafId});
+
+    while (level.size() > 1) {
+        std::vector<std::pair<IndexEntry, int>> parents;
+        Node inner;
+        inner.leaf = false;
+        inner.link = level[0].second;
+        IndexEntry first = level[0].first;
+        for (size_t i = 1; i < level.size(); i++) {
+            if (nodeSize(inner) + entrySize(level[i].first, false) > FILL_SIZE) {
+                int id = ++pageCount;
+                writeNode(id, inner);
+                parents.push_back({first, id});
+                inner = Node();
+                inner.leaf = false;
+                inner.link = level[i].second;
+                first = level[i].first;
+                continue;
+            }
+            inner.entries.push_back(level[i].first);
+            inner.children.push_back(level[i].second);
+        }
+        int id = ++pageCount;
+        writeNode(id, inner);
+        parents.push_back({first, id});
+        level.swap(parents);
+        levels++;
+    }
+    root = level[0].second;
+    writeMeta();
+    return true;
+}
+
+
+// Descends to the leaf that holds target, or to the leftmost leaf without one.
+int BPlusTree::leafFor(const IndexEntry* target, Node& leaf) {
+    int pageId = root;
+    leaf = readNode(pageId);
+    while (!leaf.leaf) {
+        size_t index = target ? childIndex(leaf, *target) : 0;
+        pageId = index == 0 ? leaf.link : leaf.children[index - 1];
+        leaf = readNode(pageId);
+    }
+    return pageId;
+}
+
+
+// Splits an overfull node in two halves by bytes and writes the right half to a new page. A
+// leaf split copies the first right entry up as separator; an inner split moves it up.
+std::pair<IndexEntry, int> BPlusTree::splitNode(Node& node) {
+    int half = nodeSize(node) / 2;
+    size_t mid = 0;
+    for (int size = HEADER_SIZE; mid + 1 < node.entries.size() && size < half; mid++) {
+        size += entrySize(node.entries[mid], node.leaf);
+    }
+    mid = std::max<size_t>(mid, 1);
+
+    Node right;
+    right.leaf = node.leaf;
+    int rightId = ++pageCount;
+    IndexEntry separator;
+    if (node.leaf) {
+        right.entries.assign(node.entries.begin() + mid, node.entries.end());
+        node.entries.resize(mid);
+        right.link = node.link;
+        node.link = rightId;
+        separator = right.entries.front();
+    } else {
+        separator = node.entries[mid];
+        right.link = node.children[mid];
+        right.entries.assign(node.entries.begin() + mid + 1, node.entries.end());
+        right.children.assign(node.children.begin() + mid + 1, node.children.end());
+        node.entries.resize(mid);
+        node.children.resize(mid);
+    }
+    writeNode(rightId, right);
+    return {separator, rightId};
+}
+
+
+void BPlusTree::insertInto(int pageId, const IndexEntry& entry, std::optional<std::pair<IndexEntry, int>>& split) {
+    Node node = readNode(pageId);
+    size_t index = childIndex(node, entry);
+    if (node.leaf) {
+        if (index > 0 && compareEntries(node.entries[index - 1], entry) == 0) {
+            return;
+        }
+        node.entries.insert(node.entries.begin() + index, entry);
+    } else {
+        std::optional<std::pair<IndexEntry, int>> childSplit;
+        insertInto(index == 0 ? node.link : node.children[index - 1], entry, childSplit);
+        if (!childSplit) {
+            return;
+        }
+        node.entries.insert(node.entries.begin() + index, childSplit->first);
+        node.children.insert(node.children.begin() + index, childSplit->second);
+    }
+    if (nodeSize(node) > PAGE_SIZE) {
+        split = splitNode(node);
+    }
+    writeNode(pageId, node);
+}
+
+
+bool BPlusTree::insert(const std::string& key, RecordId rid) {
+    if (key.size() > MAX_KEY_SIZE) {
+        std::cerr << "Error: Value of " << key.size() << " bytes is too long to index" << std::endl;
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(latch);
+    int pages = pageCount;
+    std::optional<std::pair<IndexEntry, int>> split;
+    insertInto(root, {key, rid}, split);
+    if (split) {
+        Node top;
+        top.leaf = false;
+        top.link = root;
+        top.entries.push_back(split->first);
+        top.children.push_back(split->second);
+        root = ++pageCount;
+        levels++;
+        writeNode(root, top);
+    }
+    if (pageCount != pages) {
+        writeMeta();
+    }
+    return true;
+}
+
+
+bool BPlusTree::erase(const std::string& key, RecordId rid) {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    IndexEntry target{key, rid};
+    Node leaf;
+    int pageId = leafFor(&target, leaf);
+    size_t index = childIndex(leaf, target);
+    if (index == 0 || compareEntries(leaf.entries[index - 1], target) != 0) {
+        return false;
+    }
+    leaf.entries.erase(leaf.entries.begin() + index - 1);
+    writeNode(pageId, leaf);
+    return true;
+}
+
+
+std::vector<RecordId> BPlusTree::find(const std::string& key) {
+    return range(KeyBound{key, true}, KeyBound{key, true});
+}
+
+
+// Record ids of all entries between the bounds, in key order, read leaf to leaf.
+std::vector<RecordId> BPlusTree::range(const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    std::shared_lock<std::shared_mutex> lock(latch);
+    std::vector<RecordId> result;
+    std::optional<IndexEntry> start;
+    if (low) {
+        RecordId edge = low->inclusive ? RecordId{INT_MIN, INT_MIN} : RecordId{INT_MAX, INT_MAX};
+        start = IndexEntry{low->key, edge};
+    }
+    Node leaf;
+    leafFor(start ? &*start : nullptr, leaf);
+    size_t index = start ? childIndex(leaf, *start) : 0;
+    while (true) {
+        for (; index < leaf.entries.size(); index++) {
+            const IndexEntry& entry = leaf.entries[index];
+            if (high) {
+                int c = compareKeys(entry.key, high->key);
+                if (c > 0 || (c == 0 && !high->inclusive)) {
+                    return result;
+                }
+            }
+            result.push_back(entry.rid);
+        }
+        if (leaf.link == 0) {
+            break;
+        }
+        leaf = readNode(leaf.link);
+        index = 0;
+    }
+    return result;
+}
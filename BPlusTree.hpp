@@ -0,0 +1,63 @@
+#ifndef BPLUS_TREE_HPP
+#define BPLUS_TREE_HPP
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <shared_mutex>
+#include "Index.hpp"
+
+// Ordered index, kept in <db>/<table>.<index>.BPT. Page 0 holds the root, page count, height and column name; every other
+// page is a node. Entries are ordered by (key, record id), so duplicate keys are allowed and
+// every row has exactly one entry, which delete can find. Keys that look like integers sort
+// numerically and before all other keys, which sort as strings. Deletes leave underfull nodes
+// in place; a node is never freed.
+class BPlusTree : public Index {
+public:
+    BPlusTree(BufferPool* pool, FileManager* files, const std::string& path);
+
+    bool build(const std::string& column, std::vector<IndexEntry> entries) override;
+    bool open() override;
+
+    bool insert(const std::string& key, RecordId rid) override;
+    bool erase(const std::string& key, RecordId rid) override;
+    std::vector<RecordId> find(const std::string& key) override;
+    std::vector<RecordId> range(const std::optional<KeyBound>& low, const std::optional<KeyBound>& high);
+
+    IndexKind kind() const override { return INDEX_BTREE; }
+    int height() const { return levels; }
+
+    static int compareKeys(const std::string& a, const std::string& b);
+
+private:
+    struct Node {
+        bool leaf = true;
+        int link = 0;
+        std::vector<IndexEntry> entries;
+        std::vector<int> children;
+    };
+
+    static constexpr int HEADER_SIZE = 8;
+    static constexpr int FILL_SIZE = PAGE_SIZE * 9 / 10;
+    static constexpr int MAGIC = 0x42505431;
+
+    int root = 0;
+    int pageCount = 0;
+    int levels = 0;
+    std::shared_mutex latch;
+
+    static int compareEntries(const IndexEntry& a, const IndexEntry& b);
+    static int entrySize(const IndexEntry& entry, bool leaf);
+    static int nodeSize(const Node& node);
+    static size_t childIndex(const Node& node, const IndexEntry& target);
+
+    Node readNode(int pageId);
+    void writeNode(int pageId, const Node& node);
+    bool readMeta();
+    void writeMeta();
+    int leafFor(const IndexEntry* target, Node& leaf);
+    void insertInto(int pageId, const IndexEntry& entry, std::optional<std::pair<IndexEntry, int>>& split);
+    std::pair<IndexEntry, int> splitNode(Node& node);
+};
+
+#endif
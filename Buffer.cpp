@@ -1,44 +1,145 @@
 #include "Buffer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <sys/mman.h>
 
 
-Buffer_Page::Buffer_Page(int id, PageType t) : pageId(id), type(t), referenceBit(true), dirtyBit(false), pinCount(0) {
-    std::memset(data, 0, PAGE_SIZE);  
+namespace {
+
+std::atomic<uint64_t> nextPoolId{1};
+
+// Hits reach the replacement policy in per-thread batches, so the hit path takes policyLatch
+// at most once every ACCESS_BATCH / 2 hits, and skips it while another thread holds it.
+struct AccessBatch {
+    uint64_t poolId = 0;
+    int count = 0;
+    int frames[BufferPool::ACCESS_BATCH];
+};
+
+thread_local AccessBatch accessBatch;
+
 }
 
 
-void Buffer_Page::writeToDisk() {
-    if (dirtyBit) {
-        std::ofstream file("page_" + std::to_string(pageId) + ".dat", std::ios::binary);
-        file.write(data, PAGE_SIZE);
-        file.close();
-        dirtyBit = false;  
-    }
+Buffer_Page::Buffer_Page(int frame, char* data)
+    : fileId(-1), pageId(-1), type(DATA_PAGE), frame(frame), pinCount(0), modified(0), flushed(0),
+      readPending(false), writePending(false), scanFile(-1), writeBuffer(nullptr), writeVersion(0), data(data) {}
+
+
+// Only called on an unmapped frame owned by the thread that claimed it.
+void Buffer_Page::assign(int fileId, int id, PageType t) {
+    this->fileId = fileId;
+    pageId = id;
+    type = t;
+    modified = 0;
+    flushed = 0;
+    pinCount = 0;
 }
 
 
-Buffer_Page* Buffer_Page::readFromDisk(int pageId, PageType type) {
-    Buffer_Page* page = new Buffer_Page(pageId, type);
-    std::ifstream file("page_" + std::to_string(pageId) + ".dat", std::ios::binary);
-    if (file.is_open()) {
-        file.read(page->data, PAGE_SIZE);
-        file.close();
-    }
-    return page;
+void Buffer_Page::clear() {
+    fileId = -1;
+    pageId = -1;
+    modified = 0;
+    flushed = 0;
+    pinCount = 0;
+    scanFile = -1;
 }
 
 
-BufferPool::BufferPool(int size) : bufferSize(size), clockHand(0) {
-    bufferPool.resize(bufferSize, nullptr);
+void Buffer_Page::readFromDisk(FileManager& files) {
+    files.readPage(fileId, pageId, data);
+}
+
+
+// Every frame lives in one page-aligned arena allocated up front, so a miss never allocates and
+// frames are valid O_DIRECT buffers. With hugePages the arena is taken from the hugetlb pool if
+// one is reserved, otherwise transparent huge pages are requested for it.
+BufferPool::BufferPool(FileManager* files, const PoolOptions& options)
+    : files(files), bufferSize(options.size), arena(nullptr), arenaSize(0), arenaHuge(false),
+      pageTable(new PageTableShard[PAGE_TABLE_SHARDS]),
+      policy(ReplacementPolicy::create(options.policy, options.size)), scans(new ScanRing[SCAN_SLOTS]),
+      ringCapacity(std::min(MAX_RING_SIZE, options.size / 4)), aio(AsyncIO::create(std::min(options.size, 4096), options.asyncBackend)),
+      poolId(nextPoolId++), stopping(false), cleanTarget(options.cleanTarget >= 0 ? options.cleanTarget : options.size / 4),
+      writerDelay(options.writerDelayMs), checkpointInterval(options.checkpointSeconds), checkpointing(false),
+      checkpointsCompleted(0) {
+    const size_t hugePageSize = 2 * 1024 * 1024;
+    arenaSize = static_cast<size_t>(bufferSize) * PAGE_SIZE;
+    void* memory = MAP_FAILED;
+    if (options.hugePages) {
+        size_t hugeSize = (arenaSize + hugePageSize - 1) / hugePageSize * hugePageSize;
+        memory = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            arenaSize = hugeSize;
+            arenaHuge = true;
+        }
+    }
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        if (options.hugePages) {
+            madvise(memory, arenaSize, MADV_HUGEPAGE);
+        }
+    }
+    arena = static_cast<char*>(memory);
+
+    for (int i = 0; i < bufferSize; i++) {
+        bufferPool.emplace_back(i, arena + static_cast<size_t>(i) * PAGE_SIZE);
+    }
+    for (int i = 0; i < PAGE_TABLE_SHARDS; i++) {
+        pageTable[i].frames.reserve(bufferSize / PAGE_TABLE_SHARDS + 1);
+    }
+    for (int i = bufferSize - 1; i >= 0; i--) {
+        freeFrames.push_back(i);
+    }
+
+    if (!options.tracePath.empty()) {
+        trace.open(options.tracePath, std::ios::app);
+        if (!trace) {
+            std::cerr << "Error: Could not open trace file " << options.tracePath << std::endl;
+        }
+    }
+
+    if (options.backgroundWriter) {
+        writer = std::thread(&BufferPool::backgroundWriter, this);
+    }
 }
 
 
 BufferPool::~BufferPool() {
-    
-    for (Buffer_Page* page : bufferPool) {
-        if (page) {
-            page->writeToDisk();
-            delete page;
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(writerLatch);
+            stopping = true;
         }
+        writerWake.notify_all();
+        writer.join();
+    }
+    flushAll();
+    for (char* buffer : writeBuffers) {
+        std::free(buffer);
+    }
+    munmap(arena, arenaSize);
+}
+
+
+bool BufferPool::usesHugePages() const {
+    return arenaHuge;
+}
+
+
+const char* BufferPool::policyName() const {
+    return policy->name();
+}
+
+
+// One "fileId pageId" line per page access, the input format of ./bench policy.
+void BufferPool::recordAccess(const PageKey& key) {
+    if (trace.is_open()) {
+        std::lock_guard<std::mutex> lock(traceLatch);
+        trace << key.fileId << ' ' << key.pageId << '\n';
     }
 }
 
@@ -49,81 +150,741 @@ int BufferPool::getNewPageId() {
 }
 
 
-Buffer_Page* BufferPool::requestPage(int pageId, PageType type, bool isWrite) {
-    if (pageTable.find(pageId) != pageTable.end()) {
-        
-        Buffer_Page* page = pageTable[pageId];
-        page->referenceBit = true;
-        page->pinCount++;
-        return page;
+const char* BufferPool::ioBackendName() const {
+    return aio->name();
+}
+
+
+PageTableShard& BufferPool::shardFor(const PageKey& key) {
+    return pageTable[(PageKeyHash()(key) >> 32) % PAGE_TABLE_SHARDS];
+}
+
+
+// Pins are only taken under the shard lock, and a frame is only unmapped under that lock while
+// it has no pins, so a page pinned here stays put until it is released.
+Buffer_Page* BufferPool::pinResident(const PageKey& key) {
+    PageTableShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.frames.find(key);
+    if (it == shard.frames.end()) {
+        return nullptr;
+    }
+    Buffer_Page* page = &bufferPool[it->second];
+    page->pinCount++;
+    return page;
+}
+
+
+// Pins whatever page the frame holds right now, or returns nullptr if it holds none.
+Buffer_Page* BufferPool::pinFrame(int frame) {
+    Buffer_Page* page = &bufferPool[frame];
+    PageKey key = page->key();
+    if (key.pageId < 0) {
+        return nullptr;
+    }
+    PageTableShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.frames.find(key);
+    if (it == shard.frames.end() || it->second != frame) {
+        return nullptr;
+    }
+    page->pinCount++;
+    return page;
+}
+
+
+int BufferPool::residentFrame(const PageKey& key) {
+    PageTableShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.frames.find(key);
+    return it == shard.frames.end() ? -1 : it->second;
+}
+
+
+Buffer_Page* BufferPool::requestPage(int fileId, int pageId, PageType type, bool isWrite) {
+    PageKey key{fileId, pageId};
+    recordAccess(key);
+    ScanRing* scan = isWrite ? nullptr : trackScan(fileId, pageId);
+
+    Buffer_Page* page = pinResident(key);
+    if (page != nullptr) {
+        waitForFrame(page);
+        noteAccess(page);
     } else {
-        
-        return replacePage(pageId, type, isWrite);
+        page = loadPage(key, type, scan);
+    }
+    if (page == nullptr) {
+        return nullptr;
+    }
+    if (isWrite) {
+        page->markDirty();
+    }
+    if (scan) {
+        readAhead(*scan, pageId, type);
+    }
+    return page;
+}
+
+
+// Pins the page only if it is already resident; never does I/O.
+Buffer_Page* BufferPool::findPage(int fileId, int pageId) {
+    recordAccess({fileId, pageId});
+    Buffer_Page* page = pinResident({fileId, pageId});
+    if (page == nullptr) {
+        return nullptr;
     }
+    waitForFrame(page);
+    noteAccess(page);
+    return page;
 }
 
 
-void BufferPool::releasePage(int pageId) {
-    if (pageTable.find(pageId) != pageTable.end()) {
-        Buffer_Page* page = pageTable[pageId];
-        page->pinCount = std::max(0, page->pinCount - 1);  
+void BufferPool::releasePage(int fileId, int pageId, bool isDirty) {
+    PageKey key{fileId, pageId};
+    PageTableShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.frames.find(key);
+    if (it != shard.frames.end()) {
+        releasePage(&bufferPool[it->second], isDirty);
     }
 }
 
 
-Buffer_Page* BufferPool::replacePage(int pageId, PageType type, bool isWrite) {
-    while (true) {
-        Buffer_Page* page = bufferPool[clockHand];
+void BufferPool::releasePage(Buffer_Page* page, bool isDirty) {
+    if (isDirty) {
+        page->markDirty();
+    }
+    int pins = page->pinCount.load();
+    while (pins > 0 && !page->pinCount.compare_exchange_weak(pins, pins - 1)) {
+    }
+}
+
+
+// The frame is claimed and mapped with readPending set before the read starts, so the disk
+// read runs without any pool lock held; other threads asking for the page wait on the frame.
+Buffer_Page* BufferPool::loadPage(const PageKey& key, PageType type, ScanRing* scan) {
+    int frame = takeFrame(key, scan, true);
+    if (frame < 0) {
+        std::cerr << "Error: All " << bufferSize << " buffer frames are pinned" << std::endl;
+        return nullptr;
+    }
+    Buffer_Page* page = &bufferPool[frame];
+
+    PageTableShard& shard = shardFor(key);
+    {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto it = shard.frames.find(key);
+        if (it != shard.frames.end()) {
+            Buffer_Page* other = &bufferPool[it->second];
+            other->pinCount++;
+            lock.unlock();
+            returnFrame(frame);
+            waitForFrame(other);
+            noteAccess(other);
+            return other;
+        }
+        page->assign(key.fileId, key.pageId, type);
+        page->readPending = true;
+        page->pinCount = 1;
+        shard.frames[key] = frame;
+    }
+    {
+        std::lock_guard<std::mutex> lock(policyLatch);
+        policy->loaded(frame, key);
+    }
+
+    page->readFromDisk(*files);
+    page->readPending = false;
+    return page;
+}
+
+
+void BufferPool::returnFrame(int frame) {
+    std::lock_guard<std::mutex> lock(policyLatch);
+    bufferPool[frame].clear();
+    freeFrames.push_back(frame);
+}
+
+
+void BufferPool::noteAccess(Buffer_Page* page) {
+    if (page->scanFile.load() >= 0) {
+        return;
+    }
+    AccessBatch& batch = accessBatch;
+    if (batch.poolId != poolId) {
+        batch.poolId = poolId;
+        batch.count = 0;
+    }
+    batch.frames[batch.count++] = page->frame;
+    if (batch.count >= ACCESS_BATCH / 2) {
+        flushAccesses(batch.count == ACCESS_BATCH);
+    }
+}
+
+
+// A batched frame may have been evicted since; the policies ignore frames they do not hold.
+void BufferPool::flushAccesses(bool force) {
+    AccessBatch& batch = accessBatch;
+    std::unique_lock<std::mutex> lock(policyLatch, std::defer_lock);
+    if (force) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+    for (int i = 0; i < batch.count; i++) {
+        policy->accessed(batch.frames[i]);
+    }
+    batch.count = 0;
+}
+
+
+void BufferPool::flushPage(int fileId, int pageId) {
+    int frame = residentFrame({fileId, pageId});
+    if (frame < 0) {
+        return;
+    }
+    Buffer_Page* page = &bufferPool[frame];
+    waitForFrame(page);
+    scheduleWrite(page);
+    aio->submit();
+    waitForFrame(page);
+}
+
+
+// All dirty frames of the file go to the kernel as one batch.
+void BufferPool::flushFile(int fileId) {
+    for (Buffer_Page& page : bufferPool) {
+        if (page.fileId.load() == fileId && page.isDirty()) {
+            scheduleWrite(&page);
+        }
+    }
+    waitForAll();
+}
+
+
+void BufferPool::flushAll() {
+    for (Buffer_Page& page : bufferPool) {
+        if (page.inUse() && page.isDirty()) {
+            scheduleWrite(&page);
+        }
+    }
+    waitForAll();
+}
+
+
+// Queues a write-back of a resident page from a copy taken under the frame's shared latch.
+// Skipped if the page is clean, already being written, or latched exclusively by a writer;
+// it then stays dirty and is picked up later.
+bool BufferPool::scheduleWrite(Buffer_Page* page) {
+    if (pinFrame(page->frame) != page) {
+        return false;
+    }
+    bool scheduled = false;
+    bool expected = false;
+    if (page->isDirty() && !page->readPending.load() && page->writePending.compare_exchange_strong(expected, true)) {
+        std::shared_lock<std::shared_mutex> content(page->latch, std::try_to_lock);
+        if (content.owns_lock()) {
+            writeCopy(page);
+            scheduled = true;
+        } else {
+            page->writePending = false;
+        }
+    }
+    releasePage(page);
+    return scheduled;
+}
+
+
+// The caller owns the frame's write: it either won writePending or holds the shard lock of an
+// unpinned frame. Completion marks the copied version clean; later changes stay dirty.
+void BufferPool::writeCopy(Buffer_Page* page) {
+    char* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(writeBufferLatch);
+        if (!writeBuffers.empty()) {
+            buffer = writeBuffers.back();
+            writeBuffers.pop_back();
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = static_cast<char*>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+        if (buffer == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    page->writeVersion = page->modified.load();
+    std::memcpy(buffer, page->data, PAGE_SIZE);
+    page->writeBuffer = buffer;
+    page->writePending = true;
+    aio->prepare({files->fd(page->fileId), buffer, PAGE_SIZE,
+                  static_cast<off_t>(page->pageId) * PAGE_SIZE, true, static_cast<uint64_t>(page->frame)});
+}
+
 
-        if (page == nullptr || (page->pinCount == 0 && !page->referenceBit)) {
-            
-            if (page != nullptr) {
-                if (page->dirtyBit) {
-                    page->writeToDisk();
+void BufferPool::completeIO(const std::vector<IoCompletion>& completions) {
+    for (const IoCompletion& completion : completions) {
+        Buffer_Page* page = &bufferPool[completion.tag];
+        if (page->writePending.load()) {
+            if (completion.result == PAGE_SIZE) {
+                uint64_t clean = page->flushed.load();
+                while (clean < page->writeVersion && !page->flushed.compare_exchange_weak(clean, page->writeVersion)) {
                 }
-                pageTable.erase(page->pageId);
-                delete page;
+                files->extend(page->fileId, static_cast<off_t>(page->pageId + 1) * PAGE_SIZE);
+            } else {
+                std::cerr << "Error: Could not write page " << page->pageId << " to file: " << files->path(page->fileId) << std::endl;
             }
+            {
+                std::lock_guard<std::mutex> lock(writeBufferLatch);
+                writeBuffers.push_back(page->writeBuffer);
+            }
+            page->writeBuffer = nullptr;
+            page->writePending = false;
+        } else if (page->readPending.load()) {
+            if (completion.result < 0) {
+                std::cerr << "Error: Could not read page " << page->pageId << " from file: " << files->path(page->fileId) << std::endl;
+                std::memset(page->data, 0, PAGE_SIZE);
+            } else if (completion.result < PAGE_SIZE) {
+                std::memset(page->data + completion.result, 0, PAGE_SIZE - completion.result);
+            }
+            page->readPending = false;
+        }
+    }
+}
+
+
+void BufferPool::pollIO() {
+    reapIO();
+}
+
+
+void BufferPool::reapIO() {
+    if (aio->inFlight() == 0) {
+        return;
+    }
+    std::vector<IoCompletion> completions;
+    aio->poll(completions);
+    completeIO(completions);
+}
+
+
+// Demand reads run synchronously in the thread that claimed the frame, so with nothing in
+// flight in the async queue this is a short yield loop.
+void BufferPool::waitForFrame(Buffer_Page* page) {
+    while (page->ioPending()) {
+        if (aio->inFlight() > 0) {
+            std::vector<IoCompletion> completions;
+            aio->wait(completions, 1);
+            completeIO(completions);
+        }
+        if (page->ioPending()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void BufferPool::waitForAll() {
+    aio->submit();
+    for (Buffer_Page& page : bufferPool) {
+        waitForFrame(&page);
+    }
+}
+
+
+// Trying the slot lock keeps the hit path free of shared locks; when two threads scan through
+// the same slot at once, the one that loses is simply not tracked.
+ScanRing* BufferPool::trackScan(int fileId, int pageId) {
+    if (ringCapacity < 2) {
+        return nullptr;
+    }
+    ScanRing& scan = scans[static_cast<unsigned>(fileId) % SCAN_SLOTS];
+    std::unique_lock<std::mutex> lock(scan.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return nullptr;
+    }
+    if (scan.fileId != fileId) {
+        releaseRing(scan);
+        scan.fileId = fileId;
+        scan.lastPage = -1;
+        scan.length = 0;
+    }
+    if (pageId == scan.lastPage + 1) {
+        scan.length++;
+    } else if (pageId != scan.lastPage) {
+        releaseRing(scan);
+        scan.length = 1;
+    }
+    scan.lastPage = pageId;
+    return scan.length >= SEQUENTIAL_RUN ? &scan : nullptr;
+}
+
+
+// Called with the slot lock held.
+void BufferPool::releaseRing(ScanRing& scan) {
+    for (int frame : scan.frames) {
+        int owner = scan.fileId;
+        bufferPool[frame].scanFile.compare_exchange_strong(owner, -1);
+    }
+    scan.frames.clear();
+    scan.readAheadEnd = 0;
+}
+
+
+// Keeps half a ring of pages ahead of the scan, issued in batches of a quarter ring.
+void BufferPool::readAhead(ScanRing& scan, int pageId, PageType type) {
+    std::vector<int> pageIds;
+    int fileId;
+    {
+        std::lock_guard<std::mutex> lock(scan.mutex);
+        fileId = scan.fileId;
+        int window = ringCapacity / 2;
+        int from = std::max(scan.readAheadEnd, pageId + 1);
+        int to = pageId + window;
+        if (to - from + 1 < std::max(window / 2, 1)) {
+            return;
+        }
+        for (int id = from; id <= to; id++) {
+            pageIds.push_back(id);
+        }
+        scan.readAheadEnd = to + 1;
+    }
+    prefetchInto(fileId, pageIds, type, &scan);
+}
 
-            
-            Buffer_Page* newPage = Buffer_Page::readFromDisk(pageId, type);
-            newPage->pinCount++;
-            if (isWrite) {
-                newPage->dirtyBit = true;
+
+// Reads pages into free or clean frames without waiting for them. A later requestPage on one
+// of them only blocks if its read has not completed yet.
+void BufferPool::prefetch(int fileId, const std::vector<int>& pageIds, PageType type) {
+    prefetchInto(fileId, pageIds, type, nullptr);
+}
+
+
+void BufferPool::prefetchInto(int fileId, const std::vector<int>& pageIds, PageType type, ScanRing* scan) {
+    for (int pageId : pageIds) {
+        PageKey key{fileId, pageId};
+        if (residentFrame(key) >= 0 || static_cast<off_t>(pageId + 1) * PAGE_SIZE > files->fileSize(fileId)) {
+            continue;
+        }
+        int frame = takeFrame(key, scan, false);
+        if (frame < 0) {
+            break;
+        }
+
+        Buffer_Page* page = &bufferPool[frame];
+        PageTableShard& shard = shardFor(key);
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            if (shard.frames.count(key)) {
+                lock.unlock();
+                returnFrame(frame);
+                continue;
             }
+            page->assign(fileId, pageId, type);
+            page->readPending = true;
+            shard.frames[key] = frame;
+        }
+        {
+            std::lock_guard<std::mutex> lock(policyLatch);
+            policy->loaded(frame, key);
+        }
+        aio->prepare({files->fd(fileId), page->data, PAGE_SIZE,
+                      static_cast<off_t>(pageId) * PAGE_SIZE, false, static_cast<uint64_t>(frame)});
+    }
+    aio->submit();
+}
+
+
+// Called with policyLatch held. Empty frames are used first; otherwise the policy proposes
+// frames until one can be claimed.
+int BufferPool::findVictim(const PageKey& incoming) {
+    if (!freeFrames.empty()) {
+        int frame = freeFrames.back();
+        freeFrames.pop_back();
+        return frame;
+    }
+    int frame = policy->victim(incoming, [this](int frame) { return claim(frame); });
+    if (frame >= 0) {
+        policy->evicted(frame);
+    }
+    return frame;
+}
+
+
+// Unmaps an unpinned, clean frame with no I/O pending and empties it; the caller then tells the
+// policy. A dirty candidate gets an asynchronous write-back queued instead, so a miss never
+// writes on the spot.
+bool BufferPool::claim(int frame) {
+    Buffer_Page* page = &bufferPool[frame];
+    if (page->pinCount.load() > 0 || page->ioPending()) {
+        return false;
+    }
+    PageKey key = page->key();
+    if (key.pageId < 0) {
+        return false;
+    }
+    PageTableShard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.frames.find(key);
+    if (it == shard.frames.end() || it->second != frame || page->pinCount.load() > 0 || page->ioPending()) {
+        return false;
+    }
+    if (page->isDirty()) {
+        writeCopy(page);
+        return false;
+    }
+    shard.frames.erase(it);
+    page->clear();
+    return true;
+}
 
-            
-            bufferPool[clockHand] = newPage;
-            pageTable[pageId] = newPage;
-
-            
-            clockHand = (clockHand + 1) % bufferSize;
-            return newPage;
-        } else if (page->pinCount == 0 && page->referenceBit) {
-            
-            page->referenceBit = false;
-            clockHand = (clockHand + 1) % bufferSize;
+
+// Returns an emptied frame for the incoming page. A scan first recycles its own oldest ring
+// frame, then grows the ring to ringCapacity frames taken from the pool; when every ring frame
+// is busy it borrows a frame from the policy without adding it to the ring. Lock order is slot,
+// policyLatch, shard. If nothing can be claimed, the queued write-backs are waited for with
+// only the slot lock held, and -1 means every frame stayed pinned.
+int BufferPool::takeFrame(const PageKey& incoming, ScanRing* scan, bool mayWait) {
+    std::unique_lock<std::mutex> ringLock;
+    if (scan) {
+        ringLock = std::unique_lock<std::mutex>(scan->mutex);
+        if (scan->fileId != incoming.fileId) {
+            ringLock.unlock();
+            scan = nullptr;
+        }
+    }
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(policyLatch);
+            int frame = -1;
+            bool inRing = false;
+            if (scan) {
+                size_t count = scan->frames.size();
+                for (size_t i = 0; i < count && frame < 0; i++) {
+                    int candidate = scan->frames.front();
+                    scan->frames.pop_front();
+                    if (bufferPool[candidate].scanFile.load() != scan->fileId) {
+                        continue;
+                    }
+                    scan->frames.push_back(candidate);
+                    if (claim(candidate)) {
+                        policy->evicted(candidate);
+                        frame = candidate;
+                        inRing = true;
+                    }
+                }
+            }
+            if (frame < 0) {
+                frame = findVictim(incoming);
+                if (frame >= 0 && scan && static_cast<int>(scan->frames.size()) < ringCapacity) {
+                    scan->frames.push_back(frame);
+                    inRing = true;
+                }
+            }
+            if (frame >= 0) {
+                if (inRing) {
+                    bufferPool[frame].scanFile = scan->fileId;
+                }
+                return frame;
+            }
+        }
+
+        writerWake.notify_one();
+        aio->submit();
+        if (!mayWait) {
+            return -1;
+        }
+        if (aio->inFlight() == 0) {
+            // Other threads may have reaped the write-backs, or briefly hold the frames.
+            bool unpinned = std::any_of(bufferPool.begin(), bufferPool.end(),
+                                        [](const Buffer_Page& page) { return page.pinCount.load() == 0; });
+            if (!unpinned) {
+                return -1;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        std::vector<IoCompletion> completions;
+        aio->wait(completions, 1);
+        completeIO(completions);
+    }
+}
+
+
+int BufferPool::checkpoints() const {
+    std::lock_guard<std::mutex> lock(writerLatch);
+    return checkpointsCompleted;
+}
+
+
+// Starts an incremental checkpoint, or waits out the one running and starts a new one, and
+// optionally waits for it. Without a background writer the checkpoint is a flush and sync.
+void BufferPool::checkpoint(bool wait) {
+    if (!writer.joinable()) {
+        std::vector<int> fileIds;
+        for (Buffer_Page& page : bufferPool) {
+            int fileId = page.fileId.load();
+            if (page.inUse() && page.isDirty() && scheduleWrite(&page)
+                && std::find(fileIds.begin(), fileIds.end(), fileId) == fileIds.end()) {
+                fileIds.push_back(fileId);
+            }
+        }
+        waitForAll();
+        for (int fileId : fileIds) {
+            files->sync(fileId);
+        }
+        std::lock_guard<std::mutex> lock(writerLatch);
+        checkpointsCompleted++;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(writerLatch);
+    checkpointDone.wait(lock, [&] { return !checkpointing || stopping; });
+    int target = checkpointsCompleted + 1;
+    beginCheckpoint();
+    writerWake.notify_one();
+    if (wait) {
+        checkpointDone.wait(lock, [&] { return checkpointsCompleted >= target || stopping; });
+    }
+}
+
+
+// Wakes every writerDelay to reap finished writes, keep cleanTarget frames clean and advance
+// the current checkpoint. It only queues asynchronous writes of page copies, and drops
+// writerLatch for the fdatasync at the end of a checkpoint.
+void BufferPool::backgroundWriter() {
+    std::unique_lock<std::mutex> lock(writerLatch);
+    auto nextCheckpoint = std::chrono::steady_clock::now() + checkpointInterval;
+    while (!stopping) {
+        writerWake.wait_for(lock, writerDelay);
+        if (stopping) {
+            break;
+        }
+        reapIO();
+        if (checkpointInterval.count() > 0 && std::chrono::steady_clock::now() >= nextCheckpoint) {
+            beginCheckpoint();
+            nextCheckpoint = std::chrono::steady_clock::now() + checkpointInterval;
+        }
+        writeBehind();
+        if (checkpointing) {
+            stepCheckpoint(lock);
+        }
+        aio->submit();
+    }
+    checkpointDone.notify_all();
+}
+
+
+// Cleans the lowest page ids first, so the writes reach the disk in file order.
+void BufferPool::writeBehind() {
+    int ready = 0;
+    {
+        std::lock_guard<std::mutex> lock(policyLatch);
+        ready = static_cast<int>(freeFrames.size());
+    }
+    std::vector<std::pair<PageKey, Buffer_Page*>> dirty;
+    for (Buffer_Page& page : bufferPool) {
+        if (!page.inUse() || page.pinCount.load() > 0 || page.ioPending()) {
+            continue;
+        }
+        if (page.isDirty()) {
+            dirty.push_back({page.key(), &page});
         } else {
-            
-            clockHand = (clockHand + 1) % bufferSize;
+            ready++;
+        }
+    }
+    if (ready >= cleanTarget || dirty.empty()) {
+        return;
+    }
+    std::sort(dirty.begin(), dirty.end(), [](const auto& a, const auto& b) {
+        return a.first.fileId != b.first.fileId ? a.first.fileId < b.first.fileId : a.first.pageId < b.first.pageId;
+    });
+    size_t count = std::min<size_t>({dirty.size(), static_cast<size_t>(cleanTarget - ready), static_cast<size_t>(WRITER_BATCH)});
+    for (size_t i = 0; i < count; i++) {
+        scheduleWrite(dirty[i].second);
+    }
+}
+
+
+// Snapshots the pages dirty right now; stepCheckpoint writes them CHECKPOINT_BATCH at a time.
+void BufferPool::beginCheckpoint() {
+    if (checkpointing) {
+        return;
+    }
+    std::vector<PageKey> dirty;
+    for (const Buffer_Page& page : bufferPool) {
+        if (page.inUse() && (page.isDirty() || page.writePending.load())) {
+            dirty.push_back(page.key());
         }
     }
+    std::sort(dirty.begin(), dirty.end(), [](const PageKey& a, const PageKey& b) {
+        return a.fileId != b.fileId ? a.fileId < b.fileId : a.pageId < b.pageId;
+    });
+    checkpointQueue.clear();
+    for (const PageKey& key : dirty) {
+        checkpointQueue.push_back({key, false});
+    }
+    checkpointFiles.clear();
+    checkpointing = true;
 }
 
 
-void BufferPool::displayBufferPool() const {
-    std::cout << "Buffer Pool State:\n";
-    for (size_t i = 0; i < bufferPool.size(); i++) {
-        const Buffer_Page* page = bufferPool[i];
-        if (page) {
-            std::cout << "Page ID: " << page->pageId 
-                      << ", Type: " << (page->type == INDEX_PAGE ? "INDEX" : "DATA")
-                      << ", Pin Count: " << page->pinCount 
-                      << ", Dirty: " << page->dirtyBit 
-                      << ", Reference: " << page->referenceBit 
+// A page leaves the queue once one write of it has completed, even if it was dirtied again
+// since; pinned pages are retried on later rounds.
+void BufferPool::stepCheckpoint(std::unique_lock<std::mutex>& lock) {
+    size_t batch = std::min<size_t>(checkpointQueue.size(), CHECKPOINT_BATCH);
+    for (size_t i = 0; i < batch; i++) {
+        auto [key, written] = checkpointQueue.front();
+        checkpointQueue.pop_front();
+        int frame = residentFrame(key);
+        if (frame < 0) {
+            continue;
+        }
+        Buffer_Page* page = &bufferPool[frame];
+        if (page->writePending.load()) {
+            checkpointQueue.push_back({key, written});
+            continue;
+        }
+        if (!written && page->isDirty()) {
+            if (page->pinCount.load() == 0 && scheduleWrite(page)) {
+                written = true;
+            }
+            checkpointQueue.push_back({key, written});
+        }
+        if (std::find(checkpointFiles.begin(), checkpointFiles.end(), key.fileId) == checkpointFiles.end()) {
+            checkpointFiles.push_back(key.fileId);
+        }
+    }
+    if (!checkpointQueue.empty()) {
+        return;
+    }
+
+    std::vector<int> fileIds = checkpointFiles;
+    lock.unlock();
+    for (int fileId : fileIds) {
+        files->sync(fileId);
+    }
+    lock.lock();
+    checkpointing = false;
+    checkpointsCompleted++;
+    checkpointDone.notify_all();
+}
+
+
+void BufferPool::displayBufferPool() {
+    std::cout << "Buffer Pool State (" << policy->name() << ", " << aio->name() << ", " << aio->inFlight() << " I/Os in flight"
+              << (arenaHuge ? ", huge pages" : "") << "):\n";
+    for (const Buffer_Page& page : bufferPool) {
+        PageKey key = page.key();
+        if (key.pageId >= 0) {
+            std::cout << "File: " << files->path(key.fileId)
+                      << ", Page ID: " << key.pageId
+                      << ", Type: " << (page.type == INDEX_PAGE ? "INDEX" : "DATA")
+                      << ", Pin Count: " << page.pinCount.load()
+                      << ", Dirty: " << page.isDirty()
+                      << (page.readPending.load() ? ", Reading" : "")
+                      << (page.writePending.load() ? ", Writing" : "")
                       << "\n";
         } else {
             std::cout << "Empty Slot\n";
         }
     }
-}
\ No newline at end of file
+}
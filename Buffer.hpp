@@ -3,12 +3,26 @@
 
 #include <iomanip>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include "FileManager.hpp"
+#include "AsyncIO.hpp"
+#include "ReplacementPolicy.hpp"
 
-#define PAGE_SIZE 4096  
+#define PAGE_SIZE 4096
+
+#define DEFAULT_POOL_SIZE 64
 
 
 enum PageType {
@@ -17,55 +31,187 @@ enum PageType {
 };
 
 
+struct PoolOptions {
+    int size = DEFAULT_POOL_SIZE;
+    AsyncBackend asyncBackend = ASYNC_URING;
+    bool hugePages = false;
+    ReplacementKind policy = POLICY_CLOCK;
+    std::string tracePath;
+    bool backgroundWriter = true;
+    int writerDelayMs = 20;
+    int cleanTarget = -1;
+    int checkpointSeconds = 30;
+};
+
+
 class Buffer_Page {
 public:
-    int pageId;             
-    PageType type;          
-    bool referenceBit;      
-    bool dirtyBit;          
-    int pinCount;           
-    char data[PAGE_SIZE];   
+    std::atomic<int> fileId;
+    std::atomic<int> pageId;
+    PageType type;
+    int frame;
+    std::atomic<int> pinCount;
+    std::atomic<uint64_t> modified;
+    std::atomic<uint64_t> flushed;
+    std::atomic<bool> readPending;
+    std::atomic<bool> writePending;
+    std::atomic<int> scanFile;
+    char* writeBuffer;
+    uint64_t writeVersion;
+    std::shared_mutex latch;
+    char* data;
+
+
+    Buffer_Page(int frame, char* data);
+
+
+    bool inUse() const { return pageId.load() >= 0; }
+    bool isDirty() const { return modified.load() != flushed.load(); }
+    bool ioPending() const { return readPending.load() || writePending.load(); }
+    void markDirty() { modified.fetch_add(1); }
+    PageKey key() const { return {fileId.load(), pageId.load()}; }
+    void assign(int fileId, int id, PageType t);
+    void clear();
+
+
+    void readFromDisk(FileManager& files);
+};
 
-    
-    Buffer_Page(int id, PageType t);
 
-    
-    void writeToDisk();
+// Frames lent to one sequential scan. Once a file has been read page after page
+// SEQUENTIAL_RUN times, its next pages are prefetched and land in this small ring, which is
+// recycled oldest first, so a scan never pushes the rest of the pool out. Rings live in a
+// small table of slots hashed by file id, each with its own lock.
+struct ScanRing {
+    std::mutex mutex;
+    int fileId = -1;
+    int lastPage = -1;
+    int length = 0;
+    int readAheadEnd = 0;
+    std::deque<int> frames;
+};
 
-    
-    static Buffer_Page* readFromDisk(int pageId, PageType type);
+
+struct PageTableShard {
+    std::mutex mutex;
+    std::unordered_map<PageKey, int, PageKeyHash> frames;
 };
 
 
+// Thread-safe pool of page frames. A page is located through one of PAGE_TABLE_SHARDS
+// independently locked hash maps and pinned there with an atomic increment, so hits on
+// different pages never share a lock. Page contents are guarded by the frame's reader/writer
+// latch, which callers take after pinning. Replacement (free list, policy, scan rings) runs
+// under policyLatch, but no lock of the pool is held while a page is read or written:
+// demand reads happen after the frame is claimed, and write-backs go out from a private copy.
 class BufferPool {
 private:
+    FileManager* files;
     int bufferSize;
-    std::vector<Buffer_Page*> bufferPool;  
-    std::unordered_map<int, Buffer_Page*> pageTable;  
-    int clockHand;  
+    char* arena;
+    size_t arenaSize;
+    bool arenaHuge;
+    std::deque<Buffer_Page> bufferPool;
+    std::unique_ptr<PageTableShard[]> pageTable;
+    std::mutex policyLatch;
+    std::vector<int> freeFrames;
+    std::unique_ptr<ReplacementPolicy> policy;
+    std::unique_ptr<ScanRing[]> scans;
+    int ringCapacity;
+    std::mutex traceLatch;
+    std::ofstream trace;
+    std::unique_ptr<AsyncIO> aio;
+    std::mutex writeBufferLatch;
+    std::vector<char*> writeBuffers;
+    uint64_t poolId;
+
+    mutable std::mutex writerLatch;
+    std::condition_variable writerWake;
+    std::condition_variable checkpointDone;
+    std::thread writer;
+    bool stopping;
+    int cleanTarget;
+    std::chrono::milliseconds writerDelay;
+    std::chrono::seconds checkpointInterval;
+    bool checkpointing;
+    std::deque<std::pair<PageKey, bool>> checkpointQueue;
+    std::vector<int> checkpointFiles;
+    int checkpointsCompleted;
 
 public:
-    
-    BufferPool(int size);
 
-    
+    BufferPool(FileManager* files, const PoolOptions& options = PoolOptions());
+
+
     ~BufferPool();
 
-    
-    Buffer_Page* requestPage(int pageId, PageType type, bool isWrite = false);
 
-    
-    void releasePage(int pageId);
+    Buffer_Page* requestPage(int fileId, int pageId, PageType type, bool isWrite = false);
+
+
+    Buffer_Page* findPage(int fileId, int pageId);
+
+
+    void releasePage(int fileId, int pageId, bool isDirty = false);
+    void releasePage(Buffer_Page* page, bool isDirty = false);
+
+
+    void flushPage(int fileId, int pageId);
+    void flushFile(int fileId);
+    void flushAll();
+
+
+    static constexpr int PAGE_TABLE_SHARDS = 64;
+    static constexpr int SCAN_SLOTS = 16;
+    static constexpr int SEQUENTIAL_RUN = 4;
+    static constexpr int MAX_RING_SIZE = 32;
+    static constexpr int WRITER_BATCH = 64;
+    static constexpr int CHECKPOINT_BATCH = 32;
+    static constexpr int ACCESS_BATCH = 32;
+
+
+    void prefetch(int fileId, const std::vector<int>& pageIds, PageType type = DATA_PAGE);
+    void pollIO();
+    void checkpoint(bool wait = true);
+    int checkpoints() const;
+    const char* ioBackendName() const;
+    bool usesHugePages() const;
+    const char* policyName() const;
+
+
+    void displayBufferPool();
 
-    
-    void displayBufferPool() const;
 
-    
     int getNewPageId();
 
 private:
-    
-    Buffer_Page* replacePage(int pageId, PageType type, bool isWrite);
+
+    PageTableShard& shardFor(const PageKey& key);
+    Buffer_Page* pinResident(const PageKey& key);
+    Buffer_Page* pinFrame(int frame);
+    Buffer_Page* loadPage(const PageKey& key, PageType type, ScanRing* scan);
+    int residentFrame(const PageKey& key);
+    int findVictim(const PageKey& incoming);
+    int takeFrame(const PageKey& incoming, ScanRing* scan, bool mayWait);
+    bool claim(int frame);
+    void returnFrame(int frame);
+    void noteAccess(Buffer_Page* page);
+    void flushAccesses(bool force);
+    ScanRing* trackScan(int fileId, int pageId);
+    void releaseRing(ScanRing& scan);
+    void readAhead(ScanRing& scan, int pageId, PageType type);
+    void prefetchInto(int fileId, const std::vector<int>& pageIds, PageType type, ScanRing* scan);
+    void recordAccess(const PageKey& key);
+    bool scheduleWrite(Buffer_Page* page);
+    void writeCopy(Buffer_Page* page);
+    void completeIO(const std::vector<IoCompletion>& completions);
+    void waitForFrame(Buffer_Page* page);
+    void waitForAll();
+    void reapIO();
+    void backgroundWriter();
+    void writeBehind();
+    void beginCheckpoint();
+    void stepCheckpoint(std::unique_lock<std::mutex>& lock);
 };
 
-#endif 
\ No newline at end of file
+#endif
\ No newline at end of file
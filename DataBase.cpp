@@ -2,7 +2,18 @@
 #include "DataBase.hpp"
 #include <iostream>
 #include <arpa/inet.h> 
-DataBase::DataBase(const std::string& name) : dbname(name) {}
+// direct_io opens table files with O_DIRECT and backs the pool with huge pages, so pages are
+// cached once, in the pool, instead of also in the kernel page cache.
+DataBase::DataBase(const std::string& name, int pool_size, IoBackend backend, bool direct_io)
+    : DataBase(name, PoolOptions{pool_size, ASYNC_URING, direct_io, POLICY_CLOCK, ""}, backend, direct_io) {}
+
+
+DataBase::DataBase(const std::string& name, const PoolOptions& pool_options, IoBackend backend, bool direct_io)
+    : dbname(name), backend(backend), direct_io(direct_io), files(std::make_unique<FileManager>()) {
+    PoolOptions options = pool_options;
+    options.hugePages = options.hugePages || direct_io;
+    pool = std::make_unique<BufferPool>(files.get(), options);
+}
 
 bool DataBase::createDatabase() {
     if (fs::create_directory(dbname)) {
@@ -30,12 +41,7 @@ bool DataBase::createTable(const std::string& tableName, const std::map<std::str
     }
     uint32_t size;
 
-    serializeSchema(schema,dbname,tableName,size,0);
-    Table* table= new Table(tableName);
-    table->schema = schema;
-    table->size = size;
-    
-    return true;
+    return serializeSchema(schema,dbname,tableName,size,0);
 }
 
 bool DataBase::deleteTable(const std::string& tableName) {
@@ -66,14 +72,18 @@ bool DataBase::deleteTable(const std::string& tableName) {
     }
 }
 
+// Tables are read from disk once and then served from the cache.
 Table* DataBase::getTable(const std::string tableName ) {
+    auto it = tables.find(tableName);
+    if (it != tables.end()) {
+        return it->second.get();
+    }
     if (tableExists(tableName)) {
         
         Table* my = deserializeSchema(dbname,tableName);
-        
-          for (const auto& [key, value] : my->schema) {
-        
-    }
+        my->file_id = files->openFile(my->filePath(), direct_io);
+        my->loadDirectory();
+        tables[tableName].reset(my);
         return my;
     }
     std::cerr << "Table not found: " << tableName << std::endl;
@@ -185,8 +195,11 @@ Table* DataBase::deserializeSchema(const std::string& dbName, const std::string&
         schema[key] = value;
     }
 
-    Table* table = new Table(fileName);
+    Table* table = new Table(fileName, dbName);
     table->page_count = page_count;
+    table->pool = pool.get();
+    table->files = files.get();
+    table->backend = backend;
     table->schema = schema;
     table->size = size;
     inFile.close();
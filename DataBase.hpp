@@ -7,21 +7,29 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <memory>
 #include "page.hpp"
 #include "Table.hpp"
+#include "Buffer.hpp"
+#include "FileManager.hpp"
 
 namespace fs = std::filesystem;
 
 class DataBase {
 
 private:
-    
+    std::map<std::string, std::unique_ptr<Table>> tables;
     
 
 public:
     std::string dbname;
+    IoBackend backend;
+    bool direct_io;
+    std::unique_ptr<FileManager> files;
+    std::unique_ptr<BufferPool> pool;
     
-    DataBase(const std::string& name);
+    DataBase(const std::string& name, int pool_size = DEFAULT_POOL_SIZE, IoBackend backend = IO_PREAD, bool direct_io = false);
+    DataBase(const std::string& name, const PoolOptions& pool_options, IoBackend backend = IO_PREAD, bool direct_io = false);
     bool createDatabase();
     bool tableExists(const std::string& tableName);
     bool createTable(const std::string& tableName, const std::map<std::string, std::string>& schema);
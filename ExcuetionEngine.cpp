@@ -1,69 +1,571 @@
 #include "ExcuetionEngine.hpp"
+#include "HeapFile.hpp"
+#include "Vectorized.hpp"
+#include "Parallel.hpp"
+#include "Join.hpp"
+#include "Aggregate.hpp"
+#include "Sort.hpp"
 #include <iostream>
 #include <algorithm>
-ExecutionEngine::ExecutionEngine(DataBase Db):Db(Db){}
+ExecutionEngine::ExecutionEngine(DataBase& Db):Db(Db){}
+
+HeapFile* ExecutionEngine::heapFile(const std::string& tableName) {
+    auto it = heapFiles.find(tableName);
+    if (it != heapFiles.end()) {
+        return it->second.get();
+    }
+    Table* table = Db.getTable(tableName);
+    if (table == nullptr) {
+        return nullptr;
+    }
+    HeapFile* heap = new HeapFile(table);
+    heapFiles[tableName].reset(heap);
+    return heap;
+}
 
 bool ExecutionEngine::Create_table(const std::string& tableName, const std::map<std::string,std::string> schema) {
-    Db.createTable(tableName,schema);
-    Db.getTable(tableName)->Create_page();
+    if (!Db.createTable(tableName,schema)) {
+        return false;
+    }
+    HeapFile* heap = heapFile(tableName);
+    if (heap == nullptr) {
+        return false;
+    }
+    Page* page = heap->allocate_page();
+    if (page != nullptr) {
+        Db.getTable(tableName)->Update_page(page->pageId, page);
+    }
     std::cout << "Table '" << tableName << "' created.\n";
     return true;
 }
 
 
 bool ExecutionEngine::insert(const std::string& tableName,const std::vector<std::pair<std::string, std::pair<int, std::string>>> attributes) {
-    
-   Page* p =Db.getTable(tableName)->Get_page(1);
+    HeapFile* heap = heapFile(tableName);
+    if (heap == nullptr) {
+        return false;
+    }
+    return heap->insert_tuple(attributes);
+}
 
-   p->insert_tuple(attributes);
-   p->serialize(1,Db.dbname,tableName);
 
+// Compiles a WHERE clause against a table's schema; an empty clause gives no expression.
+static bool compileWhere(const std::map<std::string, std::string>& schema, const std::string& condition, std::shared_ptr<const Expression>& where) {
+    if (condition.empty()) {
+        return true;
+    }
+    std::string error;
+    where = Expression::compile(condition, schema, error);
+    if (!where) {
+        std::cerr << "Error: Unsupported WHERE clause: " << condition << " (" << error << ")\n";
+        return false;
+    }
     return true;
 }
 
 
-bool ExecutionEngine::update(const std::string& tableName, const std::string& conditionKey, const std::string& conditionValue,
-                             const std::string& updateKey, const std::string& updateValue) {
-    if (!tableExists(tableName)) {
-        std::cerr << "Table '" << tableName << "' does not exist.\n";
+bool ExecutionEngine::deleteRecord(const std::string& tableName, const std::string& condition) {
+    HeapFile* heap = heapFile(tableName);
+    std::shared_ptr<const Expression> where;
+    if (heap == nullptr || !compileWhere(heap->get_table()->schema, condition, where)) {
+        return false;
+    }
+    bool deleted = heap->delete_tuples(where.get());
+
+    std::cout<<"Records Is Deleted Successfully"<<std::endl;
+    return deleted;
+}
+
+
+// UPDATE table SET column = value, ... [WHERE ...] on the stored rows. The row id cannot be
+// assigned, as indexes and the id directory locate rows by it.
+bool ExecutionEngine::update(const std::string& tableName, const std::vector<std::string>& assignments, const std::string& condition) {
+    HeapFile* heap = heapFile(tableName);
+    std::shared_ptr<const Expression> where;
+    if (heap == nullptr || !compileWhere(heap->get_table()->schema, condition, where)) {
         return false;
     }
-    bool updated = false;
-    for (auto& record : tables[tableName]) {
-        if (record[conditionKey] == conditionValue) {
-            record[updateKey] = updateValue;
-            updated = true;
+    std::vector<std::pair<std::string, std::string>> values;
+    for (const std::string& assignment : assignments) {
+        size_t equals = assignment.find('=');
+        std::string column = assignment.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : assignment.substr(equals + 1);
+        column.erase(column.find_last_not_of(' ') + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        value.erase(value.find_last_not_of(' ') + 1);
+        if (equals == std::string::npos || column.empty()) {
+            std::cerr << "Error: Expected column = value in SET, got " << assignment << "\n";
+            return false;
         }
+        if (column == "id") {
+            std::cerr << "Error: Column id cannot be updated\n";
+            return false;
+        }
+        if (heap->get_table()->schema.count(column) == 0) {
+            std::cerr << "Error: Unknown column " << column << "\n";
+            return false;
+        }
+        values.push_back({column, SyntaxValidator::unquote(value)});
     }
-    if (updated) {
-        std::cout << "Records updated in table '" << tableName << "'.\n";
-    } else {
-        std::cout << "No records matched the condition in table '" << tableName << "'.\n";
+    size_t updated = 0;
+    if (!heap->update_tuples(where.get(), values, updated)) {
+        return false;
     }
-    return updated;
+    std::cout << updated << " record(s) updated in table '" << tableName << "'.\n";
+    return updated > 0;
 }
 
 
-bool ExecutionEngine::deleteRecord(std::string& tableName,const std::pair<std::string, std::string>& attribute) {
-   Page* page = Db.getTable(tableName)->Get_page(1);
-   page->del_tuple(attribute);
-    page->serialize(1,Db.dbname,tableName);
-
-    std::cout<<"Records Is Deleted Successfully"<<std::endl;
+// VACUUM table: compacts the pages deletes left holes in and shrinks the table file by its
+// empty trailing pages.
+bool ExecutionEngine::vacuum(const std::string& tableName) {
+    HeapFile* heap = heapFile(tableName);
+    size_t compacted = 0;
+    size_t released = 0;
+    if (heap == nullptr || !heap->vacuum(compacted, released)) {
+        return false;
+    }
+    std::cout << "Table '" << tableName << "' vacuumed: " << compacted << " page(s) compacted, "
+              << released << " page(s) released.\n";
+    return true;
 }
 
 
 std::vector<Tuple> ExecutionEngine::select(std::string& tableName,const std::pair<std::string, std::string>& attribute){
-    
-    std::vector<Tuple> res= Db.getTable(tableName)->Get_page(1)->get_tuple(attribute);
+    HeapFile* heap = heapFile(tableName);
+    if (heap == nullptr) {
+        return {};
+    }
+    std::vector<Tuple> res= heap->select(attribute);
 
     return res;
    
 }
 
 
-bool ExecutionEngine::tableExists(const std::string& tableName) const {
-    return tables.find(tableName) != tables.end();
+std::vector<Tuple> ExecutionEngine::selectRange(std::string& tableName, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    HeapFile* heap = heapFile(tableName);
+    if (heap == nullptr) {
+        return {};
+    }
+    return heap->select_range(column, low, high);
+}
+
+
+bool ExecutionEngine::createIndex(const std::string& tableName, const std::string& indexName, const std::string& column, const std::string& method) {
+    IndexKind kind;
+    if (!Index::parse(method, kind)) {
+        std::cerr << "Error: Unknown index method " << method << ", expected BTREE or HASH\n";
+        return false;
+    }
+    HeapFile* heap = heapFile(tableName);
+    if (heap == nullptr || !heap->create_index(indexName, column, kind)) {
+        return false;
+    }
+    std::cout << "Index '" << indexName << "' created on " << tableName << "(" << column << ").\n";
+    return true;
+}
+
+
+// Batch scan of pages first..last with the WHERE clause applied: its integer comparisons by the
+// SIMD kernels, the rest on the rows that survive them. The batches decode the given columns
+// besides the ones the comparisons need.
+static std::unique_ptr<BatchOperator> scanPipeline(HeapFile* heap, std::vector<std::string> columns, const std::shared_ptr<const Expression>& where,
+                                                   const std::string& zoneColumn, const std::optional<KeyBound>& low,
+                                                   const std::optional<KeyBound>& high, uint32_t first, uint32_t last) {
+    std::vector<Expression::Comparison> comparisons;
+    if (where) {
+        for (const Expression::Comparison& comparison : where->comparisons()) {
+            if (comparison.domain == Expression::DOMAIN_INT) {
+                comparisons.push_back(comparison);
+                if (std::find(columns.begin(), columns.end(), comparison.column) == columns.end()) {
+                    columns.push_back(comparison.column);
+                }
+            }
+        }
+    }
+    auto scan = std::make_unique<BatchScan>(heap, columns, zoneColumn, low, high);
+    scan->restrict(first, last);
+    std::unique_ptr<BatchOperator> batches = std::move(scan);
+    for (const Expression::Comparison& comparison : comparisons) {
+        batches = std::make_unique<BatchFilter>(std::move(batches), comparison.column, comparison.op, comparison.integer);
+    }
+    bool always;
+    if (where) {
+        std::shared_ptr<const Expression> rest = where->without_integer_comparisons();
+        if (!rest->constant(always)) {
+            batches = std::make_unique<BatchPredicate>(std::move(batches), rest);
+        }
+    }
+    return batches;
+}
+
+
+// The ORDER BY columns, named and typed as the schema of the rows reaching the sort has them.
+static bool sortKeys(const QueryInfo& query, const std::map<std::string, std::string>& schema, std::vector<Sort::Key>& keys) {
+    for (const auto& [word, descending] : query.orderBy) {
+        std::string column, error;
+        Expression::Domain domain;
+        if (!Expression::resolve(schema, word, column, domain, error)) {
+            std::cerr << "Error: " << (error.empty() ? "Unknown column " + word : error) << "\n";
+            return false;
+        }
+        keys.push_back({column, domain, descending});
+    }
+    return true;
+}
+
+
+// The select list resolved against the schema, so a column it does not hold is an error rather
+// than an empty value on every row. * and the list of a grouped query, which aggregateSpec
+// checks, are kept as written.
+static bool selectColumns(const QueryInfo& query, const std::map<std::string, std::string>& schema, bool aggregate,
+                          std::vector<std::string>& columns) {
+    if (aggregate || query.columns == std::vector<std::string>{"*"}) {
+        columns = query.columns;
+        return true;
+    }
+    for (const std::string& word : query.columns) {
+        std::string column, error;
+        Expression::Domain domain;
+        if (!Expression::resolve(schema, word, column, domain, error)) {
+            std::cerr << "Error: " << (error.empty() ? "Unknown column " + word : error) << "\n";
+            return false;
+        }
+        columns.push_back(column);
+    }
+    return true;
+}
+
+
+// The group columns and aggregates of a grouped SELECT, named as the schema of its rows does.
+// Every plain column of the select list must be a group column.
+static bool aggregateSpec(const QueryInfo& query, const std::map<std::string, std::string>& schema, AggregateSpec& spec) {
+    if (query.columns == std::vector<std::string>{"*"}) {
+        std::cerr << "Error: SELECT * cannot be aggregated, list the group columns\n";
+        return false;
+    }
+    auto input = [&](const std::string& word, Expression::Domain& domain) -> int {
+        std::string column, error;
+        if (!Expression::resolve(schema, word, column, domain, error)) {
+            std::cerr << "Error: " << (error.empty() ? "Unknown column " + word : error) << "\n";
+            return -1;
+        }
+        auto found = std::find(spec.inputs.begin(), spec.inputs.end(), column);
+        if (found != spec.inputs.end()) {
+            return static_cast<int>(found - spec.inputs.begin());
+        }
+        spec.inputs.push_back(column);
+        spec.domains.push_back(domain);
+        return static_cast<int>(spec.inputs.size()) - 1;
+    };
+
+    Expression::Domain domain;
+    for (const std::string& column : query.groupBy) {
+        if (input(column, domain) < 0) {
+            return false;
+        }
+    }
+    spec.groups = spec.inputs.size();
+    for (const std::string& column : query.columns) {
+        auto call = std::find_if(query.aggregates.begin(), query.aggregates.end(), [&](const AggregateCall& c) { return c.text == column; });
+        if (call == query.aggregates.end()) {
+            int index = input(column, domain);
+            if (index < 0) {
+                return false;
+            }
+            if (static_cast<size_t>(index) >= spec.groups) {
+                std::cerr << "Error: Column " << column << " must appear in GROUP BY or in an aggregate\n";
+                return false;
+            }
+            spec.outputs.push_back({column, true, static_cast<size_t>(index)});
+            continue;
+        }
+        AggregateSpec::Call entry{AGG_COUNT, -1};
+        AggregateSpec::parse_function(call->function, entry.function);
+        if (call->argument == "*" && entry.function != AGG_COUNT) {
+            std::cerr << "Error: " << call->function << "(*) is not an aggregate, only COUNT(*) is\n";
+            return false;
+        }
+        if (call->argument != "*" && (entry.input = input(call->argument, domain)) < 0) {
+            return false;
+        }
+        if ((entry.function == AGG_SUM || entry.function == AGG_AVG) && domain == Expression::DOMAIN_TEXT && entry.input >= 0) {
+            std::cerr << "Error: " << call->function << " needs a numeric column, " << call->argument << " is text\n";
+            return false;
+        }
+        spec.outputs.push_back({column, false, spec.calls.size()});
+        spec.calls.push_back(entry);
+    }
+    return true;
+}
+
+
+// The threads a query scans with: PARALLEL n, capped at the shared pool's size, or the whole pool.
+static size_t queryParallelism(const QueryInfo& query) {
+    size_t threads = ThreadPool::shared().size();
+    return query.parallelism > 0 ? std::min(static_cast<size_t>(query.parallelism), threads) : threads;
+}
+
+
+// Builds the operator tree of a SELECT bottom up from the steps of its plan. The WHERE clause is
+// compiled once; a clause folded to false reads nothing and one folded to true filters nothing.
+// The scan becomes an IndexScan when the id directory or an index narrows a column the clause
+// bounds, with a row filter above it. Otherwise the scan runs vectorized: integer comparisons go
+// to the SIMD kernels, the rest of the clause is checked on the surviving rows' bytes, and pages
+// are skipped by the zone map of the first bounded column. Tables over one morsel are scanned
+// in parallel, on as many threads as the query's PARALLEL n asks for, up to the pool's size. Grouped
+// queries aggregate straight from the batches of those scans, into a partial table per thread.
+// Scans decode only the columns the query reads, so a Project is left only when the row filter
+// or the sort needs columns the select list drops.
+std::unique_ptr<Operator> ExecutionEngine::plan(const QueryInfo& query, const std::vector<ExecutionStep>& steps) {
+    if (!query.joinTable.empty()) {
+        return planJoin(query, steps);
+    }
+    HeapFile* heap = heapFile(query.tableName);
+    std::shared_ptr<const Expression> where;
+    if (heap == nullptr || !compileWhere(heap->get_table()->schema, query.condition, where)) {
+        return nullptr;
+    }
+    bool always = false;
+    if (where && where->constant(always) && always) {
+        where.reset();
+    }
+    AggregateSpec spec;
+    bool aggregate = !query.aggregates.empty() || !query.groupBy.empty();
+    if (aggregate && !aggregateSpec(query, heap->get_table()->schema, spec)) {
+        return nullptr;
+    }
+    std::vector<Sort::Key> order;
+    if (!sortKeys(query, aggregate ? spec.schema() : heap->get_table()->schema, order)) {
+        return nullptr;
+    }
+    std::vector<std::string> columns;
+    if (!selectColumns(query, heap->get_table()->schema, aggregate, columns)) {
+        return nullptr;
+    }
+
+    std::string column;
+    std::optional<KeyBound> low, high;
+    std::optional<std::vector<RecordId>> rids;
+    if (where && !where->constant(always)) {
+        for (const std::string& name : where->columns()) {
+            std::optional<KeyBound> lo, hi;
+            if (!where->bounds(name, lo, hi)) {
+                continue;
+            }
+            if (column.empty()) {
+                column = name;
+                low = lo;
+                high = hi;
+            }
+            if ((rids = heap->candidates(name, lo, hi))) {
+                break;
+            }
+        }
+    } else if (where) {
+        rids = std::vector<RecordId>();
+    }
+
+    std::vector<std::string> decode;
+    if (aggregate) {
+        decode = spec.inputs;
+    } else if (query.columns != std::vector<std::string>{"*"}) {
+        decode = columns;
+        for (const Sort::Key& key : order) {
+            if (std::find(decode.begin(), decode.end(), key.column) == decode.end()) {
+                decode.push_back(key.column);
+            }
+        }
+    }
+    if (!decode.empty() && rids && where) {
+        for (const std::string& name : where->columns()) {
+            if (std::find(decode.begin(), decode.end(), name) == decode.end()) {
+                decode.push_back(name);
+            }
+        }
+    }
+
+    size_t parallelism = queryParallelism(query);
+    bool parallel = parallelism > 1 && heap->get_table()->page_count > ParallelScan::MORSEL_PAGES;
+    std::unique_ptr<Operator> root;
+    MorselPipeline pipeline;
+    bool filtered = false;
+    for (const ExecutionStep& step : steps) {
+        if (step.operation == "Table Scan") {
+            if (rids) {
+                root = std::make_unique<IndexScan>(heap, std::move(*rids), decode);
+            } else if (where || parallel || aggregate) {
+                pipeline = [heap, inputs = spec.inputs, where, column, low, high](uint32_t first, uint32_t last) {
+                    return scanPipeline(heap, inputs, where, column, low, high, first, last);
+                };
+                if (parallel && !aggregate) {
+                    root = std::make_unique<ParallelScan>(heap, pipeline, parallelism, decode);
+                } else if (!aggregate) {
+                    root = std::make_unique<BatchToRows>(pipeline(1, UINT32_MAX), decode);
+                }
+                filtered = true;
+            } else {
+                root = std::make_unique<SeqScan>(heap, "", std::nullopt, std::nullopt, decode);
+            }
+        } else if (step.operation == "Filter" && root && where && !filtered) {
+            root = std::make_unique<Filter>(std::move(root), [where](Tuple& tuple) { return where->matches(tuple); });
+        } else if (step.operation == "Aggregate" && root) {
+            root = std::make_unique<HashAggregate>(std::move(root), std::move(spec), workMemory);
+        } else if (step.operation == "Aggregate" && pipeline) {
+            root = std::make_unique<HashAggregate>(heap, pipeline, parallel ? parallelism : 1, std::move(spec), workMemory);
+        } else if (step.operation == "Sort" && root) {
+            root = std::make_unique<Sort>(std::move(root), std::move(order), workMemory, query.limit);
+        } else if (step.operation == "Projection" && root && query.columns != std::vector<std::string>{"*"} && decode != columns) {
+            root = std::make_unique<Project>(std::move(root), columns);
+        } else if (step.operation == "Limit" && root) {
+            root = std::make_unique<Limit>(std::move(root), static_cast<size_t>(query.limit));
+        }
+    }
+    return root;
+}
+
+
+// A whole table as a join input, scanned morsel-parallel when it spans more than one morsel and
+// decoded to the given columns, all of them when none are given.
+static std::unique_ptr<Operator> joinInput(HeapFile* heap, size_t parallelism, const std::vector<std::string>& columns) {
+    if (parallelism > 1 && heap->get_table()->page_count > ParallelScan::MORSEL_PAGES) {
+        MorselPipeline pipeline = [heap](uint32_t first, uint32_t last) {
+            return scanPipeline(heap, {}, nullptr, "", std::nullopt, std::nullopt, first, last);
+        };
+        return std::make_unique<ParallelScan>(heap, std::move(pipeline), parallelism, columns);
+    }
+    return std::make_unique<SeqScan>(heap, "", std::nullopt, std::nullopt, columns);
+}
+
+// Splits a column reference of a join into its table, when qualified, and its column.
+static void splitColumn(const std::string& ref, std::string& table, std::string& column) {
+    size_t dot = ref.find('.');
+    table = dot == std::string::npos ? "" : ref.substr(0, dot);
+    column = dot == std::string::npos ? ref : ref.substr(dot + 1);
+}
+
+static bool hasColumn(HeapFile* heap, const std::string& column) {
+    return column == "id" || heap->get_table()->schema.count(column) > 0;
+}
+
+// A join of two tables on ON left = right. Its rows carry every column of both tables named
+// table.column, the WHERE clause and the select list may name them bare when that is unambiguous,
+// and the clause is applied to the joined rows. The smaller table is the build side; each input
+// is a parallel scan when large enough, and the join spills to partitions past workMemory. Each
+// input decodes only its join column and the columns of it the rest of the query reads.
+std::unique_ptr<Operator> ExecutionEngine::planJoin(const QueryInfo& query, const std::vector<ExecutionStep>& steps) {
+    HeapFile* left = heapFile(query.tableName);
+    HeapFile* right = heapFile(query.joinTable);
+    if (left == nullptr || right == nullptr) {
+        return nullptr;
+    }
+    if (query.tableName == query.joinTable) {
+        std::cerr << "Error: Joining " << query.tableName << " with itself needs table aliases, which are not supported\n";
+        return nullptr;
+    }
+
+    std::string leftTable, leftColumn, rightTable, rightColumn;
+    splitColumn(query.joinLeft, leftTable, leftColumn);
+    splitColumn(query.joinRight, rightTable, rightColumn);
+    if (leftTable == query.joinTable || rightTable == query.tableName ||
+        (leftTable.empty() && rightTable.empty() && !hasColumn(left, leftColumn) && hasColumn(right, leftColumn))) {
+        std::swap(leftTable, rightTable);
+        std::swap(leftColumn, rightColumn);
+    }
+    if ((!leftTable.empty() && leftTable != query.tableName) || !hasColumn(left, leftColumn)) {
+        std::cerr << "Error: Unknown join column " << (leftTable.empty() ? query.tableName : leftTable) << "." << leftColumn << "\n";
+        return nullptr;
+    }
+    if ((!rightTable.empty() && rightTable != query.joinTable) || !hasColumn(right, rightColumn)) {
+        std::cerr << "Error: Unknown join column " << (rightTable.empty() ? query.joinTable : rightTable) << "." << rightColumn << "\n";
+        return nullptr;
+    }
+
+    std::map<std::string, std::string> schema;
+    for (auto [heap, table] : {std::make_pair(left, query.tableName), std::make_pair(right, query.joinTable)}) {
+        schema[table + ".id"] = "INT";
+        for (const auto& [column, type] : heap->get_table()->schema) {
+            schema[table + "." + column] = type;
+        }
+    }
+    std::shared_ptr<const Expression> where;
+    if (!compileWhere(schema, query.condition, where)) {
+        return nullptr;
+    }
+    bool always = false;
+    if (where && where->constant(always) && always) {
+        where.reset();
+    }
+
+    AggregateSpec spec;
+    bool aggregate = !query.aggregates.empty() || !query.groupBy.empty();
+    if (aggregate && !aggregateSpec(query, schema, spec)) {
+        return nullptr;
+    }
+    std::vector<Sort::Key> order;
+    if (!sortKeys(query, aggregate ? spec.schema() : schema, order)) {
+        return nullptr;
+    }
+    std::vector<std::string> columns;
+    if (!selectColumns(query, schema, aggregate, columns)) {
+        return nullptr;
+    }
+
+    // The joined columns the query reads, split by table; none at all stands for every column.
+    std::vector<std::string> reads;
+    if (aggregate) {
+        reads = spec.inputs;
+    } else if (query.columns != std::vector<std::string>{"*"}) {
+        reads = columns;
+        for (const Sort::Key& key : order) {
+            reads.push_back(key.column);
+        }
+    }
+    std::vector<std::string> leftReads, rightReads;
+    if (!reads.empty()) {
+        if (where) {
+            reads.insert(reads.end(), where->columns().begin(), where->columns().end());
+        }
+        leftReads.push_back(leftColumn);
+        rightReads.push_back(rightColumn);
+        for (const std::string& ref : reads) {
+            std::string table, column;
+            splitColumn(ref, table, column);
+            std::vector<std::string>& side = table == query.tableName ? leftReads : rightReads;
+            if ((table == query.tableName || table == query.joinTable) && std::find(side.begin(), side.end(), column) == side.end()) {
+                side.push_back(column);
+            }
+        }
+    }
+
+    size_t parallelism = queryParallelism(query);
+    bool buildLeft = left->get_table()->page_count <= right->get_table()->page_count;
+    bool integerKeys = Expression::column_type(leftColumn == "id" ? "INT" : left->get_table()->schema[leftColumn]) == Expression::DOMAIN_INT &&
+                       Expression::column_type(rightColumn == "id" ? "INT" : right->get_table()->schema[rightColumn]) == Expression::DOMAIN_INT;
+    std::unique_ptr<Operator> root;
+    for (const ExecutionStep& step : steps) {
+        if (step.operation == "Hash Join") {
+            HashJoin::Side leftSide{joinInput(left, parallelism, leftReads), query.tableName, leftColumn};
+            HashJoin::Side rightSide{joinInput(right, parallelism, rightReads), query.joinTable, rightColumn};
+            if (buildLeft) {
+                root = std::make_unique<HashJoin>(std::move(leftSide), std::move(rightSide), true, integerKeys, workMemory);
+            } else {
+                root = std::make_unique<HashJoin>(std::move(rightSide), std::move(leftSide), false, integerKeys, workMemory);
+            }
+        } else if (step.operation == "Filter" && root && where) {
+            root = std::make_unique<Filter>(std::move(root), [where](Tuple& tuple) { return where->matches(tuple); });
+        } else if (step.operation == "Aggregate" && root) {
+            root = std::make_unique<HashAggregate>(std::move(root), std::move(spec), workMemory);
+        } else if (step.operation == "Sort" && root) {
+            root = std::make_unique<Sort>(std::move(root), std::move(order), workMemory, query.limit);
+        } else if (step.operation == "Projection" && root && query.columns != std::vector<std::string>{"*"}) {
+            root = std::make_unique<Project>(std::move(root), columns);
+        } else if (step.operation == "Limit" && root) {
+            root = std::make_unique<Limit>(std::move(root), static_cast<size_t>(query.limit));
+        }
+    }
+    return root;
 }
 
 
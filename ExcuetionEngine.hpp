@@ -4,30 +4,42 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 #include "DataBase.hpp"
+#include "HeapFile.hpp"
+#include "Operator.hpp"
+#include "parser.hpp"
 class ExecutionEngine {
 public:
     
-    DataBase Db;
-    ExecutionEngine(DataBase Db);
+    DataBase& Db;
+    ExecutionEngine(DataBase& Db);
 
     bool Create_table(const std::string& tableName, const std::map<std::string,std::string> schema);
 
 bool insert(const std::string& tableName,const std::vector<std::pair<std::string, std::pair<int, std::string>>> attributes) ;
-bool update(const std::string& tableName, const std::string& conditionKey, const std::string& conditionValue,
-                const std::string& updateKey, const std::string& updateValue);
-    bool deleteRecord(std::string& tableName,const std::pair<std::string, std::string>& attribute);
+    bool update(const std::string& tableName, const std::vector<std::string>& assignments, const std::string& condition);
+    bool deleteRecord(const std::string& tableName, const std::string& condition);
+    bool vacuum(const std::string& tableName);
     std::vector<Tuple> select(std::string& tableName,const std::pair<std::string, std::string>& attribute);
+    std::vector<Tuple> selectRange(std::string& tableName, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high);
+    bool createIndex(const std::string& tableName, const std::string& indexName, const std::string& column, const std::string& method = "BTREE");
+    std::unique_ptr<Operator> plan(const QueryInfo& query, const std::vector<ExecutionStep>& steps);
+
+    // Bytes a hash join, aggregation or sort may hold in memory before it spills to temporary files.
+    static constexpr size_t DEFAULT_WORK_MEMORY = 64u << 20;
+    size_t workMemory = DEFAULT_WORK_MEMORY;
 
 private:
     
-    bool tableExists(const std::string& tableName) const;
     bool databaseExists(const std::string& dbName) const;
+    HeapFile* heapFile(const std::string& tableName);
+    std::unique_ptr<Operator> planJoin(const QueryInfo& query, const std::vector<ExecutionStep>& steps);
 
     
     std::string currentDatabase;
-    std::unordered_map<std::string, std::vector<std::unordered_map<std::string, std::string>>> tables;
     std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> tableSchemas;
+    std::unordered_map<std::string, std::unique_ptr<HeapFile>> heapFiles;
 };
 
 #endif 
\ No newline at end of file
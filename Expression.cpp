@@ -0,0 +1,765 @@
+#include "Expression.hpp"
+#include "BPlusTree.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+enum Truth {
+    TRUTH_FALSE,
+    TRUTH_TRUE,
+    TRUTH_UNKNOWN
+};
+
+// One side of a comparison: a column slot, or a constant already converted to the comparison's
+// domain when slot is -1.
+struct Operand {
+    int slot = -1;
+    Expression::Domain type = Expression::DOMAIN_TEXT;
+    int64_t integer = 0;
+    double real = 0;
+    std::string text;
+};
+
+struct Expression::Node {
+    enum Kind {
+        CONSTANT,
+        COMPARE,
+        IN_LIST,
+        AND,
+        OR,
+        NOT
+    };
+
+    Kind kind = CONSTANT;
+    Truth truth = TRUTH_TRUE;
+    CompareOp op = CMP_EQ;
+    Domain domain = DOMAIN_TEXT;
+    Operand left;
+    Operand right;
+    std::vector<Operand> list;
+    std::vector<std::shared_ptr<const Node>> children;
+};
+
+using Node = Expression::Node;
+using NodePtr = std::shared_ptr<const Node>;
+
+bool Expression::parse_integer(std::string_view text, int64_t& value) {
+    size_t start = !text.empty() && text[0] == '-' ? 1 : 0;
+    size_t digits = text.size() - start;
+    if (digits == 0 || digits > 18 || (text[start] == '0' && (digits > 1 || start == 1))) {
+        return false;
+    }
+    int64_t parsed = 0;
+    for (size_t i = start; i < text.size(); i++) {
+        unsigned digit = static_cast<unsigned char>(text[i]) - '0';
+        if (digit > 9) {
+            return false;
+        }
+        parsed = parsed * 10 + digit;
+    }
+    value = start == 1 ? -parsed : parsed;
+    return true;
+}
+
+bool Expression::parse_real(std::string_view text, double& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+Expression::Domain Expression::column_type(const std::string& type) {
+    std::string upper = type;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+    if (upper == "INT" || upper == "INTEGER" || upper == "BIGINT" || upper == "SMALLINT") {
+        return Expression::DOMAIN_INT;
+    }
+    if (upper == "FLOAT" || upper == "DOUBLE" || upper == "REAL" || upper == "DECIMAL" || upper == "NUMERIC") {
+        return Expression::DOMAIN_FLOAT;
+    }
+    return Expression::DOMAIN_TEXT;
+}
+
+// A column is named as the schema has it, by its last part when the schema qualifies it (x for
+// a.x in a join) or with a qualifier the schema lacks (t.x for x). The row id is an INT column.
+bool Expression::resolve(const std::map<std::string, std::string>& schema, const std::string& word, std::string& column,
+                         Domain& type, std::string& error) {
+    column = word;
+    auto found = schema.find(word);
+    if (found == schema.end() && word.find('.') == std::string::npos) {
+        for (auto it = schema.begin(); it != schema.end(); ++it) {
+            size_t dot = it->first.rfind('.');
+            if (dot == std::string::npos || it->first.compare(dot + 1, std::string::npos, word) != 0) {
+                continue;
+            }
+            if (found != schema.end()) {
+                error = "ambiguous column " + word;
+                return false;
+            }
+            found = it;
+        }
+    } else if (found == schema.end()) {
+        column = word.substr(word.rfind('.') + 1);
+        found = schema.find(column);
+    }
+    if (found != schema.end()) {
+        column = found->first;
+        type = column_type(found->second);
+        return true;
+    }
+    type = DOMAIN_INT;
+    return column == "id";
+}
+
+// Text beats float beats int: a comparison is done in the widest type of its two sides.
+static Expression::Domain unify(Expression::Domain a, Expression::Domain b) {
+    return std::max(a, b);
+}
+
+static void convert(Operand& operand, Expression::Domain domain) {
+    if (operand.slot < 0 && domain == Expression::DOMAIN_FLOAT && operand.type == Expression::DOMAIN_INT) {
+        operand.real = static_cast<double>(operand.integer);
+    }
+}
+
+static CompareOp flip(CompareOp op) {
+    switch (op) {
+    case CMP_LT: return CMP_GT;
+    case CMP_LE: return CMP_GE;
+    case CMP_GT: return CMP_LT;
+    case CMP_GE: return CMP_LE;
+    default: return op;
+    }
+}
+
+
+struct Value {
+    bool known = false;
+    int64_t integer = 0;
+    double real = 0;
+    std::string_view text;
+};
+
+static Value value_of(const Operand& operand, Expression::Domain domain, const std::string_view* values) {
+    Value value;
+    if (operand.slot < 0) {
+        value.known = true;
+        value.integer = operand.integer;
+        value.real = operand.real;
+        value.text = operand.text;
+        return value;
+    }
+    std::string_view text = values[operand.slot];
+    switch (domain) {
+    case Expression::DOMAIN_INT:
+        value.known = Expression::parse_integer(text, value.integer);
+        break;
+    case Expression::DOMAIN_FLOAT:
+        value.known = Expression::parse_real(text, value.real);
+        break;
+    case Expression::DOMAIN_TEXT:
+        value.known = true;
+        value.text = text;
+        break;
+    }
+    return value;
+}
+
+static int order(const Value& a, const Value& b, Expression::Domain domain) {
+    switch (domain) {
+    case Expression::DOMAIN_INT:
+        return a.integer < b.integer ? -1 : (a.integer > b.integer ? 1 : 0);
+    case Expression::DOMAIN_FLOAT:
+        return a.real < b.real ? -1 : (a.real > b.real ? 1 : 0);
+    case Expression::DOMAIN_TEXT:
+        break;
+    }
+    int c = a.text.compare(b.text);
+    return c < 0 ? -1 : (c > 0 ? 1 : 0);
+}
+
+static bool holds(CompareOp op, int c) {
+    switch (op) {
+    case CMP_EQ: return c == 0;
+    case CMP_NE: return c != 0;
+    case CMP_LT: return c < 0;
+    case CMP_LE: return c <= 0;
+    case CMP_GT: return c > 0;
+    case CMP_GE: return c >= 0;
+    }
+    return false;
+}
+
+static Truth evaluate(const Node& node, const std::string_view* values) {
+    switch (node.kind) {
+    case Node::CONSTANT:
+        return node.truth;
+    case Node::COMPARE: {
+        Value a = value_of(node.left, node.domain, values);
+        Value b = value_of(node.right, node.domain, values);
+        if (!a.known || !b.known) {
+            return TRUTH_UNKNOWN;
+        }
+        return holds(node.op, order(a, b, node.domain)) ? TRUTH_TRUE : TRUTH_FALSE;
+    }
+    case Node::IN_LIST: {
+        Value a = value_of(node.left, node.domain, values);
+        if (!a.known) {
+            return TRUTH_UNKNOWN;
+        }
+        for (const Operand& item : node.list) {
+            if (order(a, value_of(item, node.domain, values), node.domain) == 0) {
+                return TRUTH_TRUE;
+            }
+        }
+        return TRUTH_FALSE;
+    }
+    case Node::AND:
+    case Node::OR: {
+        Truth absorbing = node.kind == Node::AND ? TRUTH_FALSE : TRUTH_TRUE;
+        Truth result = node.kind == Node::AND ? TRUTH_TRUE : TRUTH_FALSE;
+        for (const NodePtr& child : node.children) {
+            Truth truth = evaluate(*child, values);
+            if (truth == absorbing) {
+                return absorbing;
+            }
+            if (truth == TRUTH_UNKNOWN) {
+                result = TRUTH_UNKNOWN;
+            }
+        }
+        return result;
+    }
+    case Node::NOT: {
+        Truth truth = evaluate(*node.children[0], values);
+        return truth == TRUTH_UNKNOWN ? TRUTH_UNKNOWN : (truth == TRUTH_TRUE ? TRUTH_FALSE : TRUTH_TRUE);
+    }
+    }
+    return TRUTH_UNKNOWN;
+}
+
+static bool has_columns(const Node& node) {
+    switch (node.kind) {
+    case Node::CONSTANT:
+        return false;
+    case Node::COMPARE:
+        return node.left.slot >= 0 || node.right.slot >= 0;
+    case Node::IN_LIST:
+        return node.left.slot >= 0;
+    default:
+        return std::any_of(node.children.begin(), node.children.end(), [](const NodePtr& child) { return has_columns(*child); });
+    }
+}
+
+static NodePtr constant(Truth truth) {
+    auto node = std::make_shared<Node>();
+    node->truth = truth;
+    return node;
+}
+
+// Folds a freshly built node: AND and OR drop neutral constants, stop at absorbing ones and absorb
+// nested nodes of their own kind; anything left without columns becomes a constant.
+static NodePtr fold(std::shared_ptr<Node> node) {
+    if (node->kind == Node::AND || node->kind == Node::OR) {
+        Truth absorbing = node->kind == Node::AND ? TRUTH_FALSE : TRUTH_TRUE;
+        Truth neutral = node->kind == Node::AND ? TRUTH_TRUE : TRUTH_FALSE;
+        std::vector<NodePtr> kept;
+        for (const NodePtr& child : node->children) {
+            if (child->kind == Node::CONSTANT && child->truth == absorbing) {
+                return constant(absorbing);
+            }
+            if (child->kind == Node::CONSTANT && child->truth == neutral) {
+                continue;
+            }
+            if (child->kind == node->kind) {
+                kept.insert(kept.end(), child->children.begin(), child->children.end());
+            } else {
+                kept.push_back(child);
+            }
+        }
+        if (kept.empty()) {
+            return constant(neutral);
+        }
+        if (kept.size() == 1) {
+            return kept[0];
+        }
+        node->children = std::move(kept);
+    }
+    if (node->kind != Node::CONSTANT && !has_columns(*node)) {
+        return constant(evaluate(*node, nullptr));
+    }
+    return node;
+}
+
+static NodePtr combine(Node::Kind kind, std::vector<NodePtr> children) {
+    auto node = std::make_shared<Node>();
+    node->kind = kind;
+    node->children = std::move(children);
+    return fold(node);
+}
+
+static NodePtr compare(Operand left, CompareOp op, Operand right) {
+    auto node = std::make_shared<Node>();
+    node->kind = Node::COMPARE;
+    node->op = op;
+    node->domain = unify(left.type, right.type);
+    convert(left, node->domain);
+    convert(right, node->domain);
+    node->left = std::move(left);
+    node->right = std::move(right);
+    return fold(node);
+}
+
+
+namespace {
+
+struct Token {
+    enum Kind {
+        WORD,
+        INTEGER,
+        REAL,
+        STRING,
+        SYMBOL,
+        END
+    };
+
+    Kind kind;
+    std::string text;
+};
+
+// Recursive descent over the tokens, lowest precedence first: OR, AND, NOT, then a single
+// comparison or a parenthesized clause. Columns get slots in the order they first appear.
+class Parser {
+public:
+    Parser(const std::map<std::string, std::string>& schema, std::vector<std::string>& names, std::string& error)
+        : schema(schema), names(names), error(error) {}
+
+    bool tokenize(const std::string& text);
+    NodePtr parse();
+
+private:
+    const std::map<std::string, std::string>& schema;
+    std::vector<std::string>& names;
+    std::string& error;
+    std::vector<Token> tokens;
+    size_t pos = 0;
+
+    NodePtr parse_or();
+    NodePtr parse_and();
+    NodePtr parse_not();
+    NodePtr parse_predicate();
+    bool parse_operand(Operand& operand);
+    bool accept_keyword(const char* word);
+    bool accept_symbol(const char* symbol);
+    bool reserved(const std::string& word) const;
+    NodePtr fail(const std::string& message);
+};
+
+bool Parser::tokenize(const std::string& text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = text[i];
+        bool operand = !tokens.empty() && (tokens.back().kind != Token::SYMBOL || tokens.back().text == ")");
+        if (std::isspace(c)) {
+            i++;
+        } else if (c == '\'') {
+            size_t close = text.find('\'', i + 1);
+            if (close == std::string::npos) {
+                error = "unterminated string " + text.substr(i);
+                return false;
+            }
+            tokens.push_back({Token::STRING, text.substr(i, close - i + 1)});
+            i = close + 1;
+        } else if (std::isdigit(c) || (!operand && (c == '-' || c == '.') && i + 1 < text.size() && std::isdigit(static_cast<unsigned char>(text[i + 1])))) {
+            size_t start = i++;
+            bool real = c == '.';
+            while (i < text.size() && (std::isdigit(static_cast<unsigned char>(text[i])) || text[i] == '.' || text[i] == 'e' || text[i] == 'E' ||
+                                       ((text[i] == '-' || text[i] == '+') && (text[i - 1] == 'e' || text[i - 1] == 'E')))) {
+                real = real || !std::isdigit(static_cast<unsigned char>(text[i]));
+                i++;
+            }
+            tokens.push_back({real ? Token::REAL : Token::INTEGER, text.substr(start, i - start)});
+        } else if (std::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_' ||
+                                       (text[i] == '.' && i + 1 < text.size() && (std::isalpha(static_cast<unsigned char>(text[i + 1])) || text[i + 1] == '_')))) {
+                i++;
+            }
+            tokens.push_back({Token::WORD, text.substr(start, i - start)});
+        } else {
+            std::string two = text.substr(i, 2);
+            if (two == "<=" || two == ">=" || two == "!=" || two == "<>") {
+                tokens.push_back({Token::SYMBOL, two});
+                i += 2;
+            } else if (std::string("=<>(),").find(static_cast<char>(c)) != std::string::npos) {
+                tokens.push_back({Token::SYMBOL, std::string(1, static_cast<char>(c))});
+                i++;
+            } else {
+                error = std::string("unexpected character '") + static_cast<char>(c) + "'";
+                return false;
+            }
+        }
+    }
+    tokens.push_back({Token::END, ""});
+    return true;
+}
+
+NodePtr Parser::fail(const std::string& message) {
+    if (error.empty()) {
+        error = message;
+    }
+    return nullptr;
+}
+
+static bool same_word(const std::string& a, const char* b) {
+    size_t i = 0;
+    for (; i < a.size() && b[i] != '\0'; i++) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != b[i]) {
+            return false;
+        }
+    }
+    return i == a.size() && b[i] == '\0';
+}
+
+bool Parser::accept_keyword(const char* word) {
+    if (tokens[pos].kind == Token::WORD && same_word(tokens[pos].text, word)) {
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+bool Parser::accept_symbol(const char* symbol) {
+    if (tokens[pos].kind == Token::SYMBOL && tokens[pos].text == symbol) {
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+bool Parser::reserved(const std::string& word) const {
+    for (const char* keyword : {"AND", "OR", "NOT", "IN", "BETWEEN"}) {
+        if (same_word(word, keyword)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+NodePtr Parser::parse() {
+    NodePtr node = parse_or();
+    if (node && tokens[pos].kind != Token::END) {
+        return fail("unexpected '" + tokens[pos].text + "'");
+    }
+    return node;
+}
+
+NodePtr Parser::parse_or() {
+    std::vector<NodePtr> terms;
+    do {
+        NodePtr term = parse_and();
+        if (!term) {
+            return nullptr;
+        }
+        terms.push_back(std::move(term));
+    } while (accept_keyword("OR"));
+    return terms.size() == 1 ? terms[0] : combine(Node::OR, std::move(terms));
+}
+
+NodePtr Parser::parse_and() {
+    std::vector<NodePtr> factors;
+    do {
+        NodePtr factor = parse_not();
+        if (!factor) {
+            return nullptr;
+        }
+        factors.push_back(std::move(factor));
+    } while (accept_keyword("AND"));
+    return factors.size() == 1 ? factors[0] : combine(Node::AND, std::move(factors));
+}
+
+NodePtr Parser::parse_not() {
+    if (accept_keyword("NOT")) {
+        NodePtr operand = parse_not();
+        return operand ? combine(Node::NOT, {operand}) : nullptr;
+    }
+    return parse_predicate();
+}
+
+NodePtr Parser::parse_predicate() {
+    if (accept_symbol("(")) {
+        NodePtr node = parse_or();
+        if (node && !accept_symbol(")")) {
+            return fail("expected ')'");
+        }
+        return node;
+    }
+
+    Operand left;
+    if (!parse_operand(left)) {
+        return nullptr;
+    }
+    bool negated = accept_keyword("NOT");
+    if (accept_keyword("IN")) {
+        if (!accept_symbol("(")) {
+            return fail("expected '(' after IN");
+        }
+        auto node = std::make_shared<Node>();
+        node->kind = Node::IN_LIST;
+        node->domain = left.type;
+        do {
+            Operand item;
+            if (!parse_operand(item)) {
+                return nullptr;
+            }
+            if (item.slot >= 0) {
+                return fail("IN lists hold constants only");
+            }
+            node->domain = unify(node->domain, item.type);
+            node->list.push_back(std::move(item));
+        } while (accept_symbol(","));
+        if (!accept_symbol(")")) {
+            return fail("expected ')' after the IN list");
+        }
+        for (Operand& item : node->list) {
+            convert(item, node->domain);
+        }
+        convert(left, node->domain);
+        node->left = std::move(left);
+        NodePtr in = fold(node);
+        return negated ? combine(Node::NOT, {in}) : in;
+    }
+    if (accept_keyword("BETWEEN")) {
+        Operand low, high;
+        if (!parse_operand(low)) {
+            return nullptr;
+        }
+        if (!accept_keyword("AND")) {
+            return fail("expected AND in BETWEEN");
+        }
+        if (!parse_operand(high)) {
+            return nullptr;
+        }
+        NodePtr between = combine(Node::AND, {compare(left, CMP_GE, std::move(low)), compare(left, CMP_LE, std::move(high))});
+        return negated ? combine(Node::NOT, {between}) : between;
+    }
+    if (negated) {
+        return fail("expected IN or BETWEEN after NOT");
+    }
+
+    CompareOp op;
+    if (tokens[pos].kind != Token::SYMBOL || !kernels::parse_op(tokens[pos].text, op)) {
+        return fail("expected a comparison instead of '" + tokens[pos].text + "'");
+    }
+    pos++;
+    Operand right;
+    if (!parse_operand(right)) {
+        return nullptr;
+    }
+    return compare(std::move(left), op, std::move(right));
+}
+
+bool Parser::parse_operand(Operand& operand) {
+    const Token& token = tokens[pos];
+    switch (token.kind) {
+    case Token::WORD: {
+        if (reserved(token.text)) {
+            fail("expected a column or value instead of " + token.text);
+            return false;
+        }
+        std::string column;
+        if (Expression::resolve(schema, token.text, column, operand.type, error)) {
+            auto slot = std::find(names.begin(), names.end(), column);
+            operand.slot = static_cast<int>(slot - names.begin());
+            if (slot == names.end()) {
+                names.push_back(column);
+            }
+        } else {
+            fail(error.empty() ? "unknown column " + token.text : error);
+            return false;
+        }
+        break;
+    }
+    case Token::INTEGER:
+        if (token.text.size() - (token.text[0] == '-') <= 18) {
+            operand.type = Expression::DOMAIN_INT;
+            operand.integer = std::stoll(token.text);
+            break;
+        }
+        [[fallthrough]];
+    case Token::REAL:
+        if (!Expression::parse_real(token.text, operand.real)) {
+            fail("malformed number " + token.text);
+            return false;
+        }
+        operand.type = Expression::DOMAIN_FLOAT;
+        break;
+    case Token::STRING:
+        operand.type = Expression::DOMAIN_TEXT;
+        break;
+    default:
+        fail(token.kind == Token::END ? "expected a column or value at the end" : "expected a column or value instead of '" + token.text + "'");
+        return false;
+    }
+    operand.text = token.kind == Token::STRING ? token.text.substr(1, token.text.size() - 2) : token.text;
+    pos++;
+    return true;
+}
+
+}
+
+
+std::unique_ptr<Expression> Expression::compile(const std::string& where, const std::map<std::string, std::string>& schema, std::string& error) {
+    auto expression = std::make_unique<Expression>();
+    Parser parser(schema, expression->names, error);
+    if (!parser.tokenize(where)) {
+        return nullptr;
+    }
+    expression->root = parser.parse();
+    if (!expression->root) {
+        return nullptr;
+    }
+    return expression;
+}
+
+bool Expression::evaluate(const std::string_view* values) const {
+    return ::evaluate(*root, values) == TRUTH_TRUE;
+}
+
+// Columns are bound to views of the row's own strings; up to eight need no allocation.
+bool Expression::matches(const Tuple& tuple) const {
+    std::string_view inline_values[8];
+    std::vector<std::string_view> spilled;
+    std::string_view* values = inline_values;
+    if (names.size() > 8) {
+        spilled.resize(names.size());
+        values = spilled.data();
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+        values[i] = std::string_view();
+        for (const auto& attr : tuple.attributes) {
+            if (attr.first == names[i]) {
+                values[i] = attr.second.second;
+                break;
+            }
+        }
+    }
+    return evaluate(values);
+}
+
+// Same, straight from a serialized row (key length | key | type | value length | value). A view
+// with no data marks a column not seen yet; a missing one reads as "".
+bool Expression::matches(const char* record, size_t length) const {
+    std::string_view inline_values[8];
+    std::vector<std::string_view> spilled;
+    std::string_view* values = inline_values;
+    if (names.size() > 8) {
+        spilled.resize(names.size());
+        values = spilled.data();
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+        values[i] = std::string_view();
+    }
+    size_t offset = 0;
+    while (offset + 4 <= length) {
+        uint8_t keyLength = static_cast<uint8_t>(record[offset++]);
+        if (offset + keyLength + 3 > length) {
+            break;
+        }
+        std::string_view key(record + offset, keyLength);
+        offset += keyLength + 1;
+        size_t valueLength = (static_cast<uint8_t>(record[offset]) << 8) | static_cast<uint8_t>(record[offset + 1]);
+        offset += 2;
+        if (offset + valueLength > length) {
+            break;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            if (values[i].data() == nullptr && key == names[i]) {
+                values[i] = std::string_view(record + offset, valueLength);
+            }
+        }
+        offset += valueLength;
+    }
+    return evaluate(values);
+}
+
+bool Expression::constant(bool& value) const {
+    if (root->kind != Node::CONSTANT) {
+        return false;
+    }
+    value = root->truth == TRUTH_TRUE;
+    return true;
+}
+
+static std::vector<NodePtr> conjuncts(const NodePtr& root) {
+    return root->kind == Node::AND ? root->children : std::vector<NodePtr>{root};
+}
+
+static bool column_against_constant(const Node& node) {
+    return node.kind == Node::COMPARE && (node.left.slot >= 0) != (node.right.slot >= 0);
+}
+
+std::vector<Expression::Comparison> Expression::comparisons() const {
+    std::vector<Comparison> result;
+    for (const NodePtr& node : conjuncts(root)) {
+        if (!column_against_constant(*node)) {
+            continue;
+        }
+        bool columnLeft = node->left.slot >= 0;
+        const Operand& column = columnLeft ? node->left : node->right;
+        const Operand& value = columnLeft ? node->right : node->left;
+        std::string text = node->domain == DOMAIN_INT ? std::to_string(value.integer) : value.text;
+        result.push_back({names[column.slot], columnLeft ? node->op : flip(node->op), node->domain, value.integer, text});
+    }
+    return result;
+}
+
+static void tighten(std::optional<KeyBound>& bound, const KeyBound& candidate, bool lower) {
+    if (!bound) {
+        bound = candidate;
+        return;
+    }
+    int c = BPlusTree::compareKeys(candidate.key, bound->key);
+    if (lower ? c > 0 : c < 0) {
+        bound = candidate;
+    } else if (c == 0 && !candidate.inclusive) {
+        bound->inclusive = false;
+    }
+}
+
+// Key range on column implied by the top-level conjuncts, for an index or the zone map to narrow
+// the rows to a superset of the matches. Only integer comparisons and text equality qualify, as
+// those order and compare the way index keys do.
+bool Expression::bounds(const std::string& column, std::optional<KeyBound>& low, std::optional<KeyBound>& high) const {
+    low.reset();
+    high.reset();
+    for (const Comparison& comparison : comparisons()) {
+        if (comparison.column != column || comparison.op == CMP_NE) {
+            continue;
+        }
+        if (comparison.domain == DOMAIN_INT) {
+            KeyBound bound{comparison.text, comparison.op == CMP_EQ || comparison.op == CMP_LE || comparison.op == CMP_GE};
+            if (comparison.op != CMP_LT && comparison.op != CMP_LE) {
+                tighten(low, bound, true);
+            }
+            if (comparison.op != CMP_GT && comparison.op != CMP_GE) {
+                tighten(high, bound, false);
+            }
+        } else if (comparison.domain == DOMAIN_TEXT && comparison.op == CMP_EQ) {
+            tighten(low, KeyBound{comparison.text, true}, true);
+            tighten(high, KeyBound{comparison.text, true}, false);
+        }
+    }
+    return low || high;
+}
+
+// What is left to check once the integer column-against-constant conjuncts have been applied.
+std::unique_ptr<Expression> Expression::without_integer_comparisons() const {
+    std::vector<NodePtr> rest;
+    for (const NodePtr& node : conjuncts(root)) {
+        if (!column_against_constant(*node) || node->domain != DOMAIN_INT) {
+            rest.push_back(node);
+        }
+    }
+    auto expression = std::make_unique<Expression>();
+    expression->names = names;
+    expression->root = rest.empty() ? ::constant(TRUTH_TRUE) : (rest.size() == 1 ? rest[0] : combine(Node::AND, std::move(rest)));
+    return expression;
+}
@@ -0,0 +1,74 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include "Index.hpp"
+#include "Kernels.hpp"
+#include "tuple.hpp"
+
+// A WHERE clause parsed into a tree of comparisons (=, !=, <>, <, <=, >, >=, IN, BETWEEN) joined
+// by AND, OR and NOT, and compiled against the table's schema. Columns are typed by it: INT,
+// INTEGER, BIGINT and the row id as int64, FLOAT, DOUBLE and REAL as double, the rest as text.
+// Literals are converted once, subtrees without columns are folded to constants, and rows are
+// evaluated on views of their stored values, so matching a row builds no strings.
+//
+// Comparisons follow SQL's three-valued logic: a stored value that is not a plain number of its
+// column's type is unknown, and a row matches only when the whole clause is true. Text constants
+// are quoted ('abc') and compare without their quotes, as INSERT stores them; a bare word must
+// name a column, so a misspelt one fails to compile. Columns may be qualified (a.x), as in the
+// schema of a join.
+class Expression {
+public:
+    enum Domain {
+        DOMAIN_INT,
+        DOMAIN_FLOAT,
+        DOMAIN_TEXT
+    };
+
+    // A conjunct of the form column op constant, with the column on the left.
+    struct Comparison {
+        std::string column;
+        CompareOp op;
+        Domain domain;
+        int64_t integer;
+        std::string text;
+    };
+
+    static std::unique_ptr<Expression> compile(const std::string& where, const std::map<std::string, std::string>& schema, std::string& error);
+
+    // The domain values of a column declared with that type are compared in.
+    static Domain column_type(const std::string& type);
+
+    // The schema's name for a column of the clause, or false when it names none or, with error
+    // set, more than one.
+    static bool resolve(const std::map<std::string, std::string>& schema, const std::string& word, std::string& column,
+                        Domain& type, std::string& error);
+
+    // Plain integers only: an optional '-', no leading zeros and at most 18 digits.
+    static bool parse_integer(std::string_view text, int64_t& value);
+    static bool parse_real(std::string_view text, double& value);
+
+    bool matches(const Tuple& tuple) const;
+    bool matches(const char* record, size_t length) const;
+    bool constant(bool& value) const;
+    const std::vector<std::string>& columns() const { return names; }
+
+    std::vector<Comparison> comparisons() const;
+    bool bounds(const std::string& column, std::optional<KeyBound>& low, std::optional<KeyBound>& high) const;
+    std::unique_ptr<Expression> without_integer_comparisons() const;
+
+    struct Node;
+
+private:
+    std::shared_ptr<const Node> root;
+    std::vector<std::string> names;
+
+    bool evaluate(const std::string_view* values) const;
+};
+
+#endif
@@ -0,0 +1,291 @@
+#include "FileManager.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+FileManager::~FileManager() {
+    for (OpenFile& file : files) {
+        unmapFile(file);
+        if (file.fd >= 0) {
+            ::close(file.fd);
+        }
+    }
+}
+
+// With direct set the file bypasses the page cache, so every transfer must be a whole number of
+// pages from a page-aligned buffer. Filesystems that refuse O_DIRECT (tmpfs) get a buffered fd.
+int FileManager::openFile(const std::string& path, bool direct) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(path);
+    if (it != ids.end() && files[it->second].fd >= 0) {
+        return it->second;
+    }
+
+    int fd = direct ? ::open(path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644) : -1;
+    if (fd < 0) {
+        direct = false;
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    if (fd < 0) {
+        std::cerr << "Error: Could not open file " << path << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st;
+    off_t size = ::fstat(fd, &st) == 0 ? st.st_size : 0;
+
+    if (it != ids.end()) {
+        files[it->second] = {path, fd, size, direct, nullptr, 0, {}};
+        return it->second;
+    }
+    files.push_back({path, fd, size, direct, nullptr, 0, {}});
+    ids[path] = static_cast<int>(files.size()) - 1;
+    return static_cast<int>(files.size()) - 1;
+}
+
+// File ids stay reserved after closing, so ids held by pages already in the pool never get reused.
+void FileManager::closeFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(path);
+    if (it == ids.end() || files[it->second].fd < 0) {
+        return;
+    }
+    unmapFile(files[it->second]);
+    ::close(files[it->second].fd);
+    files[it->second].fd = -1;
+}
+
+FileManager::OpenFile& FileManager::entry(int fileId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files[fileId];
+}
+
+const FileManager::OpenFile& FileManager::entry(int fileId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files[fileId];
+}
+
+void FileManager::grow(OpenFile& file, off_t end) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (end > file.size) {
+        file.size = end;
+    }
+}
+
+// The whole file is mapped read-only through a window twice its size, so pages appended later
+// are reachable without remapping until the file outgrows it. A bigger mapping then replaces the
+// window and the old one stays valid until the file is closed, because Page views may still
+// point into it. Callers hold mutex, so concurrent scans never map the same file twice.
+bool FileManager::mapFile(OpenFile& file, off_t size) {
+    if (file.map != nullptr && file.mapLength >= static_cast<size_t>(size)) {
+        return true;
+    }
+    size_t needed = std::max(static_cast<size_t>(size) * 2, MIN_MAP_WINDOW);
+    void* addr = ::mmap(nullptr, needed, PROT_READ, MAP_SHARED, file.fd, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Error: Could not map " << file.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (file.map != nullptr) {
+        file.retiredMaps.push_back({file.map, file.mapLength});
+    }
+    file.map = static_cast<char*>(addr);
+    file.mapLength = needed;
+    return true;
+}
+
+void FileManager::unmapFile(OpenFile& file) {
+    if (file.map != nullptr) {
+        ::munmap(file.map, file.mapLength);
+        file.map = nullptr;
+        file.mapLength = 0;
+    }
+    for (const auto& retired : file.retiredMaps) {
+        ::munmap(retired.first, retired.second);
+    }
+    file.retiredMaps.clear();
+}
+
+// Returns nullptr for pages past the end of the file; those only exist in the buffer pool.
+const char* FileManager::mappedPage(int fileId, int pageId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    OpenFile& file = files[fileId];
+    off_t offset = static_cast<off_t>(pageId) * PAGE_SIZE;
+    if (offset + PAGE_SIZE > file.size || !mapFile(file, file.size)) {
+        return nullptr;
+    }
+    return file.map + offset;
+}
+
+void FileManager::advise(int fileId, AccessPattern pattern) {
+    std::lock_guard<std::mutex> lock(mutex);
+    OpenFile& file = files[fileId];
+    if (file.size == 0 || !mapFile(file, file.size)) {
+        return;
+    }
+    int advice = MADV_NORMAL;
+    if (pattern == ACCESS_SEQUENTIAL) {
+        advice = MADV_SEQUENTIAL;
+    } else if (pattern == ACCESS_RANDOM) {
+        advice = MADV_RANDOM;
+    }
+    ::madvise(file.map, std::min(file.mapLength, static_cast<size_t>(file.size)), advice);
+}
+
+static bool isAligned(off_t offset, const void* buffer, size_t length) {
+    return offset % PAGE_SIZE == 0 && length % PAGE_SIZE == 0 && reinterpret_cast<uintptr_t>(buffer) % PAGE_SIZE == 0;
+}
+
+// Unaligned transfers on an O_DIRECT file go through an aligned bounce buffer covering the
+// enclosing pages; writes read those pages first so the bytes around the range survive.
+bool FileManager::directRead(OpenFile& file, off_t offset, char* buffer, size_t length) {
+    off_t start = offset / PAGE_SIZE * PAGE_SIZE;
+    size_t span = (offset + length - start + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    char* bounce = static_cast<char*>(std::aligned_alloc(PAGE_SIZE, span));
+    if (bounce == nullptr) {
+        return false;
+    }
+    std::memset(bounce, 0, span);
+    size_t done = 0;
+    while (done < span) {
+        ssize_t n = ::pread(file.fd, bounce + done, span - done, start + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            std::cerr << "Error: Could not read " << file.path << ": " << std::strerror(errno) << std::endl;
+            std::free(bounce);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    std::memcpy(buffer, bounce + (offset - start), length);
+    std::free(bounce);
+    return true;
+}
+
+bool FileManager::directWrite(int fileId, off_t offset, const char* buffer, size_t length) {
+    OpenFile& file = entry(fileId);
+    off_t start = offset / PAGE_SIZE * PAGE_SIZE;
+    size_t span = (offset + length - start + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    char* bounce = static_cast<char*>(std::aligned_alloc(PAGE_SIZE, span));
+    if (bounce == nullptr || !directRead(file, start, bounce, span)) {
+        std::free(bounce);
+        return false;
+    }
+    std::memcpy(bounce + (offset - start), buffer, length);
+    bool ok = write(fileId, start, bounce, span);
+    std::free(bounce);
+    return ok;
+}
+
+bool FileManager::read(int fileId, off_t offset, char* buffer, size_t length) {
+    OpenFile& file = entry(fileId);
+    if (file.direct && !isAligned(offset, buffer, length)) {
+        return directRead(file, offset, buffer, length);
+    }
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(file.fd, buffer + done, length - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            std::cerr << "Error: Could not read " << file.path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (n == 0) {
+            std::memset(buffer + done, 0, length - done);
+            break;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool FileManager::write(int fileId, off_t offset, const char* buffer, size_t length) {
+    OpenFile& file = entry(fileId);
+    if (file.direct && !isAligned(offset, buffer, length)) {
+        return directWrite(fileId, offset, buffer, length);
+    }
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pwrite(file.fd, buffer + done, length - done, offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            std::cerr << "Error: Could not write " << file.path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        done += n;
+    }
+    grow(file, offset + length);
+    return true;
+}
+
+bool FileManager::readPage(int fileId, int pageId, char* buffer) {
+    off_t offset = static_cast<off_t>(pageId) * PAGE_SIZE;
+    if (offset >= fileSize(fileId)) {
+        std::memset(buffer, 0, PAGE_SIZE);
+        return true;
+    }
+    return read(fileId, offset, buffer, PAGE_SIZE);
+}
+
+bool FileManager::writePage(int fileId, int pageId, const char* buffer) {
+    return write(fileId, static_cast<off_t>(pageId) * PAGE_SIZE, buffer, PAGE_SIZE);
+}
+
+off_t FileManager::fileSize(int fileId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return files[fileId].size;
+}
+
+// Called after writes that bypassed write(), such as asynchronous write-backs.
+void FileManager::extend(int fileId, off_t end) {
+    grow(entry(fileId), end);
+}
+
+// Cuts the file back to end bytes. Mappings are kept; the pages past the end are not served
+// from them again until the file has grown back over them.
+bool FileManager::truncate(int fileId, off_t end) {
+    OpenFile& file = entry(fileId);
+    if (::ftruncate(file.fd, end) != 0) {
+        std::cerr << "Error: Could not truncate " << file.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    file.size = end;
+    return true;
+}
+
+int FileManager::fd(int fileId) const {
+    return entry(fileId).fd;
+}
+
+bool FileManager::isDirect(int fileId) const {
+    return entry(fileId).direct;
+}
+
+bool FileManager::sync(int fileId) {
+    const OpenFile& file = entry(fileId);
+    if (file.fd >= 0 && ::fdatasync(file.fd) != 0) {
+        std::cerr << "Error: Could not sync " << file.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const std::string& FileManager::path(int fileId) const {
+    return entry(fileId).path;
+}
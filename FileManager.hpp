@@ -0,0 +1,79 @@
+#ifndef FILE_MANAGER_HPP
+#define FILE_MANAGER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <sys/types.h>
+
+#define PAGE_SIZE 4096
+
+enum IoBackend {
+    IO_PREAD,
+    IO_MMAP
+};
+
+enum AccessPattern {
+    ACCESS_NORMAL,
+    ACCESS_SEQUENTIAL,
+    ACCESS_RANDOM
+};
+
+// Keeps one descriptor per database file for the lifetime of the database and does
+// all page I/O as single positional reads and writes at page_id * PAGE_SIZE. The file table
+// and cached sizes are guarded by a mutex, so the pool's background threads can share it.
+class FileManager {
+public:
+    FileManager() = default;
+    FileManager(const FileManager&) = delete;
+    FileManager& operator=(const FileManager&) = delete;
+    ~FileManager();
+
+    int openFile(const std::string& path, bool direct = false);
+    void closeFile(const std::string& path);
+
+    bool readPage(int fileId, int pageId, char* buffer);
+    bool writePage(int fileId, int pageId, const char* buffer);
+    bool read(int fileId, off_t offset, char* buffer, size_t length);
+    bool write(int fileId, off_t offset, const char* buffer, size_t length);
+
+    const char* mappedPage(int fileId, int pageId);
+    void advise(int fileId, AccessPattern pattern);
+
+    off_t fileSize(int fileId) const;
+    void extend(int fileId, off_t end);
+    bool truncate(int fileId, off_t end);
+    int fd(int fileId) const;
+    bool isDirect(int fileId) const;
+    bool sync(int fileId);
+    const std::string& path(int fileId) const;
+
+private:
+    struct OpenFile {
+        std::string path;
+        int fd;
+        off_t size;
+        bool direct;
+        char* map = nullptr;
+        size_t mapLength = 0;
+        std::vector<std::pair<char*, size_t>> retiredMaps;
+    };
+
+    static constexpr size_t MIN_MAP_WINDOW = size_t(64) << 20;
+
+    bool mapFile(OpenFile& file, off_t size);
+    void unmapFile(OpenFile& file);
+    OpenFile& entry(int fileId);
+    const OpenFile& entry(int fileId) const;
+    void grow(OpenFile& file, off_t end);
+    bool directRead(OpenFile& file, off_t offset, char* buffer, size_t length);
+    bool directWrite(int fileId, off_t offset, const char* buffer, size_t length);
+
+    mutable std::mutex mutex;
+    std::deque<OpenFile> files;
+    std::unordered_map<std::string, int> ids;
+};
+
+#endif
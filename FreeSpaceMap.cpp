@@ -0,0 +1,101 @@
+#include "FreeSpaceMap.hpp"
+#include <iostream>
+#include <algorithm>
+
+FreeSpaceMap::FreeSpaceMap(FileManager* files, const std::string& filePath)
+    : files(files), fileId(files->openFile(filePath)), buckets(CATEGORIES) {}
+
+int FreeSpaceMap::category(int freespace) {
+    if (freespace <= 0) {
+        return 0;
+    }
+    return std::min(freespace / UNIT, CATEGORIES - 1);
+}
+
+int FreeSpaceMap::page_count() const {
+    return static_cast<int>(categories.size());
+}
+
+bool FreeSpaceMap::load(uint32_t page_count) {
+    if (fileId < 0 || files->fileSize(fileId) < static_cast<off_t>(page_count)) {
+        return false;
+    }
+
+    std::vector<uint8_t> stored(page_count);
+    if (!files->read(fileId, 0, reinterpret_cast<char*>(stored.data()), page_count)) {
+        return false;
+    }
+
+    categories.clear();
+    positions.clear();
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+    for (uint32_t i = 0; i < page_count; i++) {
+        categories.push_back(stored[i]);
+        positions.push_back(static_cast<int>(buckets[stored[i]].size()));
+        buckets[stored[i]].push_back(static_cast<int>(i) + 1);
+    }
+    return true;
+}
+
+void FreeSpaceMap::update(int page_id, int freespace) {
+    int index = page_id - 1;
+    int cat = category(freespace);
+
+    if (index >= static_cast<int>(categories.size())) {
+        categories.resize(index + 1, 0);
+        positions.resize(index + 1, -1);
+    } else if (positions[index] >= 0) {
+        if (categories[index] == cat) {
+            return;
+        }
+
+        std::vector<int>& old_bucket = buckets[categories[index]];
+        int moved = old_bucket.back();
+        old_bucket[positions[index]] = moved;
+        positions[moved - 1] = positions[index];
+        old_bucket.pop_back();
+    }
+
+    categories[index] = static_cast<uint8_t>(cat);
+    positions[index] = static_cast<int>(buckets[cat].size());
+    buckets[cat].push_back(page_id);
+    persist(page_id);
+}
+
+// Forgets the pages after page_count, which the table no longer has.
+void FreeSpaceMap::truncate(uint32_t page_count) {
+    for (int index = static_cast<int>(categories.size()) - 1; index >= static_cast<int>(page_count); index--) {
+        if (positions[index] >= 0) {
+            std::vector<int>& bucket = buckets[categories[index]];
+            int moved = bucket.back();
+            bucket[positions[index]] = moved;
+            positions[moved - 1] = positions[index];
+            bucket.pop_back();
+        }
+    }
+    if (categories.size() > page_count) {
+        categories.resize(page_count);
+        positions.resize(page_count);
+    }
+    if (fileId >= 0 && files->fileSize(fileId) > static_cast<off_t>(page_count)) {
+        files->truncate(fileId, page_count);
+    }
+}
+
+int FreeSpaceMap::find(int needed) const {
+    int cat = (needed + UNIT - 1) / UNIT;
+    for (int c = std::max(cat, 1); c < CATEGORIES; c++) {
+        if (!buckets[c].empty()) {
+            return buckets[c].back();
+        }
+    }
+    return -1;
+}
+
+void FreeSpaceMap::persist(int page_id) {
+    if (fileId >= 0) {
+        files->write(fileId, page_id - 1, reinterpret_cast<const char*>(&categories[page_id - 1]), 1);
+    }
+}
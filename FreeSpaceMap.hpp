@@ -0,0 +1,36 @@
+#ifndef FREE_SPACE_MAP_HPP
+#define FREE_SPACE_MAP_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "page.hpp"
+#include "FileManager.hpp"
+
+// One byte per data page holding its free space in UNIT-sized steps, kept in <table>.FSM.
+// Pages are also bucketed by that byte so finding a page with room never probes pages.
+class FreeSpaceMap {
+public:
+    static constexpr int UNIT = PAGE_SIZE / 256;
+    static constexpr int CATEGORIES = 256;
+
+    FreeSpaceMap(FileManager* files, const std::string& filePath);
+
+    bool load(uint32_t page_count);
+    void update(int page_id, int freespace);
+    void truncate(uint32_t page_count);
+    int find(int needed) const;
+    int page_count() const;
+
+private:
+    FileManager* files;
+    int fileId;
+    std::vector<uint8_t> categories;
+    std::vector<std::vector<int>> buckets;
+    std::vector<int> positions;
+
+    static int category(int freespace);
+    void persist(int page_id);
+};
+
+#endif
@@ -0,0 +1,478 @@
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+#include <iostream>
+#include <arpa/inet.h>
+
+static uint16_t read_u16(const char* src) {
+    uint16_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return ntohs(value);
+}
+
+static void write_u16(char* dst, uint16_t value) {
+    value = htons(value);
+    std::memcpy(dst, &value, sizeof(value));
+}
+
+static int read_i32(const char* src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return static_cast<int>(ntohl(value));
+}
+
+static void write_i32(char* dst, int value) {
+    uint32_t network = htonl(static_cast<uint32_t>(value));
+    std::memcpy(dst, &network, sizeof(network));
+}
+
+
+HashIndex::HashIndex(BufferPool* pool, FileManager* files, const std::string& path)
+    : Index(pool, files, path) {}
+
+
+// FNV-1a over the key bytes, then the murmur3 finalizer so the low bits the directory uses
+// depend on every byte. The value is stored implicitly in the file layout, so it must not change.
+uint64_t HashIndex::hash(const std::string& key) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+// Entry: key length | key | record page | record slot.
+int HashIndex::entrySize(const IndexEntry& entry) {
+    return 2 + static_cast<int>(entry.key.size()) + 8;
+}
+
+
+// Whether splitting an overfull bucket helps. Entries sharing a hash (duplicates of one key)
+// never separate, so when they overflow a page on their own the bucket is split only once the
+// other entries would too; otherwise every new key landing next to a heavy duplicate would
+// deepen the bucket and double the directory.
+bool HashIndex::splittable(const std::vector<IndexEntry>& entries) {
+    std::unordered_map<uint64_t, int> groups;
+    int total = 0, largest = 0;
+    for (const IndexEntry& entry : entries) {
+        int& group = groups[hash(entry.key)];
+        group += entrySize(entry);
+        total += entrySize(entry);
+        largest = std::max(largest, group);
+    }
+    int room = PAGE_SIZE - BUCKET_HEADER_SIZE;
+    return groups.size() > 1 && (largest <= room || total - largest > room);
+}
+
+
+// Bucket page header: local depth | entry count | next overflow page (0 for the last page).
+// Pages on the free list use next to link to the following free page. Returns next.
+int HashIndex::readPage(int pageId, int& depth, std::vector<IndexEntry>& entries) {
+    Buffer_Page* frame = pool->requestPage(fileId, pageId, INDEX_PAGE);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not read index page " << pageId << " of " << filePath << std::endl;
+        return 0;
+    }
+    frame->latch.lock_shared();
+    const char* data = frame->data;
+    depth = read_u16(data);
+    int count = read_u16(data + 2);
+    int next = read_i32(data + 4);
+    int offset = BUCKET_HEADER_SIZE;
+    for (int i = 0; i < count; i++) {
+        IndexEntry entry;
+        uint16_t length = read_u16(data + offset);
+        entry.key.assign(data + offset + 2, length);
+        offset += 2 + length;
+        entry.rid = {read_i32(data + offset), read_i32(data + offset + 4)};
+        offset += 8;
+        entries.push_back(std::move(entry));
+    }
+    frame->latch.unlock_shared();
+    pool->releasePage(frame);
+    return next;
+}
+
+
+void HashIndex::writePage(int pageId, int depth, int next, const IndexEntry* entries, size_t count) {
+    Buffer_Page* frame = pool->requestPage(fileId, pageId, INDEX_PAGE, true);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not write index page " << pageId << " of " << filePath << std::endl;
+        return;
+    }
+    frame->latch.lock();
+    char* data = frame->data;
+    std::memset(data, 0, PAGE_SIZE);
+    write_u16(data, static_cast<uint16_t>(depth));
+    write_u16(data + 2, static_cast<uint16_t>(count));
+    write_i32(data + 4, next);
+    int offset = BUCKET_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        const IndexEntry& entry = entries[i];
+        write_u16(data + offset, static_cast<uint16_t>(entry.key.size()));
+        std::memcpy(data + offset + 2, entry.key.data(), entry.key.size());
+        offset += 2 + static_cast<int>(entry.key.size());
+        write_i32(data + offset, entry.rid.page);
+        write_i32(data + offset + 4, entry.rid.slot);
+        offset += 8;
+    }
+    frame->markDirty();
+    frame->latch.unlock();
+    pool->releasePage(frame);
+}
+
+
+HashIndex::Bucket HashIndex::readBucket(int pageId) {
+    Bucket bucket;
+    while (pageId != 0) {
+        int depth = 0;
+        bucket.pages.push_back(pageId);
+        pageId = readPage(pageId, depth, bucket.entries);
+        if (bucket.pages.size() == 1) {
+            bucket.depth = depth;
+        }
+    }
+    return bucket;
+}
+
+
+// Packs the entries into the bucket's pages in order, taking overflow pages as needed and
+// returning the ones no longer needed to the free list. The first page always stays.
+void HashIndex::writeBucket(Bucket& bucket) {
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t begin = 0;
+    int size = BUCKET_HEADER_SIZE;
+    for (size_t i = 0; i < bucket.entries.size(); i++) {
+        int length = entrySize(bucket.entries[i]);
+        if (i > begin && size + length > PAGE_SIZE) {
+            spans.push_back({begin, i});
+            begin = i;
+            size = BUCKET_HEADER_SIZE;
+        }
+        size += length;
+    }
+    spans.push_back({begin, bucket.entries.size()});
+
+    while (bucket.pages.size() < spans.size()) {
+        bucket.pages.push_back(allocatePage());
+    }
+    while (bucket.pages.size() > spans.size()) {
+        freePage(bucket.pages.back());
+        bucket.pages.pop_back();
+    }
+    for (size_t i = 0; i < spans.size(); i++) {
+        int next = i + 1 < spans.size() ? bucket.pages[i + 1] : 0;
+        writePage(bucket.pages[i], bucket.depth, next, bucket.entries.data() + spans[i].first, spans[i].second - spans[i].first);
+    }
+}
+
+
+int HashIndex::allocatePage() {
+    if (freeList == 0) {
+        return ++pageCount;
+    }
+    int pageId = freeList;
+    int depth;
+    std::vector<IndexEntry> unused;
+    freeList = readPage(pageId, depth, unused);
+    return pageId;
+}
+
+
+void HashIndex::freePage(int pageId) {
+    writePage(pageId, 0, freeList, nullptr, 0);
+    freeList = pageId;
+}
+
+
+// Header page: magic | global depth | page count | free list | directory page count | column
+// length | column, then the directory page ids from DIRECTORY_OFFSET. Directory pages hold
+// SLOTS_PER_PAGE bucket page ids each.
+bool HashIndex::readHeader() {
+    Buffer_Page* frame = pool->requestPage(fileId, 0, INDEX_PAGE);
+    if (frame == nullptr) {
+        return false;
+    }
+    frame->latch.lock_shared();
+    const char* data = frame->data;
+    bool valid = read_i32(data) == MAGIC;
+    if (valid) {
+        globalDepth = read_i32(data + 4);
+        pageCount = read_i32(data + 8);
+        freeList = read_i32(data + 12);
+        directoryPages.resize(read_i32(data + 16));
+        indexColumn.assign(data + 22, read_u16(data + 20));
+        for (size_t i = 0; i < directoryPages.size(); i++) {
+            directoryPages[i] = read_i32(data + DIRECTORY_OFFSET + 4 * i);
+        }
+    }
+    frame->latch.unlock_shared();
+    pool->releasePage(frame);
+    if (!valid) {
+        return false;
+    }
+
+    directory.assign(size_t(1) << globalDepth, 0);
+    for (size_t page = 0; page < directoryPages.size(); page++) {
+        frame = pool->requestPage(fileId, directoryPages[page], INDEX_PAGE);
+        if (frame == nullptr) {
+            return false;
+        }
+        frame->latch.lock_shared();
+        size_t first = page * SLOTS_PER_PAGE;
+        size_t last = std::min(directory.size(), first + SLOTS_PER_PAGE);
+        for (size_t slot = first; slot < last; slot++) {
+            directory[slot] = read_i32(frame->data + 4 * (slot - first));
+        }
+        frame->latch.unlock_shared();
+        pool->releasePage(frame);
+    }
+    return true;
+}
+
+
+void HashIndex::writeHeader() {
+    Buffer_Page* frame = pool->requestPage(fileId, 0, INDEX_PAGE, true);
+    if (frame == nullptr) {
+        std::cerr << "Error: Could not write the header of " << filePath << std::endl;
+        return;
+    }
+    frame->latch.lock();
+    char* data = frame->data;
+    std::memset(data, 0, PAGE_SIZE);
+    write_i32(data, MAGIC);
+    write_i32(data + 4, globalDepth);
+    write_i32(data + 8, pageCount);
+    write_i32(data + 12, freeList);
+    write_i32(data + 16, static_cast<int>(directoryPages.size()));
+    write_u16(data + 20, static_cast<uint16_t>(indexColumn.size()));
+    std::memcpy(data + 22, indexColumn.data(), indexColumn.size());
+    for (size_t i = 0; i < directoryPages.size(); i++) {
+        write_i32(data + DIRECTORY_OFFSET + 4 * i, directoryPages[i]);
+    }
+    frame->markDirty();
+    frame->latch.unlock();
+    pool->releasePage(frame);
+}
+
+
+// Writes the directory pages covering slots [first, last).
+void HashIndex::writeDirectory(size_t first, size_t last) {
+    if (first >= last) {
+        return;
+    }
+    for (size_t page = first / SLOTS_PER_PAGE; page <= (last - 1) / SLOTS_PER_PAGE; page++) {
+        Buffer_Page* frame = pool->requestPage(fileId, directoryPages[page], INDEX_PAGE, true);
+        if (frame == nullptr) {
+            std::cerr << "Error: Could not write the directory of " << filePath << std::endl;
+            return;
+        }
+        frame->latch.lock();
+        std::memset(frame->data, 0, PAGE_SIZE);
+        size_t start = page * SLOTS_PER_PAGE;
+        size_t end = std::min(directory.size(), start + SLOTS_PER_PAGE);
+        for (size_t slot = start; slot < end; slot++) {
+            write_i32(frame->data + 4 * (slot - start), directory[slot]);
+        }
+        frame->markDirty();
+        frame->latch.unlock();
+        pool->releasePage(frame);
+    }
+}
+
+
+// Doubles the directory; the new upper half points at the same buckets as the lower half.
+bool HashIndex::growDirectory() {
+    if (globalDepth == MAX_DEPTH) {
+        return false;
+    }
+    size_t size = directory.size();
+    directory.resize(size * 2);
+    std::copy(directory.begin(), directory.begin() + size, directory.begin() + size);
+    globalDepth++;
+    while (directoryPages.size() * SLOTS_PER_PAGE < directory.size()) {
+        directoryPages.push_back(allocatePage());
+    }
+    writeDirectory(size, directory.size());
+    return true;
+}
+
+
+// Moves the entries whose next hash bit is set to a new bucket and repoints the half of the
+// directory slots sharing the bucket that have that bit. The bucket's depth must be below the
+// global depth.
+void HashIndex::splitBucket(Bucket& bucket, size_t slot) {
+    int depth = bucket.depth;
+    Bucket high;
+    high.depth = depth + 1;
+    high.pages.push_back(allocatePage());
+    bucket.depth = depth + 1;
+
+    std::vector<IndexEntry> low;
+    for (IndexEntry& entry : bucket.entries) {
+        ((hash(entry.key) >> depth) & 1 ? high.entries : low).push_back(std::move(entry));
+    }
+    bucket.entries.swap(low);
+    writeBucket(bucket);
+    writeBucket(high);
+
+    size_t first = (slot & ((size_t(1) << depth) - 1)) | (size_t(1) << depth);
+    size_t last = first;
+    for (size_t s = first; s < directory.size(); s += size_t(2) << depth) {
+        directory[s] = high.pages[0];
+        last = s + 1;
+    }
+    writeDirectory(first, last);
+}
+
+
+bool HashIndex::open() {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    if (fileId < 0 || !readHeader()) {
+        std::cerr << "Error: " << filePath << " is not an index file" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Sizes the directory so the average bucket fills FILL_SIZE, then writes every bucket once.
+bool HashIndex::build(const std::string& column, std::vector<IndexEntry> entries) {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    if (fileId < 0) {
+        return false;
+    }
+    if (files->fileSize(fileId) > 0) {
+        std::cerr << "Error: Index file already exists: " << filePath << std::endl;
+        return false;
+    }
+    if (column.size() > DIRECTORY_OFFSET - 22) {
+        std::cerr << "Error: Column name " << column << " is too long to index" << std::endl;
+        return false;
+    }
+    size_t bytes = 0;
+    for (const IndexEntry& entry : entries) {
+        if (entry.key.size() > MAX_KEY_SIZE) {
+            std::cerr << "Error: Value of " << entry.key.size() << " bytes is too long to index" << std::endl;
+            return false;
+        }
+        bytes += entrySize(entry);
+    }
+
+    indexColumn = column;
+    pageCount = 0;
+    freeList = 0;
+    globalDepth = 0;
+    while (globalDepth < MAX_DEPTH && (bytes >> globalDepth) > static_cast<size_t>(FILL_SIZE - BUCKET_HEADER_SIZE)) {
+        globalDepth++;
+    }
+    directory.assign(size_t(1) << globalDepth, 0);
+    directoryPages.clear();
+    while (directoryPages.size() * SLOTS_PER_PAGE < directory.size()) {
+        directoryPages.push_back(++pageCount);
+    }
+
+    std::vector<Bucket> buckets(directory.size());
+    for (IndexEntry& entry : entries) {
+        buckets[hash(entry.key) & (directory.size() - 1)].entries.push_back(std::move(entry));
+    }
+    for (size_t slot = 0; slot < buckets.size(); slot++) {
+        Bucket& bucket = buckets[slot];
+        std::sort(bucket.entries.begin(), bucket.entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+            return std::tie(a.key, a.rid.page, a.rid.slot) < std::tie(b.key, b.rid.page, b.rid.slot);
+        });
+        bucket.entries.erase(std::unique(bucket.entries.begin(), bucket.entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+            return a.key == b.key && a.rid.page == b.rid.page && a.rid.slot == b.rid.slot;
+        }), bucket.entries.end());
+        bucket.depth = globalDepth;
+        bucket.pages.push_back(++pageCount);
+        writeBucket(bucket);
+        directory[slot] = bucket.pages[0];
+    }
+    writeDirectory(0, directory.size());
+    writeHeader();
+    return true;
+}
+
+
+bool HashIndex::insert(const std::string& key, RecordId rid) {
+    if (key.size() > MAX_KEY_SIZE) {
+        std::cerr << "Error: Value of " << key.size() << " bytes is too long to index" << std::endl;
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(latch);
+    int pages = pageCount, free = freeList, depth = globalDepth;
+    uint64_t h = hash(key);
+    while (true) {
+        size_t slot = h & (directory.size() - 1);
+        Bucket bucket = readBucket(directory[slot]);
+        bool present = std::any_of(bucket.entries.begin(), bucket.entries.end(), [&](const IndexEntry& entry) {
+            return entry.key == key && entry.rid.page == rid.page && entry.rid.slot == rid.slot;
+        });
+        if (present) {
+            break;
+        }
+        bucket.entries.push_back({key, rid});
+        int size = BUCKET_HEADER_SIZE;
+        for (const IndexEntry& entry : bucket.entries) {
+            size += entrySize(entry);
+        }
+        if (size <= PAGE_SIZE || bucket.depth == MAX_DEPTH || !splittable(bucket.entries)) {
+            writeBucket(bucket);
+            break;
+        }
+        bucket.entries.pop_back();
+        if (bucket.depth == globalDepth) {
+            growDirectory();
+        }
+        splitBucket(bucket, slot);
+    }
+    if (pageCount != pages || freeList != free || globalDepth != depth) {
+        writeHeader();
+    }
+    return true;
+}
+
+
+bool HashIndex::erase(const std::string& key, RecordId rid) {
+    std::unique_lock<std::shared_mutex> lock(latch);
+    Bucket bucket = readBucket(directory[hash(key) & (directory.size() - 1)]);
+    auto it = std::find_if(bucket.entries.begin(), bucket.entries.end(), [&](const IndexEntry& entry) {
+        return entry.key == key && entry.rid.page == rid.page && entry.rid.slot == rid.slot;
+    });
+    if (it == bucket.entries.end()) {
+        return false;
+    }
+    bucket.entries.erase(it);
+    int free = freeList;
+    writeBucket(bucket);
+    if (freeList != free) {
+        writeHeader();
+    }
+    return true;
+}
+
+
+// Record ids of the rows whose value is exactly key, sorted by page.
+std::vector<RecordId> HashIndex::find(const std::string& key) {
+    std::shared_lock<std::shared_mutex> lock(latch);
+    std::vector<RecordId> result;
+    for (const IndexEntry& entry : readBucket(directory[hash(key) & (directory.size() - 1)]).entries) {
+        if (entry.key == key) {
+            result.push_back(entry.rid);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const RecordId& a, const RecordId& b) {
+        return a.page != b.page ? a.page < b.page : a.slot < b.slot;
+    });
+    return result;
+}
@@ -0,0 +1,71 @@
+#ifndef HASH_INDEX_HPP
+#define HASH_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <shared_mutex>
+#include "Index.hpp"
+
+// Extendible hash index for equality lookups, kept in <db>/<table>.<index>.HIX. Page 0 holds the
+// global depth, page count, free page list, column name and the ids of the directory pages; the
+// directory maps the low global-depth bits of a key's hash to a bucket page, and is kept in
+// memory so a lookup reads one bucket page. A full bucket is split on its next hash bit, doubling
+// the directory only when its local depth equals the global depth. A bucket that splitting
+// cannot relieve (mostly duplicates of one key), or that is at the maximum depth, grows a chain
+// of overflow pages instead. Buckets are never merged; overflow pages emptied by deletes are reused.
+class HashIndex : public Index {
+public:
+    HashIndex(BufferPool* pool, FileManager* files, const std::string& path);
+
+    bool build(const std::string& column, std::vector<IndexEntry> entries) override;
+    bool open() override;
+
+    bool insert(const std::string& key, RecordId rid) override;
+    bool erase(const std::string& key, RecordId rid) override;
+    std::vector<RecordId> find(const std::string& key) override;
+
+    IndexKind kind() const override { return INDEX_HASH; }
+    int depth() const { return globalDepth; }
+
+    static uint64_t hash(const std::string& key);
+
+private:
+    struct Bucket {
+        int depth = 0;
+        std::vector<int> pages;
+        std::vector<IndexEntry> entries;
+    };
+
+    static constexpr int BUCKET_HEADER_SIZE = 8;
+    static constexpr int DIRECTORY_OFFSET = 256;
+    static constexpr int SLOTS_PER_PAGE = PAGE_SIZE / 4;
+    static constexpr int MAX_DIRECTORY_PAGES = (PAGE_SIZE - DIRECTORY_OFFSET) / 4;
+    static constexpr int MAX_DEPTH = 19;
+    static constexpr int FILL_SIZE = PAGE_SIZE * 7 / 10;
+    static constexpr int MAGIC = 0x48495831;
+
+    int globalDepth = 0;
+    int pageCount = 0;
+    int freeList = 0;
+    std::vector<int> directory;
+    std::vector<int> directoryPages;
+    std::shared_mutex latch;
+
+    static int entrySize(const IndexEntry& entry);
+    static bool splittable(const std::vector<IndexEntry>& entries);
+
+    int readPage(int pageId, int& depth, std::vector<IndexEntry>& entries);
+    void writePage(int pageId, int depth, int next, const IndexEntry* entries, size_t count);
+    Bucket readBucket(int pageId);
+    void writeBucket(Bucket& bucket);
+    int allocatePage();
+    void freePage(int pageId);
+    bool readHeader();
+    void writeHeader();
+    void writeDirectory(size_t first, size_t last);
+    bool growDirectory();
+    void splitBucket(Bucket& bucket, size_t slot);
+};
+
+#endif
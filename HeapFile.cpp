@@ -0,0 +1,795 @@
+#include "HeapFile.hpp"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <climits>
+#include <cctype>
+#include <set>
+
+// Every schema column and the row id.
+static std::vector<std::string> zone_columns(const Table* table) {
+    std::vector<std::string> columns;
+    for (const auto& column : table->schema) {
+        columns.push_back(column.first);
+    }
+    columns.push_back("id");
+    return columns;
+}
+
+HeapFile::HeapFile(Table* table)
+    : table(table), fsm(table->files, table->db_name + "/" + table->table_name + ".FSM"),
+      zones(table->files, table->db_name + "/" + table->table_name + ".ZMP", zone_columns(table)) {
+    if (!fsm.load(table->page_count)) {
+        rebuild_fsm();
+    }
+    if (!zones.load(table->page_count)) {
+        rebuild_zones();
+    }
+    load_indexes();
+}
+
+std::string HeapFile::index_path(const std::string& name, IndexKind kind) const {
+    return table->db_name + "/" + table->table_name + "." + name + Index::extension(kind);
+}
+
+void HeapFile::load_indexes() {
+    std::string prefix = table->table_name + ".";
+    for (const auto& file : std::filesystem::directory_iterator(table->db_name)) {
+        std::string name = file.path().filename().string();
+        std::string extension = file.path().extension().string();
+        IndexKind kind = extension == Index::extension(INDEX_HASH) ? INDEX_HASH : INDEX_BTREE;
+        if (extension != Index::extension(kind) || name.rfind(prefix, 0) != 0) {
+            continue;
+        }
+        auto index = Index::create(kind, table->pool, table->files, file.path().string());
+        if (index->open()) {
+            indexes.push_back(std::move(index));
+        }
+    }
+}
+
+// Index for equality lookups on column, a hash index if the column has one.
+Index* HeapFile::index_on(const std::string& column) {
+    Index* found = nullptr;
+    for (const auto& index : indexes) {
+        if (index->column() == column && (found == nullptr || index->kind() == INDEX_HASH)) {
+            found = index.get();
+        }
+    }
+    return found;
+}
+
+// Ordered index for range lookups on column.
+BPlusTree* HeapFile::tree_on(const std::string& column) {
+    for (const auto& index : indexes) {
+        if (index->column() == column && index->kind() == INDEX_BTREE) {
+            return static_cast<BPlusTree*>(index.get());
+        }
+    }
+    return nullptr;
+}
+
+// Collects (value, record id) of every row and bulk loads the index from them. A relocated row
+// is entered under the id of its stub.
+bool HeapFile::create_index(const std::string& name, const std::string& column, IndexKind kind) {
+    std::string path = index_path(name, kind);
+    if (std::filesystem::exists(index_path(name, INDEX_BTREE)) || std::filesystem::exists(index_path(name, INDEX_HASH))) {
+        std::cerr << "Error: Index already exists: " << name << std::endl;
+        return false;
+    }
+    std::vector<IndexEntry> entries;
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        std::string record;
+        for (int slot = 0; slot < page->slot_count(); slot++) {
+            if (page->get_record(slot, record)) {
+                Tuple tuple;
+                tuple.Deserialize(record);
+                RecordId rid{static_cast<int>(page_id), slot};
+                page->relocated(slot, rid.page, rid.slot);
+                entries.push_back({tuple.get_attribute(column), rid});
+            }
+        }
+        table->Release_page(page);
+    }
+
+    auto index = Index::create(kind, table->pool, table->files, path);
+    if (!index->build(column, std::move(entries))) {
+        table->files->closeFile(path);
+        std::filesystem::remove(path);
+        return false;
+    }
+    indexes.push_back(std::move(index));
+    return true;
+}
+
+void HeapFile::rebuild_fsm() {
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        fsm.update(page_id, page->freespace);
+        table->Release_page(page);
+    }
+}
+
+void HeapFile::rebuild_zones() {
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            zones.clear(page_id);
+            continue;
+        }
+        std::vector<Tuple> tuples = page->get_tuple({" ", " "});
+        zones.reset(page_id, tuples);
+        table->Release_page(page);
+    }
+}
+
+std::string HeapFile::value_of(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes, const std::string& column) {
+    for (const auto& attr : attributes) {
+        if (attr.first == column) {
+            return attr.second.second;
+        }
+    }
+    return "";
+}
+
+int HeapFile::record_size(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes) {
+    Tuple t;
+    for (const auto& attr : attributes) {
+        t.add_attribute(attr.first, attr.second.second);
+    }
+    t.add_attribute("id", std::string(10, '0'));
+    return static_cast<int>(t.Serialize().size()) + Page::SLOT_SIZE;
+}
+
+Page* HeapFile::allocate_page() {
+    Page* page = table->Create_page();
+    if (page == nullptr) {
+        std::cerr << "Error: Could not allocate a new page for table " << table->table_name << std::endl;
+        return nullptr;
+    }
+    fsm.update(page->pageId, page->freespace);
+    zones.clear(page->pageId);
+    return page;
+}
+
+// A latched page with room for needed bytes, slot included: the page the free space map offers
+// unless it is the excluded one, else a new page.
+Page* HeapFile::page_with_room(int needed, int excluded) {
+    Page* page = nullptr;
+    int free_page = fsm.find(needed);
+    if (free_page > 0 && free_page != excluded) {
+        page = table->Get_page(free_page);
+    }
+    if (page != nullptr && !page->can_fit(needed - Page::SLOT_SIZE)) {
+        table->Release_page(page);
+        page = nullptr;
+    }
+    if (page == nullptr) {
+        page = allocate_page();
+    }
+    return page;
+}
+
+bool HeapFile::insert_tuple(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes) {
+    int needed = record_size(attributes);
+    if (needed > PAGE_SIZE - Page::HEADER_SIZE) {
+        std::cerr << "Error: Row of " << needed << " bytes is larger than a page" << std::endl;
+        return false;
+    }
+
+    for (const auto& index : indexes) {
+        if (value_of(attributes, index->column()).size() > Index::MAX_KEY_SIZE) {
+            std::cerr << "Error: Value of " << index->column() << " is too long for its index" << std::endl;
+            return false;
+        }
+    }
+
+    Page* page = page_with_room(needed);
+    if (page == nullptr) {
+        return false;
+    }
+
+    if (!page->ids_left() && !table->Renew_ids(page)) {
+        std::cerr << "Error: Could not issue row ids to page " << page->pageId << std::endl;
+        table->Release_page(page);
+        return false;
+    }
+    int page_id = page->pageId;
+    int slot = page->next_slot();
+    int row_id = page->ids_Range.first;
+    bool inserted = page->insert_tuple(attributes);
+    fsm.update(page_id, page->freespace);
+    table->Update_page(page_id, page);
+    if (inserted) {
+        std::vector<std::pair<std::string, std::string>> values;
+        for (const auto& attr : attributes) {
+            values.push_back({attr.first, attr.second.second});
+        }
+        values.push_back({"id", std::to_string(row_id)});
+        zones.add(page_id, values);
+        for (const auto& index : indexes) {
+            std::string key = index->column() == "id" ? std::to_string(row_id) : value_of(attributes, index->column());
+            index->insert(key, {page_id, slot});
+        }
+    }
+    return inserted;
+}
+
+// Decodes the rows behind count record ids of one page into rows, in order. Stubs of relocated
+// rows are followed once that page is unlatched, so no two page latches are held at a time.
+// Ids without a row are skipped, as are slots holding a row relocated from elsewhere, which
+// belongs to another id.
+void HeapFile::read_rows(const RecordId* rids, size_t count, const std::vector<std::string>& columns, std::vector<Tuple>& rows) {
+    Page* page = count > 0 ? table->Read_page(rids[0].page) : nullptr;
+    if (page == nullptr) {
+        return;
+    }
+    std::vector<std::pair<size_t, RecordId>> forwards;
+    for (size_t i = 0; i < count; i++) {
+        RecordId target;
+        if (page->forwarded(rids[i].slot, target.page, target.slot)) {
+            forwards.push_back({rows.size(), target});
+            rows.emplace_back();
+        } else if (!page->relocated(rids[i].slot, target.page, target.slot)) {
+            rows.emplace_back();
+            if (!page->read_tuple(rids[i].slot, columns, rows.back())) {
+                rows.pop_back();
+            }
+        }
+    }
+    table->Release_page(page);
+
+    std::vector<size_t> lost;
+    for (const auto& [row, target] : forwards) {
+        Page* away = table->Read_page(target.page);
+        if (away == nullptr || !away->read_tuple(target.slot, columns, rows[row])) {
+            lost.push_back(row);
+        }
+        if (away != nullptr) {
+            table->Release_page(away);
+        }
+    }
+    for (auto it = lost.rbegin(); it != lost.rend(); ++it) {
+        rows.erase(rows.begin() + *it);
+    }
+}
+
+// Reads the rows behind the record ids, visiting each page once since ids come sorted by
+// page within a key. keep re-checks a row, as the index compares integer keys by value.
+std::vector<Tuple> HeapFile::fetch(const std::vector<RecordId>& rids, const std::function<bool(Tuple&)>& keep) {
+    std::vector<Tuple> results;
+    std::vector<Tuple> rows;
+    size_t end;
+    for (size_t start = 0; start < rids.size(); start = end) {
+        for (end = start; end < rids.size() && rids[end].page == rids[start].page; end++) {
+        }
+        rows.clear();
+        read_rows(&rids[start], end - start, {}, rows);
+        for (Tuple& tuple : rows) {
+            if (keep(tuple)) {
+                results.push_back(std::move(tuple));
+            }
+        }
+    }
+    return results;
+}
+
+// Where the rows behind record ids are stored: the id of a relocated row is replaced by the
+// slot it moved to.
+std::vector<RecordId> HeapFile::follow(const std::vector<RecordId>& rids) {
+    std::vector<RecordId> located;
+    located.reserve(rids.size());
+    Page* page = nullptr;
+    for (const RecordId& rid : rids) {
+        if (page != nullptr && page->pageId != rid.page) {
+            table->Release_page(page);
+            page = nullptr;
+        }
+        if (page == nullptr && (page = table->Read_page(rid.page)) == nullptr) {
+            continue;
+        }
+        RecordId target;
+        located.push_back(page->forwarded(rid.slot, target.page, target.slot) ? target : rid);
+    }
+    if (page != nullptr) {
+        table->Release_page(page);
+    }
+    return located;
+}
+
+// Row ids are plain integers; any other value cannot be an id.
+static bool row_id(const std::string& value, long long& id) {
+    size_t start = !value.empty() && value[0] == '-' ? 1 : 0;
+    if (value.size() == start || value.size() - start > 18) {
+        return false;
+    }
+    for (size_t i = start; i < value.size(); i++) {
+        if (!std::isdigit(static_cast<unsigned char>(value[i]))) {
+            return false;
+        }
+    }
+    id = std::stoll(value);
+    return true;
+}
+
+// The pages issued ids in [low, high], in page order.
+std::vector<int> HeapFile::id_pages(long long low, long long high) const {
+    std::vector<int> page_ids;
+    low = std::max<long long>(low, 1);
+    high = std::min<long long>(high, INT_MAX);
+    if (low > high) {
+        return page_ids;
+    }
+    for (const IdRange& range : table->ranges_between(static_cast<int>(low), static_cast<int>(high))) {
+        page_ids.push_back(range.page);
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+    page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+    return page_ids;
+}
+
+// Record ids of the rows whose id lies in [low, high], in id order. The id directory names the
+// pages that were issued ids in that range; each is read once for the ids of its rows, and the
+// rows behind its forwarding stubs are read where they moved to.
+std::vector<RecordId> HeapFile::id_rids(long long low, long long high) const {
+    std::vector<RecordId> rids;
+    std::vector<int> page_ids = id_pages(low, high);
+    std::vector<std::pair<long long, RecordId>> found;
+    std::vector<std::pair<RecordId, RecordId>> stubs;
+    for (int page_id : page_ids) {
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        for (int slot = 0; slot < page->slot_count(); slot++) {
+            RecordId target;
+            long long id;
+            if (page->forwarded(slot, target.page, target.slot)) {
+                stubs.push_back({{page_id, slot}, target});
+            } else if (!page->relocated(slot, target.page, target.slot) && page->row_id(slot, id) && id >= low && id <= high) {
+                found.push_back({id, {page_id, slot}});
+            }
+        }
+        table->Release_page(page);
+    }
+    for (const auto& [home, target] : stubs) {
+        Page* page = table->Read_page(target.page);
+        if (page == nullptr) {
+            continue;
+        }
+        long long id;
+        if (page->row_id(target.slot, id) && id >= low && id <= high) {
+            found.push_back({id, home});
+        }
+        table->Release_page(page);
+    }
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& entry : found) {
+        rids.push_back(entry.second);
+    }
+    return rids;
+}
+
+// Record ids of the rows that can have column between the bounds, from the id directory for
+// integer id bounds within a few pages, a hash index or B+tree for equality and a B+tree for
+// ranges. Nullopt means nothing narrows the search and the table has to be scanned. Ids are only candidates: the
+// rows still have to be checked, as indexes compare integer keys by value.
+std::optional<std::vector<RecordId>> HeapFile::candidates(const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    if (!low && !high) {
+        return std::nullopt;
+    }
+    long long low_id = LLONG_MIN, high_id = LLONG_MAX;
+    if (column == "id" && (!low || row_id(low->key, low_id)) && (!high || row_id(high->key, high_id))) {
+        if (low && !low->inclusive) {
+            low_id++;
+        }
+        if (high && !high->inclusive) {
+            high_id--;
+        }
+        // The directory path reads each page for the ids of its rows and again for the rows, so
+        // past a few pages a scan skipping pages by their id zones reads less.
+        if (id_pages(low_id, high_id).size() > ID_RANGE_PAGES) {
+            return std::nullopt;
+        }
+        return id_rids(low_id, high_id);
+    }
+    bool equal = low && high && low->inclusive && high->inclusive && low->key == high->key;
+    Index* index = equal ? index_on(column) : nullptr;
+    if (index != nullptr) {
+        return index->find(low->key);
+    }
+    BPlusTree* tree = tree_on(column);
+    if (tree != nullptr) {
+        return tree->range(low, high);
+    }
+    return std::nullopt;
+}
+
+// Whether the zone map lets rows of the page have column between the bounds.
+bool HeapFile::may_match(int page_id, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) const {
+    if (low && high && low->inclusive && high->inclusive && low->key == high->key) {
+        return zones.may_contain(page_id, column, low->key);
+    }
+    return zones.may_overlap(page_id, column, low, high);
+}
+
+// A lookup by id reads one page through the id directory; other columns use an index when
+// there is one and scan the table otherwise.
+std::vector<Tuple> HeapFile::select(const std::pair<std::string, std::string>& attribute) {
+    bool all = attribute.first == " " && attribute.second == " ";
+    std::optional<KeyBound> value;
+    if (!all) {
+        value = KeyBound{attribute.second, true};
+        if (auto rids = candidates(attribute.first, value, value)) {
+            return fetch(*rids, [&](Tuple& tuple) {
+                return tuple.get_attribute(attribute.first) == attribute.second;
+            });
+        }
+    }
+
+    std::vector<Tuple> results;
+    if (table->backend == IO_MMAP) {
+        table->files->advise(table->file_id, ACCESS_SEQUENTIAL);
+    }
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        if (!all && !zones.may_contain(page_id, attribute.first, attribute.second)) {
+            continue;
+        }
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        std::vector<Tuple> matches = page->get_tuple(attribute);
+        results.insert(results.end(), std::make_move_iterator(matches.begin()), std::make_move_iterator(matches.end()));
+        table->Release_page(page);
+    }
+    return results;
+}
+
+bool HeapFile::in_range(const std::string& value, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    if (low) {
+        int c = BPlusTree::compareKeys(value, low->key);
+        if (c < 0 || (c == 0 && !low->inclusive)) {
+            return false;
+        }
+    }
+    if (high) {
+        int c = BPlusTree::compareKeys(value, high->key);
+        if (c > 0 || (c == 0 && !high->inclusive)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rows whose column lies between the bounds, in index order when an index or the id directory
+// provides them and in table order when the table is scanned.
+std::vector<Tuple> HeapFile::select_range(const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    if (auto rids = candidates(column, low, high)) {
+        return fetch(*rids, [&](Tuple& tuple) {
+            return in_range(tuple.get_attribute(column), low, high);
+        });
+    }
+    std::vector<Tuple> results;
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        if (!zones.may_overlap(page_id, column, low, high)) {
+            continue;
+        }
+        Page* page = table->Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        for (Tuple& tuple : page->get_tuple({" ", " "})) {
+            if (in_range(tuple.get_attribute(column), low, high)) {
+                results.push_back(std::move(tuple));
+            }
+        }
+        table->Release_page(page);
+    }
+    return results;
+}
+
+// The pages that can hold rows matching where, a clause that is not constant, or every page when
+// it is null. Only the pages of candidate rows are visited when the id directory or an index
+// narrows a column the clause bounds, with stubs followed to where relocated rows live; pages
+// the zone map rules out are skipped otherwise.
+std::vector<int> HeapFile::pages_for(const Expression* where) {
+    std::string column;
+    std::optional<KeyBound> low, high;
+    std::optional<std::vector<RecordId>> rids;
+    if (where != nullptr) {
+        for (const std::string& name : where->columns()) {
+            std::optional<KeyBound> lo, hi;
+            if (!where->bounds(name, lo, hi)) {
+                continue;
+            }
+            if (column.empty()) {
+                column = name;
+                low = lo;
+                high = hi;
+            }
+            if ((rids = candidates(name, lo, hi))) {
+                break;
+            }
+        }
+    }
+    std::vector<int> page_ids;
+    if (rids) {
+        for (const RecordId& rid : follow(*rids)) {
+            if (page_ids.empty() || page_ids.back() != rid.page) {
+                page_ids.push_back(rid.page);
+            }
+        }
+        std::sort(page_ids.begin(), page_ids.end());
+        page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+    } else {
+        for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+            if (column.empty() || may_match(page_id, column, low, high)) {
+                page_ids.push_back(static_cast<int>(page_id));
+            }
+        }
+    }
+    return page_ids;
+}
+
+// The column values of a row as the zone map takes them.
+static std::vector<std::pair<std::string, std::string>> zone_values(const Tuple& tuple) {
+    std::vector<std::pair<std::string, std::string>> values;
+    for (const auto& attr : tuple.attributes) {
+        values.push_back({attr.first, attr.second.second});
+    }
+    return values;
+}
+
+// Deletes the rows matching where, or every row when it is null, from the pages pages_for
+// picks. Deleted rows are removed from every index of the table, and a relocated row takes the
+// forwarding stub in its home slot with it.
+bool HeapFile::delete_tuples(const Expression* where) {
+    bool always = false;
+    if (where != nullptr && where->constant(always)) {
+        if (!always) {
+            return false;
+        }
+        where = nullptr;
+    }
+    std::function<bool(const char*, size_t)> match;
+    if (where != nullptr) {
+        match = [where](const char* record, size_t length) { return where->matches(record, length); };
+    }
+    std::vector<std::string> keys;
+    for (const auto& index : indexes) {
+        keys.push_back(index->column());
+    }
+    bool deleted = false;
+    std::vector<RecordId> stubs;
+    for (int page_id : pages_for(where)) {
+        Page* page = table->Get_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        std::vector<RemovedRow> removed;
+        if (page->del_tuple(match, &removed, keys.empty() ? nullptr : &keys)) {
+            fsm.update(page_id, page->freespace);
+            table->Update_page(page_id, page);
+            deleted = true;
+        } else {
+            table->Release_page(page);
+        }
+        for (RemovedRow& row : removed) {
+            for (const auto& index : indexes) {
+                index->erase(row.tuple.get_attribute(index->column()), {row.page, row.slot});
+            }
+            if (row.page != page_id) {
+                stubs.push_back({row.page, row.slot});
+            }
+        }
+    }
+    for (const RecordId& stub : stubs) {
+        Page* page = table->Get_page(stub.page);
+        if (page == nullptr) {
+            continue;
+        }
+        page->delete_record(stub.slot);
+        fsm.update(stub.page, page->freespace);
+        table->Update_page(stub.page, page);
+    }
+    return deleted;
+}
+
+// Compacts the pages deletes left holes in and recomputes the zone of every page from the rows
+// it still holds, then gives the empty pages at the end of the table back to the file. Empty
+// pages before the last used one stay, as the free space map already offers them to inserts.
+bool HeapFile::vacuum(size_t& compacted, size_t& released) {
+    compacted = 0;
+    released = 0;
+    uint32_t used = 0;
+    for (uint32_t page_id = 1; page_id <= table->page_count; page_id++) {
+        Page* page = table->Get_page(page_id);
+        if (page == nullptr) {
+            used = page_id;
+            continue;
+        }
+        if (page->slot_count() == 0) {
+            zones.clear(page_id);
+            table->Release_page(page);
+            continue;
+        }
+        used = page_id;
+        std::vector<Tuple> rows = page->get_tuple({" ", " "});
+        zones.reset(page_id, rows);
+        if (page->fragmented()) {
+            page->compact();
+            compacted++;
+            table->Update_page(page_id, page);
+        } else {
+            table->Release_page(page);
+        }
+    }
+    if (used < table->page_count) {
+        uint32_t before = table->page_count;
+        if (!table->Truncate(used)) {
+            return false;
+        }
+        released = before - used;
+        fsm.truncate(used);
+        zones.truncate(used);
+    }
+    return true;
+}
+
+// Sets the assigned columns of the rows matching where, or of every row when it is null, and
+// counts the rows in updated. A row is rewritten in its slot while it still fits its page and
+// moves to a page with room otherwise, after that page is unlatched. Only the indexes of
+// assigned columns whose value changed are touched, and only changed pages are dirtied.
+bool HeapFile::update_tuples(const Expression* where, const std::vector<std::pair<std::string, std::string>>& assignments, size_t& updated) {
+    updated = 0;
+    for (const auto& [column, value] : assignments) {
+        if (index_on(column) != nullptr && value.size() > Index::MAX_KEY_SIZE) {
+            std::cerr << "Error: Value of " << column << " is too long for its index" << std::endl;
+            return false;
+        }
+    }
+    bool always = false;
+    if (where != nullptr && where->constant(always)) {
+        if (!always) {
+            return true;
+        }
+        where = nullptr;
+    }
+
+    struct Move {
+        RecordId from;
+        RecordId home;
+        Tuple old;
+        Tuple row;
+    };
+    auto reindex = [this](Tuple& old, Tuple& row, const RecordId& home) {
+        for (const auto& index : indexes) {
+            std::string before = old.get_attribute(index->column());
+            std::string after = row.get_attribute(index->column());
+            if (before != after) {
+                index->erase(before, home);
+                index->insert(after, home);
+            }
+        }
+    };
+    // Rows moved by this statement, so a page visited later does not update them again.
+    std::set<std::pair<int, int>> placed;
+    std::vector<Move> moves;
+    for (int page_id : pages_for(where)) {
+        Page* page = table->Get_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        bool dirty = false;
+        std::string record;
+        for (int slot = 0; slot < page->slot_count(); slot++) {
+            if (placed.count({page_id, slot}) > 0 || !page->get_record(slot, record) ||
+                (where != nullptr && !where->matches(record.data(), record.size()))) {
+                continue;
+            }
+            Tuple row;
+            row.Deserialize(record);
+            Tuple old = row;
+            for (const auto& [column, value] : assignments) {
+                auto attr = std::find_if(row.attributes.begin(), row.attributes.end(), [&](const auto& a) { return a.first == column; });
+                if (attr != row.attributes.end()) {
+                    attr->second.second = value;
+                } else {
+                    row.add_attribute(column, value);
+                }
+            }
+            RecordId home{page_id, slot};
+            bool away = page->relocated(slot, home.page, home.slot);
+            record = row.Serialize();
+            if (page->update_record(slot, away ? Page::relocated_record(home.page, home.slot, record) : record)) {
+                zones.add(page_id, zone_values(row));
+                dirty = true;
+            } else if (Page::MARKER_SIZE + static_cast<int>(record.size()) + Page::SLOT_SIZE > PAGE_SIZE - Page::HEADER_SIZE) {
+                std::cerr << "Error: Row " << row.get_attribute("id") << " would be larger than a page" << std::endl;
+                continue;
+            } else {
+                // Its indexes and the count change once the row has a page to move to.
+                moves.push_back({{page_id, slot}, home, std::move(old), row});
+                continue;
+            }
+            reindex(old, row, home);
+            updated++;
+        }
+        if (dirty) {
+            fsm.update(page_id, page->freespace);
+            table->Update_page(page_id, page);
+        } else {
+            table->Release_page(page);
+        }
+        for (Move& move : moves) {
+            RecordId to;
+            if (!relocate(move.from, move.home, move.row, to)) {
+                std::cerr << "Error: No page has room to move row " << move.row.get_attribute("id") << std::endl;
+                return false;
+            }
+            placed.insert({to.page, to.slot});
+            reindex(move.old, move.row, move.home);
+            updated++;
+        }
+        moves.clear();
+    }
+    return true;
+}
+
+// Moves a row that outgrew its page to one with room, and points the stub in its home slot at
+// the new place; a row that moves back to its home page takes the stub's slot again. False,
+// with the row left where it was, when no page takes it. The stubs only shrink slots that hold
+// a record, so they fail only on a slot that is gone, which is reported as well.
+bool HeapFile::relocate(const RecordId& from, const RecordId& home, Tuple& row, RecordId& placed) {
+    std::string record = row.Serialize();
+    std::string moved = Page::relocated_record(home.page, home.slot, record);
+    int needed = static_cast<int>(moved.size()) + Page::SLOT_SIZE;
+    Page* target = page_with_room(needed, from.page);
+    if (target == nullptr) {
+        return false;
+    }
+    placed = {target->pageId, target->next_slot()};
+    bool stored;
+    if (placed.page == home.page) {
+        placed = home;
+        stored = target->update_record(home.slot, record);
+    } else {
+        stored = target->insert_record(placed.slot, moved);
+    }
+    if (!stored) {
+        table->Release_page(target);
+        return false;
+    }
+    fsm.update(placed.page, target->freespace);
+    zones.add(placed.page, zone_values(row));
+    table->Update_page(placed.page, target);
+
+    bool at_home = from.page == home.page && from.slot == home.slot;
+    Page* page = table->Get_page(from.page);
+    if (page != nullptr) {
+        bool cleared = at_home ? page->update_record(from.slot, Page::forward_record(placed.page, placed.slot))
+                               : page->delete_record(from.slot);
+        if (!cleared) {
+            table->Release_page(page);
+            return false;
+        }
+        fsm.update(from.page, page->freespace);
+        table->Update_page(from.page, page);
+    }
+    if (!at_home && placed.page != home.page && (page = table->Get_page(home.page)) != nullptr) {
+        if (!page->update_record(home.slot, Page::forward_record(placed.page, placed.slot))) {
+            table->Release_page(page);
+            return false;
+        }
+        table->Update_page(home.page, page);
+    }
+    return true;
+}
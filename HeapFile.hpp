@@ -0,0 +1,70 @@
+#ifndef HEAPFILE_HPP
+#define HEAPFILE_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <optional>
+#include <functional>
+#include "Table.hpp"
+#include "page.hpp"
+#include "FreeSpaceMap.hpp"
+#include "ZoneMap.hpp"
+#include "BPlusTree.hpp"
+#include "HashIndex.hpp"
+#include "Expression.hpp"
+
+// Unordered collection of data pages 1..page_count of a table. New pages are appended
+// when no existing page has room for a row. The B+tree and hash indexes of the table
+// (<table>.<index>.BPT and .HIX) are opened with it and kept in step with every insert, update and
+// delete, as is the zone map that lets scans skip pages, though a delete only frees slots and
+// leaves page compaction, tighter zones and shrinking the file to vacuum(). A row that an update
+// makes too large for its page moves to another page behind a forwarding stub (see Page), so the
+// record id of a row never changes while it lives. Row ids are never issued twice, even once
+// deletes and vacuum() have freed the slots and pages that held them (see Table::Renew_ids).
+class HeapFile {
+public:
+    HeapFile(Table* table);
+
+    Page* allocate_page();
+    bool insert_tuple(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes);
+    std::vector<Tuple> select(const std::pair<std::string, std::string>& attribute);
+    std::vector<Tuple> select_range(const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high);
+    bool delete_tuples(const Expression* where);
+    bool vacuum(size_t& compacted, size_t& released);
+    bool update_tuples(const Expression* where, const std::vector<std::pair<std::string, std::string>>& assignments, size_t& updated);
+    void read_rows(const RecordId* rids, size_t count, const std::vector<std::string>& columns, std::vector<Tuple>& rows);
+    bool create_index(const std::string& name, const std::string& column, IndexKind kind = INDEX_BTREE);
+    Index* index_on(const std::string& column);
+    BPlusTree* tree_on(const std::string& column);
+    std::optional<std::vector<RecordId>> candidates(const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high);
+    bool may_match(int page_id, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) const;
+    Table* get_table() const { return table; }
+
+    static bool in_range(const std::string& value, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high);
+
+private:
+    static constexpr size_t ID_RANGE_PAGES = 8;
+
+    Table* table;
+    FreeSpaceMap fsm;
+    ZoneMap zones;
+    std::vector<std::unique_ptr<Index>> indexes;
+
+    void rebuild_fsm();
+    void rebuild_zones();
+    void load_indexes();
+    std::string index_path(const std::string& name, IndexKind kind) const;
+    std::vector<int> id_pages(long long low, long long high) const;
+    std::vector<RecordId> id_rids(long long low, long long high) const;
+    std::vector<RecordId> follow(const std::vector<RecordId>& rids);
+    std::vector<int> pages_for(const Expression* where);
+    Page* page_with_room(int needed, int excluded = 0);
+    bool relocate(const RecordId& from, const RecordId& home, Tuple& row, RecordId& placed);
+    std::vector<Tuple> fetch(const std::vector<RecordId>& rids, const std::function<bool(Tuple&)>& keep);
+    static std::string value_of(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes, const std::string& column);
+    static int record_size(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes);
+};
+
+#endif
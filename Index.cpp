@@ -0,0 +1,39 @@
+#include "Index.hpp"
+#include "BPlusTree.hpp"
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <cctype>
+
+Index::Index(BufferPool* pool, FileManager* files, const std::string& path)
+    : pool(pool), files(files), filePath(path), fileId(files->openFile(path)) {}
+
+
+std::unique_ptr<Index> Index::create(IndexKind kind, BufferPool* pool, FileManager* files, const std::string& path) {
+    switch (kind) {
+    case INDEX_HASH:
+        return std::make_unique<HashIndex>(pool, files, path);
+    case INDEX_BTREE:
+    default:
+        return std::make_unique<BPlusTree>(pool, files, path);
+    }
+}
+
+
+// Accepts the USING clause of CREATE INDEX in any case.
+bool Index::parse(const std::string& name, IndexKind& kind) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "btree" || lower == "b+tree") {
+        kind = INDEX_BTREE;
+    } else if (lower == "hash") {
+        kind = INDEX_HASH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+const char* Index::extension(IndexKind kind) {
+    return kind == INDEX_HASH ? ".HIX" : ".BPT";
+}
@@ -0,0 +1,66 @@
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "Buffer.hpp"
+#include "FileManager.hpp"
+
+// Where a row lives: data page id and slot in that page.
+struct RecordId {
+    int page;
+    int slot;
+};
+
+struct IndexEntry {
+    std::string key;
+    RecordId rid;
+};
+
+// One end of a key range; a missing bound means the range is open on that side.
+struct KeyBound {
+    std::string key;
+    bool inclusive = true;
+};
+
+
+enum IndexKind {
+    INDEX_BTREE,
+    INDEX_HASH
+};
+
+
+// Secondary index on one column of a table, kept in <db>/<table>.<index>.<extension> and read
+// through the buffer pool as INDEX_PAGEs. It maps column values to the record ids of the rows
+// holding them; a (value, record id) pair is stored once.
+class Index {
+public:
+    static constexpr size_t MAX_KEY_SIZE = 1024;
+
+    Index(BufferPool* pool, FileManager* files, const std::string& path);
+    virtual ~Index() = default;
+
+    virtual bool build(const std::string& column, std::vector<IndexEntry> entries) = 0;
+    virtual bool open() = 0;
+    virtual bool insert(const std::string& key, RecordId rid) = 0;
+    virtual bool erase(const std::string& key, RecordId rid) = 0;
+    virtual std::vector<RecordId> find(const std::string& key) = 0;
+    virtual IndexKind kind() const = 0;
+
+    const std::string& column() const { return indexColumn; }
+    const std::string& path() const { return filePath; }
+
+    static std::unique_ptr<Index> create(IndexKind kind, BufferPool* pool, FileManager* files, const std::string& path);
+    static bool parse(const std::string& name, IndexKind& kind);
+    static const char* extension(IndexKind kind);
+
+protected:
+    BufferPool* pool;
+    FileManager* files;
+    std::string filePath;
+    int fileId;
+    std::string indexColumn;
+};
+
+#endif
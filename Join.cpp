@@ -0,0 +1,320 @@
+#include "Join.hpp"
+#include "Expression.hpp"
+#include "HashIndex.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Slots are picked by the low bits of the hash, partitions by the high ones: the top
+// PARTITION_BITS at depth 0 and the next ones below them at each deeper split.
+static size_t partition_of(uint64_t hash, size_t depth) {
+    return static_cast<size_t>(hash >> (64 - HashJoin::PARTITION_BITS * (depth + 1))) % HashJoin::PARTITIONS;
+}
+
+static FILE* spill_file() {
+    FILE* file = std::tmpfile();
+    if (file == nullptr) {
+        throw std::runtime_error("HashJoin: cannot create a spill file");
+    }
+    return file;
+}
+
+static void write_row(FILE* file, Tuple& tuple) {
+    std::string data = tuple.Serialize();
+    uint32_t length = static_cast<uint32_t>(data.size());
+    if (std::fwrite(&length, sizeof(length), 1, file) != 1 || std::fwrite(data.data(), 1, data.size(), file) != data.size()) {
+        throw std::runtime_error("HashJoin: cannot write to a spill file");
+    }
+}
+
+static bool read_row(FILE* file, Tuple& tuple, std::string& buffer) {
+    uint32_t length;
+    if (std::fread(&length, sizeof(length), 1, file) != 1) {
+        return false;
+    }
+    buffer.resize(length);
+    if (std::fread(buffer.data(), 1, length, file) != length) {
+        return false;
+    }
+    tuple.Deserialize(buffer);
+    return true;
+}
+
+// What a build row takes in memory, roughly: its strings, the vectors holding them and its two
+// hash table slots.
+static size_t footprint(const std::string& key, const Tuple& tuple) {
+    size_t bytes = sizeof(std::string) + key.size() + sizeof(Tuple) + 4 * sizeof(uint64_t);
+    for (const auto& attr : tuple.attributes) {
+        bytes += sizeof(attr) + attr.first.size() + attr.second.second.size();
+    }
+    return bytes;
+}
+
+
+HashJoin::HashJoin(Side build, Side probe, bool buildLeft, bool integerKeys, size_t memoryBudget)
+    : build(std::move(build)), probe(std::move(probe)), buildLeft(buildLeft), integerKeys(integerKeys), memoryBudget(memoryBudget) {}
+
+HashJoin::~HashJoin() {
+    release();
+}
+
+void HashJoin::open() {
+    release();
+    build.input->open();
+    Tuple tuple;
+    std::string key;
+    while (build.input->next(tuple)) {
+        if (!key_of(tuple, build.column, key)) {
+            continue;
+        }
+        if (spilled()) {
+            write_row(pending[partition_of(HashIndex::hash(key), 0)].build, tuple);
+            continue;
+        }
+        rowBytes += footprint(key, tuple);
+        rows.push_back(Row{std::move(key), std::move(tuple)});
+        if (rowBytes > memoryBudget) {
+            spill();
+        }
+    }
+    build.input->close();
+
+    probe.input->open();
+    probeOpen = true;
+    if (spilled()) {
+        while (probe.input->next(tuple)) {
+            if (key_of(tuple, probe.column, key)) {
+                write_row(pending[partition_of(HashIndex::hash(key), 0)].probe, tuple);
+            }
+        }
+        probe.input->close();
+        probeOpen = false;
+        std::reverse(pending.begin(), pending.end());
+        load_next();
+    } else {
+        index();
+    }
+}
+
+bool HashJoin::next(Tuple& tuple) {
+    while (true) {
+        while (probing && slots[probeSlot].row != 0) {
+            const Slot& slot = slots[probeSlot];
+            probeSlot = (probeSlot + 1) & mask;
+            const Row& row = rows[slot.row - 1];
+            if (slot.hash == probeHash && row.key == probeKey) {
+                combine(row.tuple, probeRow, tuple);
+                return true;
+            }
+        }
+        probing = false;
+        if (!next_probe(probeRow)) {
+            return false;
+        }
+        if (key_of(probeRow, probe.column, probeKey)) {
+            probeHash = HashIndex::hash(probeKey);
+            probeSlot = probeHash & mask;
+            probing = true;
+        }
+    }
+}
+
+void HashJoin::close() {
+    if (probeOpen) {
+        probe.input->close();
+        probeOpen = false;
+    }
+    release();
+}
+
+// The join key of a row; integer keys are reduced to their canonical digits so equal numbers
+// hash alike.
+bool HashJoin::key_of(const Tuple& tuple, const std::string& column, std::string& key) const {
+    for (const auto& attr : tuple.attributes) {
+        if (attr.first != column) {
+            continue;
+        }
+        if (!integerKeys) {
+            key = attr.second.second;
+            return true;
+        }
+        int64_t value;
+        if (!Expression::parse_integer(attr.second.second, value)) {
+            return false;
+        }
+        key = std::to_string(value);
+        return true;
+    }
+    return false;
+}
+
+// Moves the build rows read so far to the partition files; the rest of the build input and all
+// of the probe input follow them there.
+void HashJoin::spill() {
+    partitioned = true;
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        pending.push_back(Partition{spill_file(), spill_file(), 0});
+    }
+    for (Row& row : rows) {
+        write_row(pending[partition_of(HashIndex::hash(row.key), 0)].build, row.tuple);
+    }
+    rows.clear();
+    rows.shrink_to_fit();
+    rowBytes = 0;
+}
+
+// Sizes the slot array to a power of two at least twice the row count, so probe runs stay short.
+void HashJoin::index() {
+    size_t capacity = 2;
+    while (capacity < rows.size() * 2) {
+        capacity *= 2;
+    }
+    slots.assign(capacity, Slot{0, 0});
+    mask = capacity - 1;
+    for (size_t i = 0; i < rows.size(); i++) {
+        uint64_t hash = HashIndex::hash(rows[i].key);
+        size_t position = hash & mask;
+        while (slots[position].row != 0) {
+            position = (position + 1) & mask;
+        }
+        slots[position] = Slot{hash, static_cast<uint32_t>(i + 1)};
+    }
+}
+
+bool HashJoin::next_probe(Tuple& tuple) {
+    if (!spilled()) {
+        return probe.input->next(tuple);
+    }
+    std::string buffer;
+    while (current.probe == nullptr || !read_row(current.probe, tuple, buffer)) {
+        if (!load_next()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Takes the next pending partition and reads its build rows into the hash table. One that
+// outgrows the budget before MAX_DEPTH is split by repartition() and its children taken in turn.
+bool HashJoin::load_next() {
+    Tuple tuple;
+    std::string key;
+    std::string buffer;
+    while (true) {
+        close_current();
+        if (pending.empty()) {
+            return false;
+        }
+        current = pending.back();
+        pending.pop_back();
+        std::rewind(current.build);
+        std::rewind(current.probe);
+        bool fits = true;
+        while (fits && read_row(current.build, tuple, buffer)) {
+            key_of(tuple, build.column, key);
+            rowBytes += footprint(key, tuple);
+            rows.push_back(Row{std::move(key), std::move(tuple)});
+            fits = rowBytes <= memoryBudget || current.depth + 1 == MAX_DEPTH;
+        }
+        if (fits) {
+            index();
+            return true;
+        }
+        repartition();
+    }
+}
+
+// Splits the current partition on the next bits of the hash: the build rows already loaded and
+// the rest of its build file, then its probe rows, which are dropped for children with no build
+// rows. A child that got every build row shares those bits on all its keys, as copies of one key
+// do, so splitting it further would not shrink it; it is joined in memory as it is.
+void HashJoin::repartition() {
+    size_t depth = current.depth + 1;
+    std::vector<Partition> children;
+    std::vector<size_t> counts(PARTITIONS, 0);
+    size_t total = 0;
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        children.push_back(Partition{spill_file(), nullptr, depth});
+    }
+    auto add = [&](const std::string& key, Tuple& tuple) {
+        size_t part = partition_of(HashIndex::hash(key), depth);
+        write_row(children[part].build, tuple);
+        counts[part]++;
+        total++;
+    };
+    for (Row& row : rows) {
+        add(row.key, row.tuple);
+    }
+    rows.clear();
+    rows.shrink_to_fit();
+    rowBytes = 0;
+    Tuple tuple;
+    std::string key;
+    std::string buffer;
+    while (read_row(current.build, tuple, buffer)) {
+        key_of(tuple, build.column, key);
+        add(key, tuple);
+    }
+    for (size_t i = 0; i < PARTITIONS; i++) {
+        if (counts[i] > 0) {
+            children[i].probe = spill_file();
+        }
+    }
+    while (read_row(current.probe, tuple, buffer)) {
+        key_of(tuple, probe.column, key);
+        FILE* file = children[partition_of(HashIndex::hash(key), depth)].probe;
+        if (file != nullptr) {
+            write_row(file, tuple);
+        }
+    }
+    close_current();
+    for (size_t i = PARTITIONS; i-- > 0;) {
+        if (counts[i] == 0) {
+            std::fclose(children[i].build);
+            continue;
+        }
+        if (counts[i] == total) {
+            children[i].depth = MAX_DEPTH - 1;
+        }
+        pending.push_back(children[i]);
+    }
+}
+
+void HashJoin::close_current() {
+    if (current.build != nullptr) {
+        std::fclose(current.build);
+    }
+    if (current.probe != nullptr) {
+        std::fclose(current.probe);
+    }
+    current = Partition();
+    rows.clear();
+    slots.clear();
+    rowBytes = 0;
+    mask = 0;
+}
+
+void HashJoin::combine(const Tuple& built, const Tuple& probed, Tuple& out) const {
+    const Tuple& left = buildLeft ? built : probed;
+    const Tuple& right = buildLeft ? probed : built;
+    const std::string& leftTable = buildLeft ? build.table : probe.table;
+    const std::string& rightTable = buildLeft ? probe.table : build.table;
+    out.attributes.clear();
+    out.attributes.reserve(left.attributes.size() + right.attributes.size());
+    for (const auto& attr : left.attributes) {
+        out.attributes.emplace_back(leftTable + "." + attr.first, attr.second);
+    }
+    for (const auto& attr : right.attributes) {
+        out.attributes.emplace_back(rightTable + "." + attr.first, attr.second);
+    }
+}
+
+void HashJoin::release() {
+    close_current();
+    for (Partition& part : pending) {
+        std::fclose(part.build);
+        std::fclose(part.probe);
+    }
+    pending.clear();
+    partitioned = false;
+    probing = false;
+}
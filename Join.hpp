@@ -0,0 +1,95 @@
+#ifndef JOIN_HPP
+#define JOIN_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include "Operator.hpp"
+
+// Equi-join of two inputs on one column of each. The build input is read into a hash table with
+// open addressing: a flat array of (hash, row) slots probed linearly, so a lookup touches one or
+// two cache lines before it compares a key. The probe input is then streamed through it and every
+// match comes out as one row holding both sides' columns, named table.column, the left table's
+// first. Integer keys are compared as numbers, other keys as stored; a key of neither side that
+// is not a plain integer of an integer column joins nothing.
+//
+// When the build rows outgrow the memory budget, both inputs are split by key hash into
+// PARTITIONS temporary files (grace hash join) and each pair of partitions is joined in memory
+// in turn. A partition still over budget is split again on the next PARTITION_BITS of the hash,
+// down to MAX_DEPTH levels; one that cannot be split, as one heavily repeated key makes it, is
+// joined in memory anyway.
+class HashJoin : public Operator {
+public:
+    static constexpr size_t PARTITION_BITS = 4;
+    static constexpr size_t PARTITIONS = size_t(1) << PARTITION_BITS;
+    static constexpr size_t MAX_DEPTH = 8;
+
+    struct Side {
+        std::unique_ptr<Operator> input;
+        std::string table;
+        std::string column;
+    };
+
+    HashJoin(Side build, Side probe, bool buildLeft, bool integerKeys, size_t memoryBudget);
+    ~HashJoin() override;
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "HashJoin"; }
+
+    bool spilled() const { return partitioned; }
+
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t row;
+    };
+
+    struct Row {
+        std::string key;
+        Tuple tuple;
+    };
+
+    // A pair of spill files holding the build and probe rows of one hash partition.
+    struct Partition {
+        FILE* build = nullptr;
+        FILE* probe = nullptr;
+        size_t depth = 0;
+    };
+
+    Side build;
+    Side probe;
+    bool buildLeft;
+    bool integerKeys;
+    size_t memoryBudget;
+
+    std::vector<Row> rows;
+    size_t rowBytes = 0;
+    std::vector<Slot> slots;
+    size_t mask = 0;
+
+    Tuple probeRow;
+    std::string probeKey;
+    uint64_t probeHash = 0;
+    size_t probeSlot = 0;
+    bool probing = false;
+    bool probeOpen = false;
+
+    bool partitioned = false;
+    std::vector<Partition> pending;
+    Partition current;
+
+    bool key_of(const Tuple& tuple, const std::string& column, std::string& key) const;
+    void spill();
+    void index();
+    bool next_probe(Tuple& tuple);
+    bool load_next();
+    void repartition();
+    void close_current();
+    void combine(const Tuple& built, const Tuple& probed, Tuple& out) const;
+    void release();
+};
+
+#endif
@@ -0,0 +1,401 @@
+#include "Kernels.hpp"
+#include <algorithm>
+#include <climits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#endif
+
+namespace kernels {
+
+enum Level {
+    LEVEL_SCALAR,
+    LEVEL_SSE42,
+    LEVEL_AVX2
+};
+
+static Level detect() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return LEVEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return LEVEL_SSE42;
+    }
+#endif
+    return LEVEL_SCALAR;
+}
+
+static const Level supported = detect();
+static Level level = supported;
+
+const char* simd_level() {
+    return level == LEVEL_AVX2 ? "avx2" : (level == LEVEL_SSE42 ? "sse4.2" : "scalar");
+}
+
+// Caps the kernels at a narrower instruction set, e.g. to compare them in a benchmark.
+bool set_level(const std::string& name) {
+    Level wanted = name == "avx2" ? LEVEL_AVX2 : (name == "sse4.2" ? LEVEL_SSE42 : LEVEL_SCALAR);
+    if (name != "avx2" && name != "sse4.2" && name != "scalar") {
+        return false;
+    }
+    if (wanted > supported) {
+        return false;
+    }
+    level = wanted;
+    return true;
+}
+
+bool parse_op(const std::string& op, CompareOp& cmp) {
+    if (op == "=") {
+        cmp = CMP_EQ;
+    } else if (op == "!=" || op == "<>") {
+        cmp = CMP_NE;
+    } else if (op == "<") {
+        cmp = CMP_LT;
+    } else if (op == "<=") {
+        cmp = CMP_LE;
+    } else if (op == ">") {
+        cmp = CMP_GT;
+    } else if (op == ">=") {
+        cmp = CMP_GE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <CompareOp OP>
+static inline bool holds(int64_t value, int64_t constant) {
+    switch (OP) {
+    case CMP_EQ: return value == constant;
+    case CMP_NE: return value != constant;
+    case CMP_LT: return value < constant;
+    case CMP_LE: return value <= constant;
+    case CMP_GT: return value > constant;
+    case CMP_GE: return value >= constant;
+    }
+    return false;
+}
+
+bool compare(int64_t value, CompareOp op, int64_t constant) {
+    switch (op) {
+    case CMP_EQ: return holds<CMP_EQ>(value, constant);
+    case CMP_NE: return holds<CMP_NE>(value, constant);
+    case CMP_LT: return holds<CMP_LT>(value, constant);
+    case CMP_LE: return holds<CMP_LE>(value, constant);
+    case CMP_GT: return holds<CMP_GT>(value, constant);
+    case CMP_GE: return holds<CMP_GE>(value, constant);
+    }
+    return false;
+}
+
+// The scalar versions write every position and advance only past qualifying ones, so the
+// loop has no data-dependent branch.
+template <CompareOp OP>
+static size_t select_scalar(const int64_t* values, size_t count, int64_t constant, uint32_t* out) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++) {
+        out[k] = static_cast<uint32_t>(i);
+        k += holds<OP>(values[i], constant);
+    }
+    return k;
+}
+
+template <CompareOp OP>
+static size_t refine_scalar(const int64_t* values, uint32_t* selection, size_t count, int64_t constant) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t position = selection[i];
+        selection[k] = position;
+        k += holds<OP>(values[position], constant);
+    }
+    return k;
+}
+
+static int64_t sum_scalar(const int64_t* values, size_t count) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += static_cast<uint64_t>(values[i]);
+    }
+    return static_cast<int64_t>(total);
+}
+
+static int64_t sum_selected_scalar(const int64_t* values, const uint32_t* selection, size_t count) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += static_cast<uint64_t>(values[selection[i]]);
+    }
+    return static_cast<int64_t>(total);
+}
+
+#ifdef KERNELS_X86
+
+// pshufb masks that pack the 32-bit lanes picked by a 4-bit mask to the front.
+struct CompactTable {
+    alignas(16) uint8_t shuffle[16][16];
+
+    CompactTable() {
+        for (int mask = 0; mask < 16; mask++) {
+            int out = 0;
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    for (int b = 0; b < 4; b++) {
+                        shuffle[mask][out * 4 + b] = static_cast<uint8_t>(lane * 4 + b);
+                    }
+                    out++;
+                }
+            }
+            for (int b = out * 4; b < 16; b++) {
+                shuffle[mask][b] = 0x80;
+            }
+        }
+    }
+};
+
+static const CompactTable compact;
+
+template <CompareOp OP>
+__attribute__((target("avx2"))) static inline int mask_avx2(__m256i values, __m256i constant) {
+    __m256i result;
+    bool negate = OP == CMP_NE || OP == CMP_LE || OP == CMP_GE;
+    if (OP == CMP_EQ || OP == CMP_NE) {
+        result = _mm256_cmpeq_epi64(values, constant);
+    } else if (OP == CMP_GT || OP == CMP_LE) {
+        result = _mm256_cmpgt_epi64(values, constant);
+    } else {
+        result = _mm256_cmpgt_epi64(constant, values);
+    }
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(result));
+    return negate ? mask ^ 0xF : mask;
+}
+
+template <CompareOp OP>
+__attribute__((target("avx2"))) static size_t select_avx2(const int64_t* values, size_t count, int64_t constant, uint32_t* out) {
+    __m256i c = _mm256_set1_epi64x(constant);
+    __m128i positions = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i step = _mm_set1_epi32(4);
+    size_t k = 0, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int mask = mask_avx2<OP>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)), c);
+        __m128i packed = _mm_shuffle_epi8(positions, _mm_load_si128(reinterpret_cast<const __m128i*>(compact.shuffle[mask])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k), packed);
+        k += __builtin_popcount(mask);
+        positions = _mm_add_epi32(positions, step);
+    }
+    for (; i < count; i++) {
+        out[k] = static_cast<uint32_t>(i);
+        k += holds<OP>(values[i], constant);
+    }
+    return k;
+}
+
+// Gathers the selected values four at a time; the packed positions never overtake the ones
+// still to be read.
+template <CompareOp OP>
+__attribute__((target("avx2"))) static size_t refine_avx2(const int64_t* values, uint32_t* selection, size_t count, int64_t constant) {
+    __m256i c = _mm256_set1_epi64x(constant);
+    size_t k = 0, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i positions = _mm_loadu_si128(reinterpret_cast<const __m128i*>(selection + i));
+        __m256i gathered = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(values), positions, 8);
+        int mask = mask_avx2<OP>(gathered, c);
+        __m128i packed = _mm_shuffle_epi8(positions, _mm_load_si128(reinterpret_cast<const __m128i*>(compact.shuffle[mask])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(selection + k), packed);
+        k += __builtin_popcount(mask);
+    }
+    for (; i < count; i++) {
+        uint32_t position = selection[i];
+        selection[k] = position;
+        k += holds<OP>(values[position], constant);
+    }
+    return k;
+}
+
+template <CompareOp OP>
+__attribute__((target("sse4.2"))) static size_t select_sse42(const int64_t* values, size_t count, int64_t constant, uint32_t* out) {
+    __m128i c = _mm_set1_epi64x(constant);
+    bool negate = OP == CMP_NE || OP == CMP_LE || OP == CMP_GE;
+    size_t k = 0, i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i result;
+        if (OP == CMP_EQ || OP == CMP_NE) {
+            result = _mm_cmpeq_epi64(v, c);
+        } else if (OP == CMP_GT || OP == CMP_LE) {
+            result = _mm_cmpgt_epi64(v, c);
+        } else {
+            result = _mm_cmpgt_epi64(c, v);
+        }
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(result));
+        mask = negate ? mask ^ 0x3 : mask;
+        out[k] = static_cast<uint32_t>(i);
+        k += mask & 1;
+        out[k] = static_cast<uint32_t>(i + 1);
+        k += (mask >> 1) & 1;
+    }
+    for (; i < count; i++) {
+        out[k] = static_cast<uint32_t>(i);
+        k += holds<OP>(values[i], constant);
+    }
+    return k;
+}
+
+__attribute__((target("avx2"))) static int64_t sum_avx2(const int64_t* values, size_t count) {
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        total = _mm256_add_epi64(total, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+    return static_cast<int64_t>(static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3] +
+                                static_cast<uint64_t>(sum_scalar(values + i, count - i)));
+}
+
+__attribute__((target("avx2"))) static int64_t sum_selected_avx2(const int64_t* values, const uint32_t* selection, size_t count) {
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i positions = _mm_loadu_si128(reinterpret_cast<const __m128i*>(selection + i));
+        total = _mm256_add_epi64(total, _mm256_i32gather_epi64(reinterpret_cast<const long long*>(values), positions, 8));
+    }
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+    return static_cast<int64_t>(static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3] +
+                                static_cast<uint64_t>(sum_selected_scalar(values, selection + i, count - i)));
+}
+
+__attribute__((target("sse4.2"))) static int64_t sum_sse42(const int64_t* values, size_t count) {
+    __m128i total = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        total = _mm_add_epi64(total, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+    }
+    alignas(16) int64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+    return static_cast<int64_t>(static_cast<uint64_t>(lanes[0]) + lanes[1] + static_cast<uint64_t>(sum_scalar(values + i, count - i)));
+}
+
+template <bool MAX>
+__attribute__((target("avx2"))) static int64_t extreme_avx2(const int64_t* values, size_t count) {
+    int64_t best = MAX ? INT64_MIN : INT64_MAX;
+    size_t i = 0;
+    if (count >= 4) {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+        for (i = 4; i + 4 <= count; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            __m256i replace = MAX ? _mm256_cmpgt_epi64(v, acc) : _mm256_cmpgt_epi64(acc, v);
+            acc = _mm256_blendv_epi8(acc, v, replace);
+        }
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        for (int64_t lane : lanes) {
+            best = MAX ? std::max(best, lane) : std::min(best, lane);
+        }
+    }
+    for (; i < count; i++) {
+        best = MAX ? std::max(best, values[i]) : std::min(best, values[i]);
+    }
+    return best;
+}
+
+#endif
+
+template <CompareOp OP>
+static size_t select_op(const int64_t* values, size_t count, int64_t constant, uint32_t* out) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return select_avx2<OP>(values, count, constant, out);
+    }
+    if (level == LEVEL_SSE42) {
+        return select_sse42<OP>(values, count, constant, out);
+    }
+#endif
+    return select_scalar<OP>(values, count, constant, out);
+}
+
+template <CompareOp OP>
+static size_t refine_op(const int64_t* values, uint32_t* selection, size_t count, int64_t constant) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return refine_avx2<OP>(values, selection, count, constant);
+    }
+#endif
+    return refine_scalar<OP>(values, selection, count, constant);
+}
+
+size_t select(const int64_t* values, size_t count, CompareOp op, int64_t constant, uint32_t* out) {
+    switch (op) {
+    case CMP_EQ: return select_op<CMP_EQ>(values, count, constant, out);
+    case CMP_NE: return select_op<CMP_NE>(values, count, constant, out);
+    case CMP_LT: return select_op<CMP_LT>(values, count, constant, out);
+    case CMP_LE: return select_op<CMP_LE>(values, count, constant, out);
+    case CMP_GT: return select_op<CMP_GT>(values, count, constant, out);
+    case CMP_GE: return select_op<CMP_GE>(values, count, constant, out);
+    }
+    return 0;
+}
+
+size_t refine(const int64_t* values, uint32_t* selection, size_t count, CompareOp op, int64_t constant) {
+    switch (op) {
+    case CMP_EQ: return refine_op<CMP_EQ>(values, selection, count, constant);
+    case CMP_NE: return refine_op<CMP_NE>(values, selection, count, constant);
+    case CMP_LT: return refine_op<CMP_LT>(values, selection, count, constant);
+    case CMP_LE: return refine_op<CMP_LE>(values, selection, count, constant);
+    case CMP_GT: return refine_op<CMP_GT>(values, selection, count, constant);
+    case CMP_GE: return refine_op<CMP_GE>(values, selection, count, constant);
+    }
+    return 0;
+}
+
+int64_t sum(const int64_t* values, size_t count) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return sum_avx2(values, count);
+    }
+    if (level == LEVEL_SSE42) {
+        return sum_sse42(values, count);
+    }
+#endif
+    return sum_scalar(values, count);
+}
+
+int64_t sum_selected(const int64_t* values, const uint32_t* selection, size_t count) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return sum_selected_avx2(values, selection, count);
+    }
+#endif
+    return sum_selected_scalar(values, selection, count);
+}
+
+int64_t min(const int64_t* values, size_t count) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return extreme_avx2<false>(values, count);
+    }
+#endif
+    int64_t best = INT64_MAX;
+    for (size_t i = 0; i < count; i++) {
+        best = std::min(best, values[i]);
+    }
+    return best;
+}
+
+int64_t max(const int64_t* values, size_t count) {
+#ifdef KERNELS_X86
+    if (level == LEVEL_AVX2) {
+        return extreme_avx2<true>(values, count);
+    }
+#endif
+    int64_t best = INT64_MIN;
+    for (size_t i = 0; i < count; i++) {
+        best = std::max(best, values[i]);
+    }
+    return best;
+}
+
+}
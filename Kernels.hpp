@@ -0,0 +1,42 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum CompareOp {
+    CMP_EQ,
+    CMP_NE,
+    CMP_LT,
+    CMP_LE,
+    CMP_GT,
+    CMP_GE
+};
+
+// Comparison and aggregate kernels over int64 columns. Each has an AVX2, an SSE4.2 and a scalar
+// version; the widest one the CPU supports is chosen once at startup. Comparisons produce
+// selection vectors: the positions of the qualifying values, in increasing order.
+namespace kernels {
+
+bool parse_op(const std::string& op, CompareOp& cmp);
+const char* simd_level();
+bool set_level(const std::string& name);
+
+// values op constant for a single value, with the same semantics as the batch kernels.
+bool compare(int64_t value, CompareOp op, int64_t constant);
+
+// Positions i < count with values[i] op constant, written to out (room for count entries).
+size_t select(const int64_t* values, size_t count, CompareOp op, int64_t constant, uint32_t* out);
+
+// Keeps the positions of selection whose value satisfies op, in place; returns how many remain.
+size_t refine(const int64_t* values, uint32_t* selection, size_t count, CompareOp op, int64_t constant);
+
+int64_t sum(const int64_t* values, size_t count);
+int64_t sum_selected(const int64_t* values, const uint32_t* selection, size_t count);
+int64_t min(const int64_t* values, size_t count);
+int64_t max(const int64_t* values, size_t count);
+
+}
+
+#endif
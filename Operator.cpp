@@ -0,0 +1,164 @@
+#include "Operator.hpp"
+#include "page.hpp"
+
+SeqScan::SeqScan(HeapFile* heap, std::string column, std::optional<KeyBound> low, std::optional<KeyBound> high,
+                 std::vector<std::string> columns)
+    : heap(heap), column(std::move(column)), low(std::move(low)), high(std::move(high)), columns(std::move(columns)) {}
+
+void SeqScan::open() {
+    pageId = 0;
+    rows.clear();
+    position = 0;
+    Table* table = heap->get_table();
+    if (table->backend == IO_MMAP) {
+        table->files->advise(table->file_id, ACCESS_SEQUENTIAL);
+    }
+}
+
+bool SeqScan::next(Tuple& tuple) {
+    Table* table = heap->get_table();
+    while (position == rows.size()) {
+        rows.clear();
+        position = 0;
+        if (++pageId > table->page_count) {
+            pageId = table->page_count;
+            return false;
+        }
+        if ((low || high) && !heap->may_match(pageId, column, low, high)) {
+            continue;
+        }
+        Page* page = table->Read_page(pageId);
+        if (page == nullptr) {
+            continue;
+        }
+        int slots = page->slot_count();
+        for (int slot = 0; slot < slots; slot++) {
+            rows.emplace_back();
+            if (!page->read_tuple(slot, columns, rows.back())) {
+                rows.pop_back();
+            }
+        }
+        table->Release_page(page);
+    }
+    tuple = std::move(rows[position++]);
+    return true;
+}
+
+void SeqScan::close() {
+    rows.clear();
+    position = 0;
+}
+
+
+IndexScan::IndexScan(HeapFile* heap, std::vector<RecordId> rids, std::vector<std::string> columns)
+    : heap(heap), rids(std::move(rids)), columns(std::move(columns)) {}
+
+void IndexScan::open() {
+    nextRid = 0;
+    rows.clear();
+    position = 0;
+}
+
+// Decodes the rows of the next run of record ids that share a page.
+bool IndexScan::next(Tuple& tuple) {
+    while (position == rows.size()) {
+        rows.clear();
+        position = 0;
+        if (nextRid == rids.size()) {
+            return false;
+        }
+        int pageId = rids[nextRid].page;
+        size_t end = nextRid;
+        while (end < rids.size() && rids[end].page == pageId) {
+            end++;
+        }
+        heap->read_rows(&rids[nextRid], end - nextRid, columns, rows);
+        nextRid = end;
+    }
+    tuple = std::move(rows[position++]);
+    return true;
+}
+
+void IndexScan::close() {
+    rows.clear();
+    position = 0;
+}
+
+
+Filter::Filter(std::unique_ptr<Operator> child, std::function<bool(Tuple&)> predicate)
+    : child(std::move(child)), predicate(std::move(predicate)) {}
+
+void Filter::open() {
+    child->open();
+}
+
+bool Filter::next(Tuple& tuple) {
+    while (child->next(tuple)) {
+        if (predicate(tuple)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Filter::close() {
+    child->close();
+}
+
+
+Project::Project(std::unique_ptr<Operator> child, std::vector<std::string> columns)
+    : child(std::move(child)), columns(std::move(columns)) {}
+
+void Project::open() {
+    child->open();
+}
+
+bool Project::next(Tuple& tuple) {
+    Tuple row;
+    if (!child->next(row)) {
+        return false;
+    }
+    tuple.attributes.clear();
+    for (const std::string& column : columns) {
+        for (auto& attr : row.attributes) {
+            if (attr.first == column) {
+                tuple.attributes.push_back(std::move(attr));
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void Project::close() {
+    child->close();
+}
+
+
+Limit::Limit(std::unique_ptr<Operator> child, size_t count)
+    : child(std::move(child)), count(count) {}
+
+void Limit::open() {
+    produced = 0;
+    child->open();
+    childOpen = true;
+}
+
+bool Limit::next(Tuple& tuple) {
+    if (produced == count) {
+        close();
+        return false;
+    }
+    if (!child->next(tuple)) {
+        return false;
+    }
+    produced++;
+    return true;
+}
+
+void Limit::close() {
+    if (childOpen) {
+        child->close();
+        childOpen = false;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef OPERATOR_HPP
+#define OPERATOR_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <functional>
+#include "HeapFile.hpp"
+#include "tuple.hpp"
+
+// Pull-based (Volcano) query operator: open() prepares it, each next() produces one row until
+// it returns false, and close() releases what it holds. Operators own their children, so a
+// plan is a tree handed around by its root. Rows are moved, never copied, up the tree.
+class Operator {
+public:
+    virtual ~Operator() = default;
+
+    virtual void open() = 0;
+    virtual bool next(Tuple& tuple) = 0;
+    virtual void close() = 0;
+    virtual std::string name() const = 0;
+};
+
+
+// Reads the table page by page. A page is decoded into a buffer and unlatched before its rows
+// are returned, so a scan holds at most one page of rows and no latch between calls. Pages the
+// zone map rules out for the optional column bounds are skipped unread. Given columns, a row
+// carries just those, in that order, and the rest of each record is never copied out.
+class SeqScan : public Operator {
+public:
+    SeqScan(HeapFile* heap, std::string column = "", std::optional<KeyBound> low = std::nullopt,
+            std::optional<KeyBound> high = std::nullopt, std::vector<std::string> columns = {});
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "SeqScan"; }
+
+private:
+    HeapFile* heap;
+    std::string column;
+    std::optional<KeyBound> low;
+    std::optional<KeyBound> high;
+    std::vector<std::string> columns;
+    uint32_t pageId = 0;
+    std::vector<Tuple> rows;
+    size_t position = 0;
+};
+
+
+// Reads the rows behind record ids from an index or the id directory, one page at a time in
+// the order given, decoding just the given columns as SeqScan does.
+class IndexScan : public Operator {
+public:
+    IndexScan(HeapFile* heap, std::vector<RecordId> rids, std::vector<std::string> columns = {});
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "IndexScan"; }
+
+private:
+    HeapFile* heap;
+    std::vector<RecordId> rids;
+    std::vector<std::string> columns;
+    size_t nextRid = 0;
+    std::vector<Tuple> rows;
+    size_t position = 0;
+};
+
+
+class Filter : public Operator {
+public:
+    Filter(std::unique_ptr<Operator> child, std::function<bool(Tuple&)> predicate);
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "Filter"; }
+
+private:
+    std::unique_ptr<Operator> child;
+    std::function<bool(Tuple&)> predicate;
+};
+
+
+// Keeps the listed columns, in that order; columns a row does not have are left out.
+class Project : public Operator {
+public:
+    Project(std::unique_ptr<Operator> child, std::vector<std::string> columns);
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "Project"; }
+
+private:
+    std::unique_ptr<Operator> child;
+    std::vector<std::string> columns;
+};
+
+
+// Stops after count rows and closes its input right away, so a scan below it ends early.
+class Limit : public Operator {
+public:
+    Limit(std::unique_ptr<Operator> child, size_t count);
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "Limit"; }
+
+private:
+    std::unique_ptr<Operator> child;
+    size_t count;
+    size_t produced = 0;
+    bool childOpen = false;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "Parallel.hpp"
+#include <algorithm>
+
+ParallelScan::ParallelScan(HeapFile* heap, MorselPipeline pipeline, size_t parallelism, std::vector<std::string> columns)
+    : heap(heap), pipeline(std::move(pipeline)), parallelism(std::max<size_t>(parallelism, 1)), columns(std::move(columns)) {}
+
+ParallelScan::~ParallelScan() {
+    close();
+}
+
+void ParallelScan::open() {
+    pages = heap->get_table()->page_count;
+    results = std::vector<Morsel>(morsels(pages));
+    submitted = 0;
+    current = 0;
+    position = 0;
+    cancelled = false;
+    std::lock_guard<std::mutex> guard(latch);
+    while (submitted < std::min(parallelism, results.size())) {
+        submit();
+    }
+}
+
+// Called with latch held.
+void ParallelScan::submit() {
+    if (submitted == results.size()) {
+        return;
+    }
+    size_t morsel = submitted++;
+    running++;
+    ThreadPool::shared().submit([this, morsel] { scan(morsel); });
+}
+
+// Runs on a pool thread. Rows are decoded there too, so the consumer only moves them along.
+void ParallelScan::scan(size_t morsel) {
+    std::vector<Tuple> rows;
+    if (!cancelled) {
+        uint32_t first = static_cast<uint32_t>(morsel) * MORSEL_PAGES + 1;
+        std::unique_ptr<BatchOperator> batches = pipeline(first, std::min(first + MORSEL_PAGES - 1, pages));
+        Batch batch;
+        batches->open();
+        while (!cancelled && batches->next(batch)) {
+            for (size_t i = 0; i < batch.selected; i++) {
+                uint32_t row = batch.dense ? static_cast<uint32_t>(i) : batch.selection[i];
+                rows.emplace_back();
+                rows.back().Deserialize(batch.bytes.data() + batch.offsets[row], batch.offsets[row + 1] - batch.offsets[row], columns);
+            }
+        }
+        batches->close();
+    }
+    std::lock_guard<std::mutex> guard(latch);
+    results[morsel].rows = std::move(rows);
+    results[morsel].done = true;
+    running--;
+    finished.notify_all();
+}
+
+bool ParallelScan::next(Tuple& tuple) {
+    while (current < results.size()) {
+        Morsel& morsel = results[current];
+        {
+            std::unique_lock<std::mutex> lock(latch);
+            finished.wait(lock, [&] { return morsel.done; });
+        }
+        if (position < morsel.rows.size()) {
+            tuple = std::move(morsel.rows[position++]);
+            return true;
+        }
+        std::vector<Tuple>().swap(morsel.rows);
+        current++;
+        position = 0;
+        std::lock_guard<std::mutex> guard(latch);
+        submit();
+    }
+    return false;
+}
+
+// Morsels still running see the flag and stop early; they must finish before results go away.
+void ParallelScan::close() {
+    cancelled = true;
+    std::unique_lock<std::mutex> lock(latch);
+    finished.wait(lock, [this] { return running == 0; });
+    results.clear();
+}
@@ -0,0 +1,61 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include "Operator.hpp"
+#include "Vectorized.hpp"
+#include "ThreadPool.hpp"
+
+// Builds the batch pipeline (scan, then filters) for one morsel: the pages first..last.
+using MorselPipeline = std::function<std::unique_ptr<BatchOperator>(uint32_t first, uint32_t last)>;
+
+// Splits the table into morsels of MORSEL_PAGES pages and runs the pipeline of each on the shared
+// thread pool, at most parallelism morsels at a time. Rows come out in table order: next() hands
+// over the rows of one morsel after another, and each morsel consumed lets the next one start,
+// so no more than parallelism morsels of rows are buffered. Rows are decoded to just the given
+// columns when there are any.
+class ParallelScan : public Operator {
+public:
+    static constexpr uint32_t MORSEL_PAGES = 32;
+
+    ParallelScan(HeapFile* heap, MorselPipeline pipeline, size_t parallelism, std::vector<std::string> columns = {});
+    ~ParallelScan() override;
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "ParallelScan"; }
+
+    // How many morsels a table of that many pages splits into.
+    static size_t morsels(uint32_t pages) { return (pages + MORSEL_PAGES - 1) / MORSEL_PAGES; }
+
+private:
+    struct Morsel {
+        std::vector<Tuple> rows;
+        bool done = false;
+    };
+
+    HeapFile* heap;
+    MorselPipeline pipeline;
+    size_t parallelism;
+    std::vector<std::string> columns;
+    uint32_t pages = 0;
+    std::vector<Morsel> results;
+    size_t submitted = 0;
+    size_t current = 0;
+    size_t position = 0;
+    size_t running = 0;
+    std::atomic<bool> cancelled{false};
+    std::mutex latch;
+    std::condition_variable finished;
+
+    void submit();
+    void scan(size_t morsel);
+};
+
+#endif
@@ -0,0 +1,308 @@
+#include "ReplacementPolicy.hpp"
+#include <algorithm>
+
+std::unique_ptr<ReplacementPolicy> ReplacementPolicy::create(ReplacementKind kind, int frames) {
+    switch (kind) {
+    case POLICY_LRU_K:
+        return std::make_unique<LruKPolicy>(frames);
+    case POLICY_2Q:
+        return std::make_unique<TwoQPolicy>(frames);
+    case POLICY_ARC:
+        return std::make_unique<ArcPolicy>(frames);
+    case POLICY_CLOCK:
+    default:
+        return std::make_unique<ClockPolicy>(frames);
+    }
+}
+
+bool ReplacementPolicy::parse(const std::string& name, ReplacementKind& kind) {
+    if (name == "clock") {
+        kind = POLICY_CLOCK;
+    } else if (name == "lru-k" || name == "lru2" || name == "lru-2") {
+        kind = POLICY_LRU_K;
+    } else if (name == "2q") {
+        kind = POLICY_2Q;
+    } else if (name == "arc") {
+        kind = POLICY_ARC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+ClockPolicy::ClockPolicy(int frames) : referenced(frames, false), resident(frames, false) {}
+
+void ClockPolicy::loaded(int frame, const PageKey&) {
+    resident[frame] = true;
+    referenced[frame] = true;
+}
+
+void ClockPolicy::accessed(int frame) {
+    referenced[frame] = true;
+}
+
+void ClockPolicy::evicted(int frame) {
+    resident[frame] = false;
+    referenced[frame] = false;
+}
+
+int ClockPolicy::victim(const PageKey&, const std::function<bool(int)>& evictable) {
+    int frames = static_cast<int>(resident.size());
+    for (int step = 0; step < 2 * frames; step++) {
+        int frame = hand;
+        hand = (hand + 1) % frames;
+        if (!resident[frame]) {
+            continue;
+        }
+        if (referenced[frame]) {
+            referenced[frame] = false;
+            continue;
+        }
+        if (evictable(frame)) {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+
+LruKPolicy::LruKPolicy(int frames)
+    : history(frames), keys(frames), resident(frames, false), retainLimit(std::max(frames, 1)) {}
+
+LruKPolicy::Rank LruKPolicy::rank(int frame) const {
+    const History& h = history[frame];
+    return {{h.previous != 0, h.previous != 0 ? h.previous : h.last}, frame};
+}
+
+void LruKPolicy::touch(int frame) {
+    order.erase(rank(frame));
+    history[frame].previous = history[frame].last;
+    history[frame].last = ++now;
+    order.insert(rank(frame));
+}
+
+void LruKPolicy::loaded(int frame, const PageKey& key) {
+    keys[frame] = key;
+    auto it = retained.find(key);
+    if (it != retained.end()) {
+        history[frame] = it->second;
+        retained.erase(it);
+    } else {
+        history[frame] = History();
+    }
+    resident[frame] = true;
+    touch(frame);
+}
+
+void LruKPolicy::accessed(int frame) {
+    if (resident[frame]) {
+        touch(frame);
+    }
+}
+
+void LruKPolicy::evicted(int frame) {
+    if (!resident[frame]) {
+        return;
+    }
+    order.erase(rank(frame));
+    resident[frame] = false;
+
+    retained[keys[frame]] = history[frame];
+    retainedOrder.push_back(keys[frame]);
+    while (retained.size() > retainLimit && !retainedOrder.empty()) {
+        retained.erase(retainedOrder.front());
+        retainedOrder.pop_front();
+    }
+    if (retainedOrder.size() > 4 * retainLimit) {
+        std::deque<PageKey> live;
+        for (const PageKey& key : retainedOrder) {
+            if (retained.count(key)) {
+                live.push_back(key);
+            }
+        }
+        retainedOrder.swap(live);
+    }
+}
+
+int LruKPolicy::victim(const PageKey&, const std::function<bool(int)>& evictable) {
+    for (const Rank& candidate : order) {
+        if (evictable(candidate.second)) {
+            return candidate.second;
+        }
+    }
+    return -1;
+}
+
+
+TwoQPolicy::TwoQPolicy(int frames)
+    : queue(frames, NONE), keys(frames), position(frames),
+      kin(std::max(frames / 4, 1)), kout(std::max(frames / 2, 1)) {}
+
+void TwoQPolicy::loaded(int frame, const PageKey& key) {
+    keys[frame] = key;
+    auto ghost = ghosts.find(key);
+    if (ghost != ghosts.end()) {
+        a1out.erase(ghost->second);
+        ghosts.erase(ghost);
+        am.push_front(frame);
+        position[frame] = am.begin();
+        queue[frame] = AM;
+    } else {
+        a1in.push_back(frame);
+        position[frame] = std::prev(a1in.end());
+        queue[frame] = A1IN;
+    }
+}
+
+// A1in only overflows Kin while the pool is filling its empty frames; a page hit there has
+// outlived its correlated-reference window and goes straight to Am.
+void TwoQPolicy::accessed(int frame) {
+    if (queue[frame] == AM) {
+        am.splice(am.begin(), am, position[frame]);
+    } else if (queue[frame] == A1IN && a1in.size() > kin) {
+        am.splice(am.begin(), a1in, position[frame]);
+        queue[frame] = AM;
+    }
+}
+
+void TwoQPolicy::evicted(int frame) {
+    if (queue[frame] == A1IN) {
+        a1in.erase(position[frame]);
+        a1out.push_back(keys[frame]);
+        ghosts[keys[frame]] = std::prev(a1out.end());
+        if (a1out.size() > kout) {
+            ghosts.erase(a1out.front());
+            a1out.pop_front();
+        }
+    } else if (queue[frame] == AM) {
+        am.erase(position[frame]);
+    }
+    queue[frame] = NONE;
+}
+
+int TwoQPolicy::victim(const PageKey&, const std::function<bool(int)>& evictable) {
+    bool fromA1in = a1in.size() > kin || am.empty();
+    for (int pass = 0; pass < 2; pass++) {
+        if (fromA1in) {
+            for (int frame : a1in) {
+                if (evictable(frame)) {
+                    return frame;
+                }
+            }
+        } else {
+            for (auto it = am.rbegin(); it != am.rend(); ++it) {
+                if (evictable(*it)) {
+                    return *it;
+                }
+            }
+        }
+        fromA1in = !fromA1in;
+    }
+    return -1;
+}
+
+
+void ArcPolicy::Ghosts::push(const PageKey& key) {
+    order.push_front(key);
+    index[key] = order.begin();
+}
+
+void ArcPolicy::Ghosts::erase(const PageKey& key) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        order.erase(it->second);
+        index.erase(it);
+    }
+}
+
+void ArcPolicy::Ghosts::popOldest() {
+    index.erase(order.back());
+    order.pop_back();
+}
+
+ArcPolicy::ArcPolicy(int frames)
+    : capacity(std::max(frames, 1)), list(frames, NONE), keys(frames), position(frames) {}
+
+// A miss on a ghost shifts the target before the replacement decision is made, as in the paper.
+size_t ArcPolicy::adaptedTarget(const PageKey& key) const {
+    if (b1.contains(key)) {
+        size_t delta = std::max<size_t>(b2.size() / b1.size(), 1);
+        return std::min(capacity, target + delta);
+    }
+    if (b2.contains(key)) {
+        size_t delta = std::max<size_t>(b1.size() / b2.size(), 1);
+        return target - std::min(target, delta);
+    }
+    return target;
+}
+
+void ArcPolicy::loaded(int frame, const PageKey& key) {
+    keys[frame] = key;
+    bool ghostHit = b1.contains(key) || b2.contains(key);
+    target = adaptedTarget(key);
+    if (ghostHit) {
+        b1.erase(key);
+        b2.erase(key);
+        t2.push_front(frame);
+        position[frame] = t2.begin();
+        list[frame] = T2;
+    } else {
+        t1.push_front(frame);
+        position[frame] = t1.begin();
+        list[frame] = T1;
+    }
+    trimGhosts();
+}
+
+void ArcPolicy::accessed(int frame) {
+    if (list[frame] == T1) {
+        t2.splice(t2.begin(), t1, position[frame]);
+        list[frame] = T2;
+    } else if (list[frame] == T2) {
+        t2.splice(t2.begin(), t2, position[frame]);
+    }
+}
+
+void ArcPolicy::evicted(int frame) {
+    if (list[frame] == T1) {
+        t1.erase(position[frame]);
+        b1.push(keys[frame]);
+    } else if (list[frame] == T2) {
+        t2.erase(position[frame]);
+        b2.push(keys[frame]);
+    }
+    list[frame] = NONE;
+    trimGhosts();
+}
+
+// Keeps |T1| + |B1| <= c and the whole directory within 2c.
+void ArcPolicy::trimGhosts() {
+    while (t1.size() + b1.size() > capacity && b1.size() > 0) {
+        b1.popOldest();
+    }
+    while (t1.size() + t2.size() + b1.size() + b2.size() > 2 * capacity) {
+        if (b2.size() > 0) {
+            b2.popOldest();
+        } else if (b1.size() > 0) {
+            b1.popOldest();
+        } else {
+            break;
+        }
+    }
+}
+
+int ArcPolicy::victim(const PageKey& incoming, const std::function<bool(int)>& evictable) {
+    size_t p = adaptedTarget(incoming);
+    bool fromT1 = !t1.empty() && (t1.size() > p || (b2.contains(incoming) && t1.size() == p));
+    for (int pass = 0; pass < 2; pass++) {
+        std::list<int>& candidates = fromT1 ? t1 : t2;
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            if (evictable(*it)) {
+                return *it;
+            }
+        }
+        fromT1 = !fromT1;
+    }
+    return -1;
+}
@@ -0,0 +1,176 @@
+#ifndef REPLACEMENT_POLICY_HPP
+#define REPLACEMENT_POLICY_HPP
+
+#include <vector>
+#include <list>
+#include <set>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+struct PageKey {
+    int fileId;
+    int pageId;
+
+    bool operator==(const PageKey& other) const {
+        return pageId == other.pageId && fileId == other.fileId;
+    }
+};
+
+struct PageKeyHash {
+    size_t operator()(const PageKey& key) const {
+        return ((static_cast<uint64_t>(key.fileId) << 32) | static_cast<uint32_t>(key.pageId)) * 0x9e3779b97f4a7c15ULL;
+    }
+};
+
+
+enum ReplacementKind {
+    POLICY_CLOCK,
+    POLICY_LRU_K,
+    POLICY_2Q,
+    POLICY_ARC
+};
+
+
+// Decides which resident frame the buffer pool gives up on a miss. The pool reports every
+// load, hit and eviction by frame number; victim() proposes frames in the policy's order and
+// takes the first one the pool accepts (unpinned, clean, no I/O pending), or returns -1.
+class ReplacementPolicy {
+public:
+    virtual ~ReplacementPolicy() = default;
+
+    virtual void loaded(int frame, const PageKey& key) = 0;
+    virtual void accessed(int frame) = 0;
+    virtual void evicted(int frame) = 0;
+    virtual int victim(const PageKey& incoming, const std::function<bool(int)>& evictable) = 0;
+    virtual const char* name() const = 0;
+
+    static std::unique_ptr<ReplacementPolicy> create(ReplacementKind kind, int frames);
+    static bool parse(const std::string& name, ReplacementKind& kind);
+};
+
+
+class ClockPolicy : public ReplacementPolicy {
+public:
+    explicit ClockPolicy(int frames);
+
+    void loaded(int frame, const PageKey& key) override;
+    void accessed(int frame) override;
+    void evicted(int frame) override;
+    int victim(const PageKey& incoming, const std::function<bool(int)>& evictable) override;
+    const char* name() const override { return "clock"; }
+
+private:
+    std::vector<bool> referenced;
+    std::vector<bool> resident;
+    int hand = 0;
+};
+
+
+// LRU-K with K = 2: evicts the page whose second-to-last access is oldest. Pages seen only
+// once (a scan) go first, oldest first. Access times of recently evicted pages are kept so a
+// hot page that gets evicted regains its history when it is read back.
+class LruKPolicy : public ReplacementPolicy {
+public:
+    explicit LruKPolicy(int frames);
+
+    void loaded(int frame, const PageKey& key) override;
+    void accessed(int frame) override;
+    void evicted(int frame) override;
+    int victim(const PageKey& incoming, const std::function<bool(int)>& evictable) override;
+    const char* name() const override { return "lru-2"; }
+
+private:
+    struct History {
+        uint64_t last = 0;
+        uint64_t previous = 0;
+    };
+    // previous == 0 means fewer than K accesses; those sort first, by their single access.
+    using Rank = std::pair<std::pair<bool, uint64_t>, int>;
+
+    std::vector<History> history;
+    std::vector<PageKey> keys;
+    std::vector<bool> resident;
+    std::set<Rank> order;
+    std::unordered_map<PageKey, History, PageKeyHash> retained;
+    std::deque<PageKey> retainedOrder;
+    size_t retainLimit;
+    uint64_t now = 0;
+
+    Rank rank(int frame) const;
+    void touch(int frame);
+};
+
+
+// Full 2Q: first-time pages enter a FIFO (A1in) sized to a quarter of the pool; pages evicted
+// from it are remembered in a ghost queue (A1out) and promoted to the main LRU (Am) if they are
+// read again. A scan only ever cycles through A1in.
+class TwoQPolicy : public ReplacementPolicy {
+public:
+    explicit TwoQPolicy(int frames);
+
+    void loaded(int frame, const PageKey& key) override;
+    void accessed(int frame) override;
+    void evicted(int frame) override;
+    int victim(const PageKey& incoming, const std::function<bool(int)>& evictable) override;
+    const char* name() const override { return "2q"; }
+
+private:
+    enum Queue { NONE, A1IN, AM };
+
+    std::vector<Queue> queue;
+    std::vector<PageKey> keys;
+    std::vector<std::list<int>::iterator> position;
+    std::list<int> a1in;
+    std::list<int> am;
+    std::list<PageKey> a1out;
+    std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash> ghosts;
+    size_t kin;
+    size_t kout;
+};
+
+
+// ARC (Megiddo and Modha): recency list T1 and frequency list T2 with ghost lists B1/B2. Hits
+// in the ghosts move the target size p of T1, so the split adapts to the workload.
+class ArcPolicy : public ReplacementPolicy {
+public:
+    explicit ArcPolicy(int frames);
+
+    void loaded(int frame, const PageKey& key) override;
+    void accessed(int frame) override;
+    void evicted(int frame) override;
+    int victim(const PageKey& incoming, const std::function<bool(int)>& evictable) override;
+    const char* name() const override { return "arc"; }
+
+private:
+    enum List { NONE, T1, T2 };
+
+    struct Ghosts {
+        std::list<PageKey> order;
+        std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash> index;
+
+        bool contains(const PageKey& key) const { return index.count(key) > 0; }
+        void push(const PageKey& key);
+        void erase(const PageKey& key);
+        void popOldest();
+        size_t size() const { return order.size(); }
+    };
+
+    size_t capacity;
+    size_t target = 0;
+    std::vector<List> list;
+    std::vector<PageKey> keys;
+    std::vector<std::list<int>::iterator> position;
+    std::list<int> t1;
+    std::list<int> t2;
+    Ghosts b1;
+    Ghosts b2;
+
+    size_t adaptedTarget(const PageKey& key) const;
+    void trimGhosts();
+};
+
+#endif
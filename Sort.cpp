@@ -0,0 +1,268 @@
+#include "Sort.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static void append_big_endian(std::string& out, uint64_t bits) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+// The first 8 key bytes as a number that orders like the bytes, zero padded.
+static uint64_t key_prefix(const char* key, size_t length) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (i < length ? static_cast<uint8_t>(key[i]) : 0);
+    }
+    return prefix;
+}
+
+static void write_bytes(FILE* file, const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+        throw std::runtime_error("Sort: cannot write to a run file");
+    }
+}
+
+
+Sort::Sort(std::unique_ptr<Operator> child, std::vector<Key> keys, size_t memoryBudget, long limit)
+    : child(std::move(child)), keys(std::move(keys)), memoryBudget(memoryBudget), limit(limit) {}
+
+Sort::~Sort() {
+    release();
+}
+
+void Sort::open() {
+    release();
+    std::vector<std::pair<std::string, std::string>> best;
+    auto worse = [](const auto& a, const auto& b) { return a.first < b.first; };
+    Tuple tuple;
+    child->open();
+    while (child->next(tuple)) {
+        encode(tuple, key);
+        if (limit < 0) {
+            append(key, tuple.Serialize());
+            if (arena.size() + entries.size() * sizeof(Entry) > memoryBudget) {
+                runs.push_back(Run(write_run()));
+            }
+        } else if (best.size() < static_cast<size_t>(limit)) {
+            best.emplace_back(key, tuple.Serialize());
+            std::push_heap(best.begin(), best.end(), worse);
+        } else if (!best.empty() && key < best.front().first) {
+            std::pop_heap(best.begin(), best.end(), worse);
+            best.back() = {key, tuple.Serialize()};
+            std::push_heap(best.begin(), best.end(), worse);
+        }
+    }
+    child->close();
+
+    if (limit >= 0) {
+        std::sort_heap(best.begin(), best.end(), worse);
+        for (const auto& [rowKey, row] : best) {
+            append(rowKey, row);
+        }
+    } else if (!runs.empty()) {
+        if (!entries.empty()) {
+            runs.push_back(Run(write_run()));
+        }
+        while (runs.size() > FAN_IN) {
+            std::vector<Run> inputs(std::make_move_iterator(runs.begin()), std::make_move_iterator(runs.begin() + FAN_IN));
+            runs.erase(runs.begin(), runs.begin() + FAN_IN);
+            FILE* output = std::tmpfile();
+            if (output == nullptr) {
+                throw std::runtime_error("Sort: cannot create a run file");
+            }
+            merge(std::move(inputs), output);
+            runs.push_back(Run(output));
+        }
+        start(runs);
+        return;
+    }
+    sort_entries();
+}
+
+bool Sort::next(Tuple& tuple) {
+    if (!runs.empty()) {
+        int winner = tree[0];
+        if (winner < 0 || runs[winner].done) {
+            return false;
+        }
+        tuple.Deserialize(runs[winner].row);
+        advance(runs[winner]);
+        adjust(runs, winner);
+        return true;
+    }
+    if (position == entries.size()) {
+        return false;
+    }
+    const Entry& entry = entries[position++];
+    tuple.Deserialize(arena.data() + entry.offset + entry.keyLength, entry.rowLength);
+    return true;
+}
+
+void Sort::close() {
+    release();
+}
+
+void Sort::encode(const Tuple& tuple, std::string& out) const {
+    out.clear();
+    for (const Key& sortKey : keys) {
+        std::string_view value;
+        for (const auto& attr : tuple.attributes) {
+            if (attr.first == sortKey.column) {
+                value = attr.second.second;
+                break;
+            }
+        }
+        size_t start = out.size();
+        int64_t integer;
+        double real;
+        if (sortKey.domain == Expression::DOMAIN_INT && Expression::parse_integer(value, integer)) {
+            out.push_back(0);
+            append_big_endian(out, static_cast<uint64_t>(integer) ^ (1ULL << 63));
+        } else if (sortKey.domain == Expression::DOMAIN_FLOAT && Expression::parse_real(value, real)) {
+            uint64_t bits;
+            std::memcpy(&bits, &real, sizeof(bits));
+            out.push_back(0);
+            append_big_endian(out, (bits >> 63) ? ~bits : bits | (1ULL << 63));
+        } else if (sortKey.domain == Expression::DOMAIN_TEXT) {
+            out.push_back(0);
+            for (char c : value) {
+                out.push_back(c);
+                if (c == 0) {
+                    out.push_back(1);
+                }
+            }
+            out.push_back(0);
+            out.push_back(0);
+        } else {
+            out.push_back(1);
+        }
+        if (sortKey.descending) {
+            for (size_t i = start; i < out.size(); i++) {
+                out[i] = static_cast<char>(~out[i]);
+            }
+        }
+    }
+}
+
+void Sort::append(const std::string& rowKey, const std::string& row) {
+    entries.push_back(Entry{key_prefix(rowKey.data(), rowKey.size()), arena.size(),
+                            static_cast<uint32_t>(rowKey.size()), static_cast<uint32_t>(row.size())});
+    arena.append(rowKey);
+    arena.append(row);
+}
+
+void Sort::sort_entries() {
+    const char* data = arena.data();
+    std::sort(entries.begin(), entries.end(), [data](const Entry& a, const Entry& b) {
+        if (a.prefix != b.prefix) {
+            return a.prefix < b.prefix;
+        }
+        int order = std::memcmp(data + a.offset, data + b.offset, std::min(a.keyLength, b.keyLength));
+        return order < 0 || (order == 0 && a.keyLength < b.keyLength);
+    });
+}
+
+// Sorts the buffered rows and writes them out as a run: key length, row length, key, row.
+FILE* Sort::write_run() {
+    sort_entries();
+    FILE* file = std::tmpfile();
+    if (file == nullptr) {
+        throw std::runtime_error("Sort: cannot create a run file");
+    }
+    for (const Entry& entry : entries) {
+        write_bytes(file, &entry.keyLength, sizeof(entry.keyLength));
+        write_bytes(file, &entry.rowLength, sizeof(entry.rowLength));
+        write_bytes(file, arena.data() + entry.offset, entry.keyLength + entry.rowLength);
+    }
+    arena.clear();
+    entries.clear();
+    spilledRuns++;
+    return file;
+}
+
+void Sort::merge(std::vector<Run> inputs, FILE* output) {
+    start(inputs);
+    while (!inputs[tree[0]].done) {
+        Run& run = inputs[tree[0]];
+        uint32_t keyLength = static_cast<uint32_t>(run.key.size());
+        uint32_t rowLength = static_cast<uint32_t>(run.row.size());
+        write_bytes(output, &keyLength, sizeof(keyLength));
+        write_bytes(output, &rowLength, sizeof(rowLength));
+        write_bytes(output, run.key.data(), keyLength);
+        write_bytes(output, run.row.data(), rowLength);
+        advance(run);
+        adjust(inputs, tree[0]);
+    }
+    for (Run& run : inputs) {
+        std::fclose(run.file);
+    }
+}
+
+// Reads the first row of every run and plays the initial tournament: each internal node of the
+// tree keeps the loser of the match played there, tree[0] the overall winner. A node starts out
+// holding -1, which beats everything, so the first pass pushes the real runs into place.
+void Sort::start(std::vector<Run>& inputs) {
+    for (Run& run : inputs) {
+        std::rewind(run.file);
+        run.done = false;
+        advance(run);
+    }
+    tree.assign(inputs.size(), -1);
+    for (int leaf = static_cast<int>(inputs.size()) - 1; leaf >= 0; leaf--) {
+        adjust(inputs, leaf);
+    }
+}
+
+bool Sort::advance(Run& run) {
+    uint32_t lengths[2];
+    if (std::fread(lengths, sizeof(uint32_t), 2, run.file) != 2) {
+        run.done = true;
+        return false;
+    }
+    run.key.resize(lengths[0]);
+    run.row.resize(lengths[1]);
+    if (std::fread(run.key.data(), 1, lengths[0], run.file) != lengths[0] ||
+        std::fread(run.row.data(), 1, lengths[1], run.file) != lengths[1]) {
+        throw std::runtime_error("Sort: truncated run file");
+    }
+    return true;
+}
+
+// Whether run a comes out before run b; exhausted runs come last, equal keys in run order.
+bool Sort::beats(const std::vector<Run>& inputs, int a, int b) const {
+    if (a < 0 || b < 0) {
+        return a < 0;
+    }
+    if (inputs[a].done || inputs[b].done) {
+        return !inputs[a].done;
+    }
+    int order = inputs[a].key.compare(inputs[b].key);
+    return order < 0 || (order == 0 && a < b);
+}
+
+// Replays the matches from a leaf whose row changed up to the root, one comparison per level.
+void Sort::adjust(const std::vector<Run>& inputs, int leaf) {
+    int winner = leaf;
+    for (size_t node = (leaf + inputs.size()) / 2; node > 0; node /= 2) {
+        if (beats(inputs, tree[node], winner)) {
+            std::swap(winner, tree[node]);
+        }
+    }
+    tree[0] = winner;
+}
+
+void Sort::release() {
+    for (Run& run : runs) {
+        if (run.file != nullptr) {
+            std::fclose(run.file);
+        }
+    }
+    runs.clear();
+    tree.clear();
+    arena.clear();
+    entries.clear();
+    position = 0;
+    spilledRuns = 0;
+}
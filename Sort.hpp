@@ -0,0 +1,84 @@
+#ifndef SORT_HPP
+#define SORT_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include "Operator.hpp"
+#include "Expression.hpp"
+
+// ORDER BY as an external merge sort. Each row gets a normalized key: its sort columns encoded so
+// that comparing the bytes orders the rows (integers and reals as order-preserving big-endian
+// bits, text with its zero bytes escaped, descending columns inverted, values that are not numbers
+// of their column's type after all others ascending and before them descending). Rows are
+// serialized next to their keys into one buffer and sorted by key, the first 8 key bytes kept
+// inline so most comparisons touch no row. Once the buffer outgrows the memory budget it is
+// written out as a sorted run to a temporary file; the runs are then merged FAN_IN at a time
+// through a loser tree, in passes until one merge yields the output.
+//
+// With a limit of k rows the sort keeps the best k rows in a heap instead and never spills.
+class Sort : public Operator {
+public:
+    static constexpr size_t FAN_IN = 64;
+
+    struct Key {
+        std::string column;
+        Expression::Domain domain;
+        bool descending;
+    };
+
+    Sort(std::unique_ptr<Operator> child, std::vector<Key> keys, size_t memoryBudget, long limit = -1);
+    ~Sort() override;
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return limit >= 0 ? "TopN" : "Sort"; }
+
+    size_t spilled_runs() const { return spilledRuns; }
+
+private:
+    // offset is a full size_t so an arena past 4 GiB (a large work_mem) cannot wrap it.
+    struct Entry {
+        uint64_t prefix;
+        size_t offset;
+        uint32_t keyLength;
+        uint32_t rowLength;
+    };
+
+    struct Run {
+        explicit Run(FILE* file) : file(file) {}
+
+        FILE* file;
+        std::string key;
+        std::string row;
+        bool done = false;
+    };
+
+    std::unique_ptr<Operator> child;
+    std::vector<Key> keys;
+    size_t memoryBudget;
+    long limit;
+
+    std::string arena;
+    std::vector<Entry> entries;
+    size_t position = 0;
+    std::vector<Run> runs;
+    std::vector<int> tree;
+    size_t spilledRuns = 0;
+    std::string key;
+
+    void encode(const Tuple& tuple, std::string& out) const;
+    void append(const std::string& key, const std::string& row);
+    void sort_entries();
+    FILE* write_run();
+    void merge(std::vector<Run> inputs, FILE* output);
+    void start(std::vector<Run>& inputs);
+    bool advance(Run& run);
+    bool beats(const std::vector<Run>& inputs, int a, int b) const;
+    void adjust(const std::vector<Run>& inputs, int leaf);
+    void release();
+};
+
+#endif
@@ -1,28 +1,294 @@
 #include "Table.hpp"
 #include "page.hpp"
-#include "fstream"
+#include "Buffer.hpp"
+#include "FileManager.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+
+std::string Table::filePath() const {
+    return db_name + "/" + table_name + ".HAD";
+}
+
 Page* Table::Create_page() {
+    Buffer_Page* frame = pool->requestPage(file_id, page_count + 1, DATA_PAGE, true);
+    if (frame == nullptr) {
+        return nullptr;
+    }
     page_count++;
-    Page* page = new Page(4096-3*sizeof(int),{(page_count-1)*81+1,(page_count) * 81});
-    page->serialize(page_count,"test",table_name);
-    page->pageId = page_count;
-    
+    if (!serializePageCount()) {
+        page_count--;
+        pool->releasePage(frame);
+        return nullptr;
+    }
+    Page* page = latch(frame, page_count, true);
+    page->init({0, -1});
+    if (!Renew_ids(page)) {
+        std::cerr << "Error: Could not record the ids of page " << page_count << std::endl;
+    }
+    return page;
+}
+
+// Hands a page the next block of MAX_SLOTS row ids and records the block in the directory. Ids
+// come from next_id, which only grows, so an id is never issued twice, even after the row that
+// had it is deleted or its page is given back to the file.
+bool Table::Renew_ids(Page* page) {
+    int first = static_cast<int>(next_id);
+    next_id += Page::MAX_SLOTS;
+    page->assign_ids({first, first + Page::MAX_SLOTS - 1});
+    directory.push_back({first, first + Page::MAX_SLOTS - 1, page->pageId});
+    return persistNextId() && persistDirectoryEntry(directory.size() - 1);
+}
+
+// Takes the frame's content latch before the page header is read. Writers hold it exclusively
+// until Update_page or Release_page; readers share it.
+Page* Table::latch(Buffer_Page* frame, int page_id, bool exclusive) {
+    if (exclusive) {
+        frame->latch.lock();
+    } else {
+        frame->latch.lock_shared();
+    }
+    Page* page = new Page(page_id, frame->data);
+    page->frame = frame;
+    page->exclusive = exclusive;
+    return page;
 }
 
+// Pins and latches the page for writing; hand it back with Update_page or Release_page.
 Page* Table::Get_page(int page_id) {
-   Page* pg = new Page(4096,{0,0});
-  Page::deserialize(pg,page_id,"test",table_name);
-    return pg;
+    if (page_id < 1 || static_cast<uint32_t>(page_id) > page_count) {
+        return nullptr;
+    }
+    Buffer_Page* frame = pool->requestPage(file_id, page_id, DATA_PAGE);
+    if (frame == nullptr) {
+        return nullptr;
+    }
+    return latch(frame, page_id, true);
+}
+
+// Read-only access under a shared latch. With the mmap backend a page that is not in the
+// buffer pool is served straight from the file mapping, so the returned view must not be
+// modified.
+Page* Table::Read_page(int page_id) {
+    if (page_id < 1 || static_cast<uint32_t>(page_id) > page_count) {
+        return nullptr;
+    }
+    if (backend == IO_MMAP) {
+        Buffer_Page* frame = pool->findPage(file_id, page_id);
+        if (frame != nullptr) {
+            return latch(frame, page_id, false);
+        }
+        const char* mapped = files->mappedPage(file_id, page_id);
+        if (mapped != nullptr) {
+            return new Page(page_id, const_cast<char*>(mapped));
+        }
+    }
+    Buffer_Page* frame = pool->requestPage(file_id, page_id, DATA_PAGE);
+    if (frame == nullptr) {
+        return nullptr;
+    }
+    return latch(frame, page_id, false);
 }
 
 void Table::Update_page(int page_id, Page* page) {
-    
-    
+    if (page->frame == nullptr) {
+        pool->releasePage(file_id, page_id, true);
+        delete page;
+        return;
+    }
+    page->frame->markDirty();
+    Release_page(page);
+}
+
+void Table::Release_page(Page* page) {
+    if (page->frame != nullptr) {
+        if (page->exclusive) {
+            page->frame->latch.unlock();
+        } else {
+            page->frame->latch.unlock_shared();
+        }
+        pool->releasePage(page->frame);
+    }
+    delete page;
+}
+
+// page_count lives right after the schema size in the table file header.
+bool Table::serializePageCount() {
+    uint32_t page_count_network = htonl(page_count);
+    return files->write(file_id, sizeof(uint32_t), reinterpret_cast<const char*>(&page_count_network), sizeof(page_count_network));
+}
+
+static void encode_range(char* dst, const IdRange& range) {
+    uint32_t fields[3] = {htonl(static_cast<uint32_t>(range.first)), htonl(static_cast<uint32_t>(range.last)),
+                          htonl(static_cast<uint32_t>(range.page))};
+    std::memcpy(dst, fields, sizeof(fields));
+}
+
+// The id directory in <table>.DIR starts with the next id to issue, followed by one (first id,
+// last id, page id) entry per block of ids handed to a page, in the order the blocks were issued.
+// A page that used up its block gets another, so a page can have several entries.
+bool Table::serializeDirectory(const std::string& dbName, const std::string& fileName) {
+    int file = files->openFile(dbName + "/" + fileName + ".DIR");
+    if (file < 0) {
+        return false;
+    }
+    std::vector<char> bytes(DIRECTORY_HEADER_SIZE + directory.size() * DIRECTORY_ENTRY_SIZE);
+    uint32_t next = htonl(next_id);
+    std::memcpy(bytes.data(), &next, sizeof(next));
+    for (size_t i = 0; i < directory.size(); i++) {
+        encode_range(bytes.data() + DIRECTORY_HEADER_SIZE + i * DIRECTORY_ENTRY_SIZE, directory[i]);
+    }
+    return files->write(file, 0, bytes.data(), bytes.size()) && files->truncate(file, bytes.size());
+}
+
+bool Table::persistNextId() {
+    if (directory_file_id < 0) {
+        return false;
+    }
+    uint32_t next = htonl(next_id);
+    return files->write(directory_file_id, 0, reinterpret_cast<const char*>(&next), sizeof(next));
+}
+
+bool Table::persistDirectoryEntry(size_t index) {
+    if (directory_file_id < 0) {
+        return false;
+    }
+    char bytes[DIRECTORY_ENTRY_SIZE];
+    encode_range(bytes, directory[index]);
+    return files->write(directory_file_id, DIRECTORY_HEADER_SIZE + index * DIRECTORY_ENTRY_SIZE, bytes, sizeof(bytes));
+}
+
+// Reads <table>.DIR, or rebuilds it from the pages when it is missing or does not cover every
+// page: the blocks of the ids of the rows each page holds, and its current block. Which ids of a
+// block were issued to rows since deleted is lost with the file, so every page then gets a fresh
+// block past all of them, as pages of tables whose ids came from their slots do on upgrade.
+bool Table::loadDirectory() {
+    directory_file_id = files->openFile(db_name + "/" + table_name + ".DIR");
+    directory.clear();
+    off_t size = directory_file_id >= 0 ? files->fileSize(directory_file_id) : 0;
+    if (size >= DIRECTORY_HEADER_SIZE && (size - DIRECTORY_HEADER_SIZE) % DIRECTORY_ENTRY_SIZE == 0) {
+        std::vector<char> stored(size);
+        if (files->read(directory_file_id, 0, stored.data(), size)) {
+            uint32_t next;
+            std::memcpy(&next, stored.data(), sizeof(next));
+            next_id = ntohl(next);
+            std::vector<bool> covered(page_count + 1, false);
+            for (off_t at = DIRECTORY_HEADER_SIZE; at < size; at += DIRECTORY_ENTRY_SIZE) {
+                uint32_t fields[3];
+                std::memcpy(fields, stored.data() + at, sizeof(fields));
+                IdRange range{static_cast<int>(ntohl(fields[0])), static_cast<int>(ntohl(fields[1])), static_cast<int>(ntohl(fields[2]))};
+                if (range.page >= 1 && static_cast<uint32_t>(range.page) <= page_count) {
+                    covered[range.page] = true;
+                }
+                directory.push_back(range);
+            }
+            if (std::count(covered.begin() + 1, covered.end(), true) == static_cast<long>(page_count)) {
+                std::sort(directory.begin(), directory.end(), [](const IdRange& a, const IdRange& b) { return a.first < b.first; });
+                return true;
+            }
+            directory.clear();
+        }
+    }
+
+    next_id = 1;
+    std::map<int, int> blocks;
+    for (uint32_t page_id = 1; page_id <= page_count; page_id++) {
+        Page* page = Read_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        std::vector<std::pair<int, int>> stubs;
+        int home_page, home_slot;
+        for (int slot = 0; slot < page->slot_count(); slot++) {
+            long long id;
+            if (page->forwarded(slot, home_page, home_slot)) {
+                stubs.push_back({home_page, home_slot});
+            } else if (!page->relocated(slot, home_page, home_slot) && page->row_id(slot, id) && id > 0) {
+                blocks[static_cast<int>((id - 1) / Page::MAX_SLOTS)] = page_id;
+            }
+        }
+        int last = page->ids_Range.second;
+        if (last > 0) {
+            blocks[(last - 1) / Page::MAX_SLOTS] = page_id;
+        }
+        Release_page(page);
+        // A relocated row keeps the id of its stub's page.
+        for (const auto& [target_page, target_slot] : stubs) {
+            Page* target = Read_page(target_page);
+            if (target == nullptr) {
+                continue;
+            }
+            long long id;
+            if (target->row_id(target_slot, id) && id > 0) {
+                blocks[static_cast<int>((id - 1) / Page::MAX_SLOTS)] = page_id;
+            }
+            Release_page(target);
+        }
+    }
+    for (const auto& [block, page_id] : blocks) {
+        int first = block * Page::MAX_SLOTS + 1;
+        directory.push_back({first, first + Page::MAX_SLOTS - 1, page_id});
+        next_id = std::max<uint32_t>(next_id, first + Page::MAX_SLOTS);
+    }
+    for (uint32_t page_id = 1; page_id <= page_count; page_id++) {
+        Page* page = Get_page(page_id);
+        if (page == nullptr) {
+            continue;
+        }
+        int first = static_cast<int>(next_id);
+        next_id += Page::MAX_SLOTS;
+        page->assign_ids({first, first + Page::MAX_SLOTS - 1});
+        directory.push_back({first, first + Page::MAX_SLOTS - 1, static_cast<int>(page_id)});
+        Update_page(page_id, page);
+    }
+    return serializeDirectory(db_name, table_name);
+}
+
+// Page that holds the block of row id, if any page does.
+bool Table::locate(int id, int& page_id) const {
+    auto it = std::upper_bound(directory.begin(), directory.end(), id, [](int value, const IdRange& range) { return value < range.first; });
+    if (it == directory.begin() || id > (--it)->last) {
+        return false;
+    }
+    page_id = it->page;
+    return true;
+}
+
+// Directory entries overlapping ids [low, high], in id order.
+std::vector<IdRange> Table::ranges_between(int low, int high) const {
+    std::vector<IdRange> ranges;
+    auto it = std::upper_bound(directory.begin(), directory.end(), low, [](int value, const IdRange& range) { return value < range.first; });
+    if (it != directory.begin() && std::prev(it)->last >= low) {
+        --it;
+    }
+    for (; it != directory.end() && it->first <= high; ++it) {
+        ranges.push_back(*it);
+    }
+    return ranges;
 }
 
-void Table::Delete_page(int page_id) {
-    
-    
+// Gives the data pages after the first pages back to the file, with their directory entries.
+// They must hold no rows. next_id stays where it is, so the ids they were issued stay retired
+// when pages are added again. Their frames are written out first, so no later write-back of a
+// frame left in the pool can grow the file over them again.
+bool Table::Truncate(uint32_t pages) {
+    if (pages >= page_count) {
+        return true;
+    }
+    for (uint32_t page_id = pages + 1; page_id <= page_count; page_id++) {
+        pool->flushPage(file_id, page_id);
+    }
+    uint32_t old_count = page_count;
+    page_count = pages;
+    if (!serializePageCount()) {
+        page_count = old_count;
+        return false;
+    }
+    directory.erase(std::remove_if(directory.begin(), directory.end(),
+                                   [pages](const IdRange& range) { return range.page > static_cast<int>(pages); }),
+                    directory.end());
+    serializeDirectory(db_name, table_name);
+    return files->truncate(file_id, static_cast<off_t>(pages + 1) * PAGE_SIZE);
 }
 
@@ -5,28 +5,61 @@
 #include <map>
 #include <vector>
 #include <utility>
+#include "FileManager.hpp"
 
 
 class Page;
+class BufferPool;
+class Buffer_Page;
+class FileManager;
+
+// A block of row ids issued to a data page; the rows with those ids live on that page, or behind
+// forwarding stubs on it.
+struct IdRange {
+    int first;
+    int last;
+    int page;
+};
 
 class Table {
 public:
     
     std::map<std::string, std::string> schema ;  
     std::string table_name;
+    std::string db_name;
     uint32_t size;
     uint32_t page_count = 0;
+    BufferPool* pool = nullptr;
+    FileManager* files = nullptr;
+    int file_id = -1;
+    IoBackend backend = IO_PREAD;
+    std::vector<IdRange> directory;
+    int directory_file_id = -1;
+    uint32_t next_id = 1;
 
     
-    Table(const std::string table_name) : table_name(table_name){};
+    Table(const std::string table_name, const std::string db_name = "test") : table_name(table_name), db_name(db_name){};
     Page* Create_page(); 
+    bool Renew_ids(Page* page);
     Page* Get_page(int page_id);  
+    Page* Read_page(int page_id);
     void Update_page(int page_id, Page* page);  
-    void Delete_page(int page_id);  
+    void Release_page(Page* page);
+    bool Truncate(uint32_t pages);
     bool serializeDirectory(const std::string& dbName, const std::string& fileName);
+    bool loadDirectory();
+    bool locate(int id, int& page_id) const;
+    std::vector<IdRange> ranges_between(int low, int high) const;
+    bool serializePageCount();
+    std::string filePath() const;
 
 private:
-    
+    static constexpr int DIRECTORY_HEADER_SIZE = 4;
+    static constexpr int DIRECTORY_ENTRY_SIZE = 12;
+
+    Page* latch(Buffer_Page* frame, int page_id, bool exclusive);
+    bool persistDirectoryEntry(size_t index);
+    bool persistNextId();
 };
 
 #endif 
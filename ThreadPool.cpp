@@ -0,0 +1,122 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        this->threads.emplace_back(&ThreadPool::loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLatch);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+static size_t sharedThreads = 0;
+
+void ThreadPool::configure(size_t threads) {
+    sharedThreads = threads;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(sharedThreads > 0 ? sharedThreads : std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target = currentPool == this ? currentWorker : nextWorker++ % workers.size();
+    {
+        std::lock_guard<std::mutex> guard(workers[target]->latch);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleepLatch);
+        pending++;
+    }
+    wake.notify_one();
+}
+
+// Own deque from the back, then the other deques from the front.
+bool ThreadPool::take(size_t self, std::function<void()>& task) {
+    for (size_t i = 0; i < workers.size(); i++) {
+        Worker& worker = *workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(worker.latch);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        } else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::loop(size_t self) {
+    currentPool = this;
+    currentWorker = self;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleepLatch);
+            wake.wait(lock, [this] { return pending > 0 || stopping; });
+            if (stopping && pending == 0) {
+                return;
+            }
+        }
+        std::function<void()> task;
+        if (take(self, task)) {
+            {
+                std::lock_guard<std::mutex> guard(sleepLatch);
+                pending--;
+            }
+            task();
+        }
+    }
+}
+
+// A worker calling run() does all the work itself: waiting on helpers queued behind it could
+// otherwise deadlock a small pool.
+void ThreadPool::run(size_t count, size_t parallelism, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    std::atomic<size_t> next{0};
+    auto drain = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+    size_t helpers = currentPool == this ? 0 : std::min(std::max<size_t>(parallelism, 1), count) - 1;
+    std::mutex doneLatch;
+    std::condition_variable done;
+    size_t running = helpers;
+    for (size_t i = 0; i < helpers; i++) {
+        submit([&] {
+            drain();
+            std::lock_guard<std::mutex> guard(doneLatch);
+            if (--running == 0) {
+                done.notify_all();
+            }
+        });
+    }
+    drain();
+    std::unique_lock<std::mutex> lock(doneLatch);
+    done.wait(lock, [&] { return running == 0; });
+}
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+// Work-stealing pool shared by every query. Each worker owns a deque: it runs its own tasks
+// newest first and, when it has none, steals the oldest task of another worker. Tasks submitted
+// from outside the pool are dealt round-robin, tasks submitted by a worker go to its own deque.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    // Sized to the machine's hardware threads unless configure() said otherwise before first use.
+    static ThreadPool& shared();
+    static void configure(size_t threads);
+
+    size_t size() const { return workers.size(); }
+    void submit(std::function<void()> task);
+
+    // Runs task(0) .. task(count - 1) on up to parallelism threads, the caller being one of them,
+    // and returns when all are done. Threads take the next index from a shared counter, so
+    // uneven tasks balance out.
+    void run(size_t count, size_t parallelism, const std::function<void(size_t)>& task);
+
+private:
+    struct Worker {
+        std::mutex latch;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex sleepLatch;
+    std::condition_variable wake;
+    size_t pending = 0;
+    bool stopping = false;
+    std::atomic<size_t> nextWorker{0};
+
+    void loop(size_t self);
+    bool take(size_t self, std::function<void()>& task);
+};
+
+#endif
@@ -0,0 +1,239 @@
+#include "Vectorized.hpp"
+#include "page.hpp"
+#include <algorithm>
+#include <numeric>
+
+void Batch::clear() {
+    count = 0;
+    bytes.clear();
+    offsets.assign(1, 0);
+    for (ColumnVector& column : columns) {
+        column.ints.clear();
+        column.spans.clear();
+        column.irregular = 0;
+    }
+    selection.clear();
+    selected = 0;
+    dense = true;
+}
+
+ColumnVector* Batch::column(const std::string& name) {
+    for (ColumnVector& column : columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view Batch::value(const ColumnVector& column, size_t row) const {
+    return std::string_view(bytes.data() + column.spans[row].first, column.spans[row].second);
+}
+
+
+BatchScan::BatchScan(HeapFile* heap, std::vector<std::string> columns, std::string zoneColumn,
+                     std::optional<KeyBound> low, std::optional<KeyBound> high)
+    : heap(heap), columns(std::move(columns)), zoneColumn(std::move(zoneColumn)), low(std::move(low)), high(std::move(high)) {}
+
+void BatchScan::restrict(uint32_t first, uint32_t last) {
+    firstPage = first;
+    lastPage = last;
+}
+
+void BatchScan::open() {
+    pageId = firstPage - 1;
+    Table* table = heap->get_table();
+    if (table->backend == IO_MMAP) {
+        table->files->advise(table->file_id, ACCESS_SEQUENTIAL);
+    }
+}
+
+bool BatchScan::next(Batch& batch) {
+    batch.columns.resize(columns.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        batch.columns[i].name = columns[i];
+    }
+    batch.clear();
+
+    Table* table = heap->get_table();
+    uint32_t last = std::min(lastPage, table->page_count);
+    while (batch.count < Batch::CAPACITY && pageId < last) {
+        ++pageId;
+        if ((low || high) && !heap->may_match(pageId, zoneColumn, low, high)) {
+            continue;
+        }
+        Page* page = table->Read_page(pageId);
+        if (page == nullptr) {
+            continue;
+        }
+        int slots = page->slot_count();
+        for (int slot = 0; slot < slots; slot++) {
+            if (page->get_record(slot, record)) {
+                batch.bytes.append(record);
+                batch.offsets.push_back(static_cast<uint32_t>(batch.bytes.size()));
+                decode(batch, batch.count++);
+            }
+        }
+        table->Release_page(page);
+    }
+    batch.selected = batch.count;
+    return batch.count > 0;
+}
+
+// Walks the serialized attributes of one row (key length | key | type | value length | value)
+// and fills in the wanted columns. A column the row lacks reads as "", like get_attribute.
+void BatchScan::decode(Batch& batch, size_t row) {
+    uint32_t begin = batch.offsets[row];
+    uint32_t end = batch.offsets[row + 1];
+    for (ColumnVector& column : batch.columns) {
+        column.spans.emplace_back(UINT32_MAX, 0);
+        column.ints.push_back(0);
+        column.irregular++;
+    }
+
+    const char* data = batch.bytes.data();
+    uint32_t offset = begin;
+    while (offset + 4 <= end) {
+        uint8_t keyLength = static_cast<uint8_t>(data[offset++]);
+        if (offset + keyLength + 3 > end) {
+            break;
+        }
+        std::string_view key(data + offset, keyLength);
+        offset += keyLength + 1;
+        uint32_t valueLength = (static_cast<uint8_t>(data[offset]) << 8) | static_cast<uint8_t>(data[offset + 1]);
+        offset += 2;
+        if (offset + valueLength > end) {
+            break;
+        }
+        for (ColumnVector& column : batch.columns) {
+            if (column.spans[row].first == UINT32_MAX && key == column.name) {
+                column.spans[row] = {offset, valueLength};
+                if (Expression::parse_integer(std::string_view(data + offset, valueLength), column.ints[row])) {
+                    column.irregular--;
+                }
+            }
+        }
+        offset += valueLength;
+    }
+
+    for (ColumnVector& column : batch.columns) {
+        if (column.spans[row].first == UINT32_MAX) {
+            column.spans[row] = {begin, 0};
+        }
+    }
+}
+
+void BatchScan::close() {
+    pageId = 0;
+}
+
+
+BatchFilter::BatchFilter(std::unique_ptr<BatchOperator> child, std::string column, CompareOp op, int64_t constant)
+    : child(std::move(child)), column(std::move(column)), op(op), constant(constant) {}
+
+void BatchFilter::open() {
+    child->open();
+}
+
+// Rows must be selected explicitly before they can be dropped one by one.
+static void materialize(Batch& batch) {
+    if (batch.dense) {
+        batch.selection.resize(batch.count);
+        std::iota(batch.selection.begin(), batch.selection.end(), 0);
+        batch.dense = false;
+    }
+}
+
+bool BatchFilter::next(Batch& batch) {
+    while (child->next(batch)) {
+        ColumnVector* values = batch.column(column);
+        if (values == nullptr) {
+            continue;
+        }
+        if (values->irregular == 0 && batch.dense) {
+            batch.selection.resize(batch.count);
+            batch.selected = kernels::select(values->ints.data(), batch.count, op, constant, batch.selection.data());
+            batch.dense = false;
+        } else if (values->irregular == 0) {
+            batch.selected = kernels::refine(values->ints.data(), batch.selection.data(), batch.selected, op, constant);
+        } else {
+            materialize(batch);
+            size_t kept = 0;
+            for (size_t i = 0; i < batch.selected; i++) {
+                uint32_t row = batch.selection[i];
+                int64_t value;
+                batch.selection[kept] = row;
+                kept += Expression::parse_integer(batch.value(*values, row), value) && kernels::compare(value, op, constant);
+            }
+            batch.selected = kept;
+        }
+        if (batch.selected > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchFilter::close() {
+    child->close();
+}
+
+
+BatchPredicate::BatchPredicate(std::unique_ptr<BatchOperator> child, std::shared_ptr<const Expression> predicate)
+    : child(std::move(child)), predicate(std::move(predicate)) {}
+
+void BatchPredicate::open() {
+    child->open();
+}
+
+bool BatchPredicate::next(Batch& batch) {
+    while (child->next(batch)) {
+        materialize(batch);
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.selected; i++) {
+            uint32_t row = batch.selection[i];
+            batch.selection[kept] = row;
+            kept += predicate->matches(batch.bytes.data() + batch.offsets[row], batch.offsets[row + 1] - batch.offsets[row]);
+        }
+        batch.selected = kept;
+        if (batch.selected > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchPredicate::close() {
+    child->close();
+}
+
+
+BatchToRows::BatchToRows(std::unique_ptr<BatchOperator> child, std::vector<std::string> columns)
+    : child(std::move(child)), columns(std::move(columns)) {}
+
+void BatchToRows::open() {
+    batch.clear();
+    position = 0;
+    exhausted = false;
+    child->open();
+}
+
+bool BatchToRows::next(Tuple& tuple) {
+    while (position == batch.selected) {
+        if (exhausted || !child->next(batch)) {
+            exhausted = true;
+            return false;
+        }
+        position = 0;
+    }
+    uint32_t row = batch.dense ? static_cast<uint32_t>(position) : batch.selection[position];
+    position++;
+    tuple.Deserialize(batch.bytes.data() + batch.offsets[row], batch.offsets[row + 1] - batch.offsets[row], columns);
+    return true;
+}
+
+void BatchToRows::close() {
+    child->close();
+    batch.clear();
+    position = 0;
+}
@@ -0,0 +1,135 @@
+#ifndef VECTORIZED_HPP
+#define VECTORIZED_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include "HeapFile.hpp"
+#include "Expression.hpp"
+#include "Kernels.hpp"
+#include "Operator.hpp"
+
+// One column of a batch. Values are kept as spans into the batch's row bytes, and those that are
+// plain integers (see Expression::parse_integer) also as int64; irregular counts the others.
+struct ColumnVector {
+    std::string name;
+    std::vector<int64_t> ints;
+    std::vector<std::pair<uint32_t, uint32_t>> spans;
+    size_t irregular = 0;
+};
+
+
+// Rows are carried serialized and decoded to tuples only once they survive every filter. While
+// dense, all count rows are selected and selection is not filled in.
+struct Batch {
+    static constexpr size_t CAPACITY = 1024;
+
+    size_t count = 0;
+    std::string bytes;
+    std::vector<uint32_t> offsets;
+    std::vector<ColumnVector> columns;
+    std::vector<uint32_t> selection;
+    size_t selected = 0;
+    bool dense = true;
+
+    void clear();
+    ColumnVector* column(const std::string& name);
+    std::string_view value(const ColumnVector& column, size_t row) const;
+};
+
+
+// Vectorized counterpart of Operator: each next() produces a batch until it returns false.
+class BatchOperator {
+public:
+    virtual ~BatchOperator() = default;
+
+    virtual void open() = 0;
+    virtual bool next(Batch& batch) = 0;
+    virtual void close() = 0;
+};
+
+
+// Fills batches with whole pages, about CAPACITY rows each, decoding just the listed columns.
+// Pages are unlatched before the batch is returned and skipped by zone map as in SeqScan.
+class BatchScan : public BatchOperator {
+public:
+    BatchScan(HeapFile* heap, std::vector<std::string> columns, std::string zoneColumn = "",
+              std::optional<KeyBound> low = std::nullopt, std::optional<KeyBound> high = std::nullopt);
+
+    // Limits the scan to pages first..last; by default it runs to the table's last page.
+    void restrict(uint32_t first, uint32_t last);
+
+    void open() override;
+    bool next(Batch& batch) override;
+    void close() override;
+
+private:
+    void decode(Batch& batch, size_t row);
+
+    HeapFile* heap;
+    std::vector<std::string> columns;
+    std::string zoneColumn;
+    std::optional<KeyBound> low;
+    std::optional<KeyBound> high;
+    uint32_t firstPage = 1;
+    uint32_t lastPage = UINT32_MAX;
+    uint32_t pageId = 0;
+    std::string record;
+};
+
+
+// Narrows the selection to the rows where the integer column op constant holds, with the SIMD
+// kernels. A value that is not a plain integer is unknown and never matches, as in Expression.
+class BatchFilter : public BatchOperator {
+public:
+    BatchFilter(std::unique_ptr<BatchOperator> child, std::string column, CompareOp op, int64_t constant);
+
+    void open() override;
+    bool next(Batch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::string column;
+    CompareOp op;
+    int64_t constant;
+};
+
+
+// Narrows the selection by any compiled WHERE clause, evaluated row by row on the row bytes.
+class BatchPredicate : public BatchOperator {
+public:
+    BatchPredicate(std::unique_ptr<BatchOperator> child, std::shared_ptr<const Expression> predicate);
+
+    void open() override;
+    bool next(Batch& batch) override;
+    void close() override;
+
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::shared_ptr<const Expression> predicate;
+};
+
+
+// Hands the selected rows of each batch up a row-at-a-time plan, as tuples of just the given
+// columns when there are any.
+class BatchToRows : public Operator {
+public:
+    explicit BatchToRows(std::unique_ptr<BatchOperator> child, std::vector<std::string> columns = {});
+
+    void open() override;
+    bool next(Tuple& tuple) override;
+    void close() override;
+    std::string name() const override { return "VectorScan"; }
+
+private:
+    std::unique_ptr<BatchOperator> child;
+    std::vector<std::string> columns;
+    Batch batch;
+    size_t position = 0;
+    bool exhausted = false;
+};
+
+#endif
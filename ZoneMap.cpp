@@ -0,0 +1,199 @@
+#include "ZoneMap.hpp"
+#include "BPlusTree.hpp"
+#include <algorithm>
+#include <cstring>
+
+ZoneMap::ZoneMap(FileManager* files, const std::string& filePath, std::vector<std::string> columns)
+    : files(files), fileId(files->openFile(filePath)), columns(std::move(columns)) {}
+
+static uint64_t fingerprint(const std::string& value) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+// Three probes by double hashing of one 64-bit fingerprint.
+static std::array<int, 3> probes(const std::string& value) {
+    uint64_t h = fingerprint(value);
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = static_cast<uint32_t>(h >> 32) | 1;
+    return {static_cast<int>(h1 % ZoneMap::BLOOM_BITS), static_cast<int>((h1 + h2) % ZoneMap::BLOOM_BITS),
+            static_cast<int>((h1 + 2 * h2) % ZoneMap::BLOOM_BITS)};
+}
+
+int ZoneMap::column_index(const std::string& column) const {
+    auto it = std::find(columns.begin(), columns.end(), column);
+    return it == columns.end() ? -1 : static_cast<int>(it - columns.begin());
+}
+
+// Record: per column, flags (rows, bounded) | min length | min | max length | max | Bloom bits.
+bool ZoneMap::load(uint32_t page_count) {
+    size_t record = ZONE_SIZE * columns.size();
+    if (fileId < 0 || files->fileSize(fileId) != static_cast<off_t>(record * page_count)) {
+        return false;
+    }
+    std::vector<char> stored(record * page_count);
+    if (!stored.empty() && !files->read(fileId, 0, stored.data(), stored.size())) {
+        return false;
+    }
+
+    pages.assign(page_count, std::vector<Zone>(columns.size()));
+    const char* data = stored.data();
+    for (auto& page : pages) {
+        for (Zone& zone : page) {
+            zone.rows = (data[0] & 1) != 0;
+            zone.bounded = (data[0] & 2) != 0;
+            zone.min.assign(data + 2, std::min<size_t>(static_cast<uint8_t>(data[1]), BOUND_SIZE));
+            zone.max.assign(data + 3 + BOUND_SIZE, std::min<size_t>(static_cast<uint8_t>(data[2 + BOUND_SIZE]), BOUND_SIZE));
+            std::memcpy(zone.bloom.data(), data + 3 + 2 * BOUND_SIZE, BLOOM_BITS / 8);
+            data += ZONE_SIZE;
+        }
+    }
+    return true;
+}
+
+void ZoneMap::persist(int page_id) {
+    if (fileId < 0) {
+        return;
+    }
+    std::vector<char> record(ZONE_SIZE * columns.size(), 0);
+    char* data = record.data();
+    for (const Zone& zone : pages[page_id - 1]) {
+        data[0] = static_cast<char>((zone.rows ? 1 : 0) | (zone.bounded ? 2 : 0));
+        data[1] = static_cast<char>(zone.min.size());
+        std::memcpy(data + 2, zone.min.data(), zone.min.size());
+        data[2 + BOUND_SIZE] = static_cast<char>(zone.max.size());
+        std::memcpy(data + 3 + BOUND_SIZE, zone.max.data(), zone.max.size());
+        std::memcpy(data + 3 + 2 * BOUND_SIZE, zone.bloom.data(), BLOOM_BITS / 8);
+        data += ZONE_SIZE;
+    }
+    files->write(fileId, static_cast<off_t>(record.size()) * (page_id - 1), record.data(), record.size());
+}
+
+void ZoneMap::widen(Zone& zone, const std::string& value) {
+    if (value.size() > BOUND_SIZE) {
+        zone.bounded = false;
+        zone.min.clear();
+        zone.max.clear();
+    } else if (zone.bounded) {
+        if (!zone.rows || BPlusTree::compareKeys(value, zone.min) < 0) {
+            zone.min = value;
+        }
+        if (!zone.rows || BPlusTree::compareKeys(value, zone.max) > 0) {
+            zone.max = value;
+        }
+    }
+    for (int bit : probes(value)) {
+        zone.bloom[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    zone.rows = true;
+}
+
+bool ZoneMap::bloom_test(const Zone& zone, const std::string& value) {
+    for (int bit : probes(value)) {
+        if ((zone.bloom[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Marks a new or emptied page as holding no rows.
+void ZoneMap::clear(int page_id) {
+    if (page_id > static_cast<int>(pages.size())) {
+        pages.resize(page_id, std::vector<Zone>(columns.size()));
+    }
+    pages[page_id - 1].assign(columns.size(), Zone());
+    persist(page_id);
+}
+
+// Widens the page's synopsis by one row; a column the row does not have counts as "".
+void ZoneMap::add(int page_id, const std::vector<std::pair<std::string, std::string>>& values) {
+    if (page_id > static_cast<int>(pages.size())) {
+        pages.resize(page_id, std::vector<Zone>(columns.size()));
+    }
+    std::vector<Zone>& page = pages[page_id - 1];
+    for (size_t i = 0; i < columns.size(); i++) {
+        auto it = std::find_if(values.begin(), values.end(), [&](const auto& value) { return value.first == columns[i]; });
+        widen(page[i], it == values.end() ? "" : it->second);
+    }
+    persist(page_id);
+}
+
+void ZoneMap::reset(int page_id, std::vector<Tuple>& tuples) {
+    if (page_id > static_cast<int>(pages.size())) {
+        pages.resize(page_id, std::vector<Zone>(columns.size()));
+    }
+    std::vector<Zone>& page = pages[page_id - 1];
+    page.assign(columns.size(), Zone());
+    for (Tuple& tuple : tuples) {
+        for (size_t i = 0; i < columns.size(); i++) {
+            widen(page[i], tuple.get_attribute(columns[i]));
+        }
+    }
+    persist(page_id);
+}
+
+void ZoneMap::truncate(uint32_t page_count) {
+    if (pages.size() > page_count) {
+        pages.resize(page_count);
+    }
+    off_t end = static_cast<off_t>(ZONE_SIZE * columns.size()) * page_count;
+    if (fileId >= 0 && files->fileSize(fileId) > end) {
+        files->truncate(fileId, end);
+    }
+}
+
+// Null when nothing is known about the column on that page, so it cannot be skipped.
+const ZoneMap::Zone* ZoneMap::zone(int page_id, const std::string& column) const {
+    int index = column_index(column);
+    if (index < 0 || page_id < 1 || page_id > static_cast<int>(pages.size())) {
+        return nullptr;
+    }
+    return &pages[page_id - 1][index];
+}
+
+// False only if no row of the page can have exactly value in column.
+bool ZoneMap::may_contain(int page_id, const std::string& column, const std::string& value) const {
+    const Zone* z = zone(page_id, column);
+    if (z == nullptr) {
+        return true;
+    }
+    if (!z->rows) {
+        return false;
+    }
+    if (z->bounded && (BPlusTree::compareKeys(value, z->min) < 0 || BPlusTree::compareKeys(value, z->max) > 0)) {
+        return false;
+    }
+    return bloom_test(*z, value);
+}
+
+// False only if no row of the page can have a column value between the bounds.
+bool ZoneMap::may_overlap(int page_id, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) const {
+    const Zone* z = zone(page_id, column);
+    if (z == nullptr) {
+        return true;
+    }
+    if (!z->rows) {
+        return false;
+    }
+    if (!z->bounded) {
+        return true;
+    }
+    if (low) {
+        int c = BPlusTree::compareKeys(z->max, low->key);
+        if (c < 0 || (c == 0 && !low->inclusive)) {
+            return false;
+        }
+    }
+    if (high) {
+        int c = BPlusTree::compareKeys(z->min, high->key);
+        if (c > 0 || (c == 0 && !high->inclusive)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef ZONE_MAP_HPP
+#define ZONE_MAP_HPP
+
+#include <string>
+#include <vector>
+#include <array>
+#include <optional>
+#include <cstdint>
+#include "Index.hpp"
+#include "tuple.hpp"
+
+// Per-page synopsis of every column of a table, kept in <table>.ZMP with one fixed-size record
+// per data page: the min and max value (compared like index keys) and a small Bloom filter of
+// the exact values. A scan skips pages whose synopsis rules out its predicate without reading
+// them. Inserts and updates only widen a page's synopsis and deletes leave it as it is, so it
+// may cover rows that are gone until a vacuum recomputes it from the rows left. Values longer
+// than BOUND_SIZE leave the column's bounds open for that page.
+class ZoneMap {
+public:
+    static constexpr size_t BOUND_SIZE = 32;
+    static constexpr int BLOOM_BITS = 512;
+
+    ZoneMap(FileManager* files, const std::string& filePath, std::vector<std::string> columns);
+
+    bool load(uint32_t page_count);
+    void clear(int page_id);
+    void add(int page_id, const std::vector<std::pair<std::string, std::string>>& values);
+    void reset(int page_id, std::vector<Tuple>& tuples);
+    void truncate(uint32_t page_count);
+
+    bool may_contain(int page_id, const std::string& column, const std::string& value) const;
+    bool may_overlap(int page_id, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) const;
+
+private:
+    struct Zone {
+        bool rows = false;
+        bool bounded = true;
+        std::string min;
+        std::string max;
+        std::array<uint64_t, BLOOM_BITS / 64> bloom{};
+    };
+
+    static constexpr int ZONE_SIZE = 3 + 2 * static_cast<int>(BOUND_SIZE) + BLOOM_BITS / 8;
+
+    FileManager* files;
+    int fileId;
+    std::vector<std::string> columns;
+    std::vector<std::vector<Zone>> pages;
+
+    int column_index(const std::string& column) const;
+    const Zone* zone(int page_id, const std::string& column) const;
+    static void widen(Zone& zone, const std::string& value);
+    static bool bloom_test(const Zone& zone, const std::string& value);
+    void persist(int page_id);
+};
+
+#endif
@@ -0,0 +1,859 @@
+#include "DataBase.hpp"
+#include "ExcuetionEngine.hpp"
+#include "HeapFile.hpp"
+#include "ReplacementPolicy.hpp"
+#include "Vectorized.hpp"
+#include "Parallel.hpp"
+#include "Join.hpp"
+#include "parser.hpp"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Micro benchmarks for the storage layer.
+//   ./bench io [rows] [scans]   full table scans through the pread path vs the mmap path
+//   ./bench policy [frames] [trace]
+//                               hit rate of each replacement policy on a page-access trace, either
+//                               one recorded with `./program <db> <frames> trace=<file>` or a
+//                               synthetic mix of skewed point lookups and periodic full scans
+//   ./bench index [rows] [lookups]
+//                               point lookups on a column by full scan vs through its B+tree and
+//                               its hash index
+//   ./bench zone [rows]         range and point filters on a time-ordered table, reading every
+//                               page vs skipping pages by their zone maps
+//   ./bench vector [rows]       filter and sum kernel throughput at each SIMD level, then a
+//                               filtered scan row at a time vs in vectorized batches
+//   ./bench parallel [rows] [threads]
+//                               morsel-driven filtered scan and partial-sum aggregation at 1, 2,
+//                               4, ... threads of the shared work-stealing pool
+//   ./bench join [rows]         readings joined to a tag per reading value: in memory, through
+//                               grace partitions, and with parallel input scans
+//   ./bench aggregate [rows]    per-sensor COUNT/SUM/MIN/MAX/AVG computed by the client from all
+//                               rows vs by GROUP BY in the engine, serial, parallel and spilled
+//   ./bench sort [rows]         ORDER BY sorted in memory, as spilled runs merged through the
+//                               loser tree, and with LIMIT as a top-k heap
+//   ./bench project [rows]      one column of every row and of a filtered scan, decoded from
+//                               whole rows and projected vs decoded alone
+//   ./bench update [rows]       UPDATE of one sensor's rows in place and growing out of their
+//                               pages, then id lookups of the moved rows vs of unmoved ones
+//   ./bench delete [rows]       DELETE of half the readings spread over every page and of the
+//                               newer half of the pages, each followed by VACUUM
+//   ./bench pool [threads]      buffer pool hits: requestPage/releasePage of resident pages from
+//                               1, 2, 4, ... threads, in operations per second
+
+static const std::string BENCH_DB = "bench_db";
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void loadTable(int rows) {
+    std::filesystem::remove_all(BENCH_DB);
+    DataBase db(BENCH_DB);
+    db.createDatabase();
+    ExecutionEngine engine(db);
+    engine.Create_table("bench", {{"name", "VARCHAR"}, {"bio", "VARCHAR"}});
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> length(10, 400);
+    for (int i = 0; i < rows; i++) {
+        engine.insert("bench", {{"name", {0, "user" + std::to_string(i)}}, {"bio", {1, std::string(length(rng), 'x')}}});
+    }
+}
+
+static void dropPageCache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+static void scanBackend(IoBackend backend, int scans) {
+    dropPageCache(BENCH_DB + "/bench.HAD");
+
+    DataBase db(BENCH_DB, 16, backend);
+    Table* table = db.getTable("bench");
+    HeapFile heap(table);
+
+    size_t rows = 0;
+    auto start = std::chrono::steady_clock::now();
+    rows = heap.select({" ", " "}).size();
+    double cold = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scans; i++) {
+        rows = heap.select({" ", " "}).size();
+    }
+    double warm = elapsedMs(start) / scans;
+
+    double mb = table->page_count * PAGE_SIZE / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(8) << (backend == IO_MMAP ? "mmap" : "pread")
+              << std::right << std::setw(10) << rows
+              << std::setw(10) << table->page_count
+              << std::setw(12) << std::fixed << std::setprecision(2) << cold
+              << std::setw(12) << warm
+              << std::setw(12) << mb / (warm / 1000.0) << "\n";
+}
+
+static int benchIo(int rows, int scans) {
+    loadTable(rows);
+    std::cout << std::left << std::setw(8) << "backend"
+              << std::right << std::setw(10) << "rows"
+              << std::setw(10) << "pages"
+              << std::setw(12) << "cold ms"
+              << std::setw(12) << "warm ms"
+              << std::setw(12) << "warm MB/s" << "\n";
+    scanBackend(IO_PREAD, scans);
+    scanBackend(IO_MMAP, scans);
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+static std::vector<PageKey> mixedTrace(int frames) {
+    std::vector<PageKey> trace;
+    std::mt19937 rng(7);
+    int hot = std::max(frames * 3 / 4, 1);
+    std::vector<double> weights(hot);
+    for (int i = 0; i < hot; i++) {
+        weights[i] = 1.0 / std::pow(i + 1, 0.8);
+    }
+    std::discrete_distribution<int> lookup(weights.begin(), weights.end());
+    int scanPages = frames * 8;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 20000; i++) {
+            trace.push_back({0, 1 + lookup(rng)});
+        }
+        for (int page = 1; page <= scanPages; page++) {
+            trace.push_back({1, page});
+        }
+    }
+    return trace;
+}
+
+static bool loadTrace(const std::string& path, std::vector<PageKey>& trace) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error: Could not open trace " << path << std::endl;
+        return false;
+    }
+    PageKey key;
+    while (in >> key.fileId >> key.pageId) {
+        trace.push_back(key);
+    }
+    return true;
+}
+
+// Replays the trace against the policy alone: every frame is always evictable, as in a pool
+// whose pages are clean and unpinned between accesses.
+static double replay(ReplacementKind kind, int frames, const std::vector<PageKey>& trace, size_t& hits) {
+    std::unique_ptr<ReplacementPolicy> policy = ReplacementPolicy::create(kind, frames);
+    std::unordered_map<PageKey, int, PageKeyHash> resident;
+    std::vector<PageKey> owner(frames);
+    int used = 0;
+    auto always = [](int) { return true; };
+    hits = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const PageKey& key : trace) {
+        auto it = resident.find(key);
+        if (it != resident.end()) {
+            hits++;
+            policy->accessed(it->second);
+            continue;
+        }
+        int frame;
+        if (used < frames) {
+            frame = used++;
+        } else {
+            frame = policy->victim(key, always);
+            policy->evicted(frame);
+            resident.erase(owner[frame]);
+        }
+        owner[frame] = key;
+        resident[key] = frame;
+        policy->loaded(frame, key);
+    }
+    return elapsedMs(start);
+}
+
+static int benchPolicy(int frames, const std::string& tracePath) {
+    std::vector<PageKey> trace;
+    if (tracePath.empty()) {
+        trace = mixedTrace(frames);
+    } else if (!loadTrace(tracePath, trace)) {
+        return 1;
+    }
+    std::cout << trace.size() << " accesses, " << frames << " frames"
+              << (tracePath.empty() ? " (synthetic: skewed lookups + full scans)" : "") << "\n";
+    std::cout << std::left << std::setw(8) << "policy"
+              << std::right << std::setw(12) << "hits"
+              << std::setw(12) << "misses"
+              << std::setw(12) << "hit rate"
+              << std::setw(12) << "ms" << "\n";
+    for (ReplacementKind kind : {POLICY_CLOCK, POLICY_LRU_K, POLICY_2Q, POLICY_ARC}) {
+        size_t hits = 0;
+        double ms = replay(kind, frames, trace, hits);
+        std::cout << std::left << std::setw(8) << ReplacementPolicy::create(kind, 1)->name()
+                  << std::right << std::setw(12) << hits
+                  << std::setw(12) << trace.size() - hits
+                  << std::setw(11) << std::fixed << std::setprecision(2) << 100.0 * hits / std::max<size_t>(trace.size(), 1) << "%"
+                  << std::setw(12) << ms << "\n";
+    }
+    return 0;
+}
+
+static double timeLookups(HeapFile& heap, int rows, int lookups, size_t& found) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> pick(0, rows - 1);
+    found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        found += heap.select({"name", "user" + std::to_string(pick(rng))}).size();
+    }
+    return elapsedMs(start) / lookups;
+}
+
+static int benchIndex(int rows, int lookups) {
+    loadTable(rows);
+    DataBase db(BENCH_DB, 256);
+    Table* table = db.getTable("bench");
+    HeapFile heap(table);
+
+    size_t found = 0;
+    int scans = std::max(lookups / 100, 1);
+    double scanMs = timeLookups(heap, rows, scans, found);
+    std::cout << std::left << std::setw(8) << "method"
+              << std::right << std::setw(10) << "lookups"
+              << std::setw(10) << "found"
+              << std::setw(14) << "ms/lookup" << "\n";
+    std::cout << std::left << std::setw(8) << "scan"
+              << std::right << std::setw(10) << scans
+              << std::setw(10) << found
+              << std::setw(14) << std::fixed << std::setprecision(4) << scanMs << "\n";
+
+    auto start = std::chrono::steady_clock::now();
+    heap.create_index("by_name", "name");
+    double buildMs = elapsedMs(start);
+    double indexMs = timeLookups(heap, rows, lookups, found);
+    std::cout << std::left << std::setw(8) << "btree"
+              << std::right << std::setw(10) << lookups
+              << std::setw(10) << found
+              << std::setw(14) << indexMs << "\n";
+    int height = heap.tree_on("name")->height();
+
+    start = std::chrono::steady_clock::now();
+    heap.create_index("by_name_hash", "name", INDEX_HASH);
+    double hashBuildMs = elapsedMs(start);
+    double hashMs = timeLookups(heap, rows, lookups, found);
+    std::cout << std::left << std::setw(8) << "hash"
+              << std::right << std::setw(10) << lookups
+              << std::setw(10) << found
+              << std::setw(14) << hashMs << "\n";
+    std::cout << "bulk load of " << rows << " keys: btree " << std::setprecision(2) << buildMs << " ms, height "
+              << height << ", " << std::setprecision(1) << scanMs / indexMs << "x faster lookups; hash "
+              << std::setprecision(2) << hashBuildMs << " ms, global depth "
+              << static_cast<HashIndex*>(heap.index_on("name"))->depth() << ", " << std::setprecision(1)
+              << scanMs / hashMs << "x faster lookups\n";
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Reads every page and filters, the way a scan works without zone maps.
+static size_t scanFilter(Table* table, const std::string& column, const std::optional<KeyBound>& low, const std::optional<KeyBound>& high) {
+    size_t found = 0;
+    for (uint32_t pageId = 1; pageId <= table->page_count; pageId++) {
+        Page* page = table->Read_page(pageId);
+        if (page == nullptr) {
+            continue;
+        }
+        for (Tuple& tuple : page->get_tuple({" ", " "})) {
+            std::string value = tuple.get_attribute(column);
+            found += (!low || BPlusTree::compareKeys(value, low->key) >= 0) && (!high || BPlusTree::compareKeys(value, high->key) <= 0);
+        }
+        table->Release_page(page);
+    }
+    return found;
+}
+
+static void zoneRow(const std::string& query, size_t found, double scanMs, double zoneMs) {
+    std::cout << std::left << std::setw(20) << query
+              << std::right << std::setw(8) << found
+              << std::setw(12) << std::fixed << std::setprecision(3) << scanMs
+              << std::setw(12) << zoneMs
+              << std::setw(9) << std::setprecision(1) << scanMs / zoneMs << "x\n";
+}
+
+static int benchZone(int rows) {
+    std::filesystem::remove_all(BENCH_DB);
+    {
+        DataBase db(BENCH_DB);
+        db.createDatabase();
+        ExecutionEngine engine(db);
+        engine.Create_table("events", {{"ts", "INT"}, {"payload", "VARCHAR"}});
+        for (int i = 0; i < rows; i++) {
+            engine.insert("events", {{"ts", {0, std::to_string(1000000 + i)}}, {"payload", {1, std::string(60, 'p')}}});
+        }
+    }
+    DataBase db(BENCH_DB, 256);
+    Table* table = db.getTable("events");
+    HeapFile heap(table);
+    std::cout << rows << " rows in " << table->page_count << " pages\n";
+    std::cout << std::left << std::setw(20) << "filter"
+              << std::right << std::setw(8) << "rows"
+              << std::setw(12) << "scan ms"
+              << std::setw(12) << "zone ms" << "\n";
+
+    std::optional<KeyBound> recent = KeyBound{std::to_string(1000000 + rows - rows / 20), true};
+    auto start = std::chrono::steady_clock::now();
+    size_t found = scanFilter(table, "ts", recent, std::nullopt);
+    double scanMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    found = heap.select_range("ts", recent, std::nullopt).size();
+    zoneRow("ts >= last 5%", found, scanMs, elapsedMs(start));
+
+    std::optional<KeyBound> point = KeyBound{std::to_string(1000000 + rows / 3), true};
+    start = std::chrono::steady_clock::now();
+    found = scanFilter(table, "ts", point, point);
+    scanMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    found = heap.select({"ts", point->key}).size();
+    zoneRow("ts = x", found, scanMs, elapsedMs(start));
+
+    std::optional<KeyBound> missing = KeyBound{"absent", true};
+    start = std::chrono::steady_clock::now();
+    found = scanFilter(table, "payload", missing, missing);
+    scanMs = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    found = heap.select({"payload", "absent"}).size();
+    zoneRow("payload = absent", found, scanMs, elapsedMs(start));
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Sensor readings uniform in 0..999, with a short text column alongside.
+static void loadReadings(int rows, std::mt19937_64& rng) {
+    std::filesystem::remove_all(BENCH_DB);
+    DataBase db(BENCH_DB);
+    db.createDatabase();
+    ExecutionEngine engine(db);
+    engine.Create_table("readings", {{"sensor", "INT"}, {"reading", "INT"}, {"note", "VARCHAR"}});
+    for (int i = 0; i < rows; i++) {
+        engine.insert("readings", {{"sensor", {0, std::to_string(i % 64)}},
+                                   {"reading", {0, std::to_string(rng() % 1000)}},
+                                   {"note", {1, std::string(24, 'n')}}});
+    }
+}
+
+// Runs the kernels over Batch::CAPACITY sized chunks, the way batches reach them.
+static void kernelRow(const std::vector<int64_t>& values, int rounds) {
+    std::vector<uint32_t> selection(Batch::CAPACITY);
+    size_t kept = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < values.size(); i += Batch::CAPACITY) {
+            size_t n = std::min(Batch::CAPACITY, values.size() - i);
+            kept += kernels::select(values.data() + i, n, CMP_LT, 500, selection.data());
+        }
+    }
+    double filterMs = elapsedMs(start);
+    int64_t total = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < values.size(); i += Batch::CAPACITY) {
+            total += kernels::sum(values.data() + i, std::min(Batch::CAPACITY, values.size() - i));
+        }
+    }
+    double sumMs = elapsedMs(start);
+    double processed = static_cast<double>(values.size()) * rounds / 1000.0;
+    std::cout << std::left << std::setw(10) << kernels::simd_level()
+              << std::right << std::setw(16) << std::fixed << std::setprecision(0) << processed / filterMs
+              << std::setw(16) << processed / sumMs
+              << std::setw(12) << kept / rounds << "  (sum " << total / rounds << ")\n";
+}
+
+static int benchVector(int rows) {
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> values(1 << 22);
+    for (int64_t& value : values) {
+        value = static_cast<int64_t>(rng() % 1000);
+    }
+    std::cout << std::left << std::setw(10) << "kernels"
+              << std::right << std::setw(16) << "filter Mval/s"
+              << std::setw(16) << "sum Mval/s"
+              << std::setw(12) << "selected" << "\n";
+    for (const char* level : {"scalar", "sse4.2", "avx2"}) {
+        if (kernels::set_level(level)) {
+            kernelRow(values, 20);
+        }
+    }
+    if (!kernels::set_level("avx2")) {
+        kernels::set_level("sse4.2");
+    }
+
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    Table* table = db.getTable("readings");
+    HeapFile heap(table);
+    std::optional<KeyBound> high = KeyBound{"100", false};
+    std::cout << "\n" << rows << " rows in " << table->page_count << " pages, reading < 100\n";
+
+    Filter rowPlan(std::make_unique<SeqScan>(&heap), [&](Tuple& tuple) {
+        return HeapFile::in_range(tuple.get_attribute("reading"), std::nullopt, high);
+    });
+    BatchToRows vectorPlan(std::make_unique<BatchFilter>(
+        std::make_unique<BatchScan>(&heap, std::vector<std::string>{"reading"}), "reading", CMP_LT, 100));
+    double rowMs = 0, vectorMs = 0;
+    size_t rowFound = 0, vectorFound = 0;
+    for (auto [plan, ms, found] : {std::tuple<Operator*, double*, size_t*>{&rowPlan, &rowMs, &rowFound},
+                                   std::tuple<Operator*, double*, size_t*>{&vectorPlan, &vectorMs, &vectorFound}}) {
+        Tuple tuple;
+        plan->open();
+        auto start = std::chrono::steady_clock::now();
+        for (*found = 0; plan->next(tuple);) {
+            (*found)++;
+        }
+        *ms = elapsedMs(start);
+        plan->close();
+    }
+    std::cout << "row at a time   " << std::setw(8) << rowFound << std::setw(12) << std::setprecision(3) << rowMs << " ms\n";
+    std::cout << "vectorized      " << std::setw(8) << vectorFound << std::setw(12) << vectorMs << " ms"
+              << std::setw(9) << std::setprecision(1) << rowMs / vectorMs << "x\n";
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// A filtered scan through ParallelScan, and a sum whose per-morsel partial results are added up
+// at the end, at growing degrees of parallelism.
+static int benchParallel(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    Table* table = db.getTable("readings");
+    HeapFile heap(table);
+    size_t morsels = ParallelScan::morsels(table->page_count);
+    std::cout << rows << " rows in " << table->page_count << " pages (" << morsels << " morsels), "
+              << ThreadPool::shared().size() << " pool threads\n";
+    std::cout << std::right << std::setw(8) << "threads" << std::setw(10) << "rows" << std::setw(14) << "filter ms"
+              << std::setw(16) << "sum" << std::setw(12) << "sum ms" << "\n";
+
+    size_t widest = std::max<size_t>(4, ThreadPool::shared().size());
+    for (size_t parallelism = 1; parallelism <= widest; parallelism *= 2) {
+        ParallelScan scan(&heap, [&](uint32_t first, uint32_t last) {
+            auto batches = std::make_unique<BatchScan>(&heap, std::vector<std::string>{"reading"});
+            batches->restrict(first, last);
+            return std::make_unique<BatchFilter>(std::move(batches), "reading", CMP_LT, 100);
+        }, parallelism);
+        Tuple tuple;
+        size_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        scan.open();
+        while (scan.next(tuple)) {
+            found++;
+        }
+        scan.close();
+        double filterMs = elapsedMs(start);
+
+        std::vector<int64_t> partial(morsels, 0);
+        start = std::chrono::steady_clock::now();
+        ThreadPool::shared().run(morsels, parallelism, [&](size_t morsel) {
+            uint32_t first = static_cast<uint32_t>(morsel) * ParallelScan::MORSEL_PAGES + 1;
+            BatchScan batches(&heap, {"reading"});
+            batches.restrict(first, first + ParallelScan::MORSEL_PAGES - 1);
+            Batch batch;
+            batches.open();
+            while (batches.next(batch)) {
+                partial[morsel] += kernels::sum(batch.columns[0].ints.data(), batch.count);
+            }
+            batches.close();
+        });
+        int64_t total = 0;
+        for (int64_t sum : partial) {
+            total += sum;
+        }
+        double sumMs = elapsedMs(start);
+        std::cout << std::setw(8) << parallelism << std::setw(10) << found << std::setw(14) << std::fixed << std::setprecision(3) << filterMs
+                  << std::setw(16) << total << std::setw(12) << sumMs << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Plans the query through the parser and the engine, as the shell does, and counts its rows.
+static size_t runQuery(ExecutionEngine& engine, const std::string& query, double& ms) {
+    QueryAnalyzer analyzer;
+    std::vector<ExecutionStep> steps = analyzer.analyze(query);
+    std::unique_ptr<Operator> root = engine.plan(analyzer.getQueryInfo(), steps);
+    size_t found = 0;
+    Tuple tuple;
+    auto start = std::chrono::steady_clock::now();
+    root->open();
+    while (root->next(tuple)) {
+        found++;
+    }
+    root->close();
+    ms = elapsedMs(start);
+    return found;
+}
+
+// Every reading matches the one tag of its value. The tags are the build side; a budget below
+// their size sends the join through its partition files, and one below a partition's size makes
+// it split the partitions again.
+static int benchJoin(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    {
+        DataBase db(BENCH_DB);
+        ExecutionEngine engine(db);
+        engine.Create_table("tags", {{"value", "INT"}, {"tag", "VARCHAR"}});
+        for (int i = 0; i < 1000; i++) {
+            engine.insert("tags", {{"value", {0, std::to_string(i)}}, {"tag", {1, "tag" + std::to_string(i)}}});
+        }
+    }
+    DataBase db(BENCH_DB, 4096);
+    ExecutionEngine engine(db);
+    std::cout << rows << " readings joined to 1000 tags\n";
+    std::cout << std::left << std::setw(28) << "plan" << std::right << std::setw(10) << "rows" << std::setw(12) << "ms" << "\n";
+    const std::string join = "SELECT sensor, tag FROM readings JOIN tags ON reading = value";
+    struct Case {
+        const char* label;
+        size_t memory;
+        std::string suffix;
+    };
+    for (const Case& run : {Case{"in memory, serial scans", ExecutionEngine::DEFAULT_WORK_MEMORY, " PARALLEL 1"},
+                            Case{"grace, serial scans", 16u << 10, " PARALLEL 1"},
+                            Case{"grace split again, serial", 4u << 10, " PARALLEL 1"},
+                            Case{"in memory, parallel scans", ExecutionEngine::DEFAULT_WORK_MEMORY, ""},
+                            Case{"grace, parallel scans", 16u << 10, ""}}) {
+        engine.workMemory = run.memory;
+        double ms;
+        size_t found = runQuery(engine, join + run.suffix, ms);
+        std::cout << std::left << std::setw(28) << run.label << std::right << std::setw(10) << found
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// The per-sensor statistics the dashboards compute, once from every row the way a client does
+// it and then as one GROUP BY query at a time.
+static int benchAggregate(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    ExecutionEngine engine(db);
+    std::cout << rows << " readings, 64 sensors\n";
+    std::cout << std::left << std::setw(28) << "plan" << std::right << std::setw(10) << "rows" << std::setw(12) << "ms" << "\n";
+
+    QueryAnalyzer analyzer;
+    std::vector<ExecutionStep> steps = analyzer.analyze("SELECT * FROM readings");
+    std::unique_ptr<Operator> all = engine.plan(analyzer.getQueryInfo(), steps);
+    std::map<std::string, std::tuple<int64_t, int64_t, int64_t, int64_t>> sensors;
+    Tuple tuple;
+    auto start = std::chrono::steady_clock::now();
+    all->open();
+    while (all->next(tuple)) {
+        int64_t reading = std::stoll(tuple.get_attribute("reading"));
+        auto [entry, fresh] = sensors.try_emplace(tuple.get_attribute("sensor"), 0, 0, reading, reading);
+        auto& [count, sum, low, high] = entry->second;
+        count++;
+        sum += reading;
+        low = std::min(low, reading);
+        high = std::max(high, reading);
+    }
+    all->close();
+    std::cout << std::left << std::setw(28) << "client side" << std::right << std::setw(10) << sensors.size()
+              << std::setw(12) << std::fixed << std::setprecision(3) << elapsedMs(start) << "\n";
+
+    const std::string query = "SELECT sensor, COUNT(*), SUM(reading), MIN(reading), MAX(reading), AVG(reading) FROM readings GROUP BY sensor";
+    struct Case {
+        const char* label;
+        size_t memory;
+        std::string suffix;
+    };
+    for (const Case& run : {Case{"GROUP BY, serial", ExecutionEngine::DEFAULT_WORK_MEMORY, " PARALLEL 1"},
+                            Case{"GROUP BY, parallel", ExecutionEngine::DEFAULT_WORK_MEMORY, ""},
+                            Case{"GROUP BY, parallel, spilled", 4u << 10, ""}}) {
+        engine.workMemory = run.memory;
+        double ms;
+        size_t found = runQuery(engine, query + run.suffix, ms);
+        std::cout << std::left << std::setw(28) << run.label << std::right << std::setw(10) << found << std::setw(12) << ms << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// A report export: every reading ordered by value, then sensor.
+static int benchSort(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    ExecutionEngine engine(db);
+    std::cout << rows << " readings\n";
+    std::cout << std::left << std::setw(28) << "plan" << std::right << std::setw(10) << "rows" << std::setw(12) << "ms" << "\n";
+    const std::string query = "SELECT sensor, reading FROM readings ORDER BY reading DESC, sensor";
+    struct Case {
+        const char* label;
+        size_t memory;
+        std::string suffix;
+    };
+    for (const Case& run : {Case{"in memory", ExecutionEngine::DEFAULT_WORK_MEMORY, ""},
+                            Case{"runs of 256 KB, merged", 256u << 10, ""},
+                            Case{"runs of 16 KB, two passes", 16u << 10, ""},
+                            Case{"LIMIT 100, top-k heap", ExecutionEngine::DEFAULT_WORK_MEMORY, " LIMIT 100"}}) {
+        engine.workMemory = run.memory;
+        double ms;
+        size_t found = runQuery(engine, query + run.suffix, ms);
+        std::cout << std::left << std::setw(28) << run.label << std::right << std::setw(10) << found
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// One narrow column of every reading, and of the readings under 100, each read once by decoding
+// whole rows and projecting them and once by decoding just that column, from a warm pool.
+static int benchProject(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    HeapFile heap(db.getTable("readings"));
+    std::cout << rows << " readings, SELECT sensor\n";
+    std::cout << std::left << std::setw(28) << "plan" << std::right << std::setw(10) << "rows" << std::setw(12) << "ms" << "\n";
+    const std::vector<std::string> sensor{"sensor"};
+    auto filtered = [&heap]() {
+        auto batches = std::make_unique<BatchScan>(&heap, std::vector<std::string>{"reading"});
+        return std::make_unique<BatchFilter>(std::move(batches), "reading", CMP_LT, 100);
+    };
+    std::vector<std::pair<const char*, std::unique_ptr<Operator>>> cases;
+    cases.emplace_back("scan, whole rows", std::make_unique<Project>(std::make_unique<SeqScan>(&heap), sensor));
+    cases.emplace_back("scan, sensor only", std::make_unique<SeqScan>(&heap, "", std::nullopt, std::nullopt, sensor));
+    cases.emplace_back("filtered, whole rows", std::make_unique<Project>(std::make_unique<BatchToRows>(filtered()), sensor));
+    cases.emplace_back("filtered, sensor only", std::make_unique<BatchToRows>(filtered(), sensor));
+    Tuple tuple;
+    SeqScan warm(&heap, "", std::nullopt, std::nullopt, sensor);
+    warm.open();
+    while (warm.next(tuple)) {
+    }
+    warm.close();
+    for (auto& [label, root] : cases) {
+        size_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        root->open();
+        while (root->next(tuple)) {
+            found++;
+        }
+        root->close();
+        std::cout << std::left << std::setw(28) << label << std::right << std::setw(10) << found
+                  << std::setw(12) << std::fixed << std::setprecision(3) << elapsedMs(start) << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Id lookups of the given rows, each a read through the id directory.
+static double timeIdLookups(HeapFile& heap, const std::vector<std::string>& ids, size_t& found) {
+    found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& id : ids) {
+        found += heap.select({"id", id}).size();
+    }
+    return elapsedMs(start);
+}
+
+// Rewrites the note of one sensor's readings, first at its own length so every row stays in its
+// slot, then four times as long so most rows move to other pages behind forwarding stubs.
+static int benchUpdate(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    HeapFile heap(db.getTable("readings"));
+    std::cout << rows << " readings, UPDATE readings SET note = ... WHERE sensor = 5\n";
+    std::cout << std::left << std::setw(28) << "plan" << std::right << std::setw(10) << "rows" << std::setw(12) << "ms" << "\n";
+
+    std::vector<std::string> moved, stayed;
+    SeqScan scan(&heap, "", std::nullopt, std::nullopt, {"id", "sensor"});
+    Tuple tuple;
+    scan.open();
+    while (scan.next(tuple)) {
+        std::string sensor = tuple.get_attribute("sensor");
+        if (sensor == "5") {
+            moved.push_back(tuple.get_attribute("id"));
+        } else if (sensor == "6") {
+            stayed.push_back(tuple.get_attribute("id"));
+        }
+    }
+    scan.close();
+
+    std::string error;
+    std::shared_ptr<const Expression> where = Expression::compile("sensor = 5", db.getTable("readings")->schema, error);
+    for (const auto& [label, note] : {std::make_pair("in place", std::string(24, 'm')), std::make_pair("growing, relocated", std::string(96, 'g'))}) {
+        size_t updated = 0;
+        auto start = std::chrono::steady_clock::now();
+        heap.update_tuples(where.get(), {{"note", note}}, updated);
+        std::cout << std::left << std::setw(28) << label << std::right << std::setw(10) << updated
+                  << std::setw(12) << std::fixed << std::setprecision(3) << elapsedMs(start) << "\n";
+    }
+    size_t found;
+    double ms = timeIdLookups(heap, stayed, found);
+    std::cout << std::left << std::setw(28) << "id lookups, unmoved rows" << std::right << std::setw(10) << found << std::setw(12) << ms << "\n";
+    ms = timeIdLookups(heap, moved, found);
+    std::cout << std::left << std::setw(28) << "id lookups, moved rows" << std::right << std::setw(10) << found << std::setw(12) << ms << "\n";
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Deletes every reading below 500, which leaves holes in every page, then the rows of the newer
+// half of the pages, which empties the end of the table. DELETE only frees slots; VACUUM compacts
+// the pages with holes and gives the empty ones at the end back to the file.
+static int benchDelete(int rows) {
+    std::mt19937_64 rng(42);
+    loadReadings(rows, rng);
+    DataBase db(BENCH_DB, 4096);
+    Table* table = db.getTable("readings");
+    HeapFile heap(table);
+    std::cout << rows << " readings\n";
+    std::cout << std::left << std::setw(28) << "step" << std::right << std::setw(10) << "pages" << std::setw(12) << "ms"
+              << std::setw(12) << "compacted" << std::setw(10) << "released" << "\n";
+
+    std::string tail = "id > " + std::to_string(table->page_count / 2 * Page::MAX_SLOTS);
+    for (const std::string& condition : {std::string("reading < 500"), tail}) {
+        std::string error;
+        std::shared_ptr<const Expression> where = Expression::compile(condition, table->schema, error);
+        auto start = std::chrono::steady_clock::now();
+        heap.delete_tuples(where.get());
+        double ms = elapsedMs(start);
+        std::cout << std::left << std::setw(28) << "DELETE WHERE " + condition << std::right << std::setw(10) << table->page_count
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms << "\n";
+
+        size_t compacted = 0, released = 0;
+        start = std::chrono::steady_clock::now();
+        heap.vacuum(compacted, released);
+        ms = elapsedMs(start);
+        std::cout << std::left << std::setw(28) << "VACUUM" << std::right << std::setw(10) << table->page_count
+                  << std::setw(12) << ms << std::setw(12) << compacted << std::setw(10) << released << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+// Every page stays resident, so each request is a hit: a page table lookup, a pin and an unpin.
+// The background writer is off, so only the client threads touch the pool.
+static int benchPool(size_t maxThreads) {
+    const int pages = 512;
+    const int operations = 400000;
+    std::filesystem::remove_all(BENCH_DB);
+    std::filesystem::create_directories(BENCH_DB);
+    FileManager files;
+    int fileId = files.openFile(BENCH_DB + "/pool.dat");
+    std::vector<char> zeros(PAGE_SIZE, 0);
+    for (int page = 0; page < pages; page++) {
+        files.writePage(fileId, page, zeros.data());
+    }
+    PoolOptions options;
+    options.size = pages * 2;
+    options.backgroundWriter = false;
+    BufferPool pool(&files, options);
+    for (int page = 0; page < pages; page++) {
+        pool.releasePage(pool.requestPage(fileId, page, DATA_PAGE));
+    }
+
+    std::cout << pages << " resident pages, " << operations << " hits per thread, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << std::right << std::setw(8) << "threads" << std::setw(12) << "ms" << std::setw(14) << "ops/s"
+              << std::setw(18) << "ops/s per thread" << std::setw(10) << "speedup" << "\n";
+    double single = 0;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<std::thread> workers;
+        std::atomic<size_t> misses{0};
+        auto start = std::chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(static_cast<unsigned>(t + 1));
+                for (int i = 0; i < operations; i++) {
+                    Buffer_Page* page = pool.requestPage(fileId, static_cast<int>(rng() % pages), DATA_PAGE);
+                    if (page == nullptr) {
+                        misses++;
+                        continue;
+                    }
+                    pool.releasePage(page);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        double ms = elapsedMs(start);
+        double rate = threads * operations / (ms / 1000.0);
+        if (threads == 1) {
+            single = rate;
+        }
+        std::cout << std::setw(8) << threads << std::setw(12) << std::fixed << std::setprecision(1) << ms
+                  << std::setw(14) << std::setprecision(0) << rate << std::setw(18) << rate / threads
+                  << std::setw(10) << std::setprecision(2) << rate / single << (misses > 0 ? "  (failed requests)" : "") << "\n";
+    }
+    std::filesystem::remove_all(BENCH_DB);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "io";
+    if (mode == "io") {
+        int rows = argc > 2 ? std::stoi(argv[2]) : 20000;
+        int scans = argc > 3 ? std::stoi(argv[3]) : 5;
+        return benchIo(rows, scans);
+    }
+    if (mode == "policy") {
+        int frames = argc > 2 ? std::stoi(argv[2]) : 1024;
+        return benchPolicy(frames, argc > 3 ? argv[3] : "");
+    }
+    if (mode == "index") {
+        int rows = argc > 2 ? std::stoi(argv[2]) : 20000;
+        int lookups = argc > 3 ? std::stoi(argv[3]) : 10000;
+        return benchIndex(rows, lookups);
+    }
+    if (mode == "zone") {
+        return benchZone(argc > 2 ? std::stoi(argv[2]) : 50000);
+    }
+    if (mode == "vector") {
+        return benchVector(argc > 2 ? std::stoi(argv[2]) : 100000);
+    }
+    if (mode == "parallel") {
+        if (argc > 3) {
+            ThreadPool::configure(std::stoul(argv[3]));
+        }
+        return benchParallel(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "join") {
+        return benchJoin(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "aggregate") {
+        return benchAggregate(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "sort") {
+        return benchSort(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "project") {
+        return benchProject(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "update") {
+        return benchUpdate(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "delete") {
+        return benchDelete(argc > 2 ? std::stoi(argv[2]) : 200000);
+    }
+    if (mode == "pool") {
+        return benchPool(argc > 2 ? std::stoul(argv[2]) : std::max<size_t>(8, std::thread::hardware_concurrency()));
+    }
+    std::cerr << "Unknown benchmark: " << mode << std::endl;
+    return 1;
+}
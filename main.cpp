@@ -17,6 +17,7 @@ int main(int argc, char* argv[]) {
      
         Table* my_table = db.getTable("table");   
         Page* page = my_table->Create_page();
+        my_table->Update_page(page->pageId, page);
         
         Page* ll = my_table->Get_page(1);
          std::vector<std::pair<std::string, std::pair<int, std::string>>> attributes = {
@@ -27,13 +28,13 @@ int main(int argc, char* argv[]) {
         {"Hobby", {5, "Reading"}}     
     };
         ll->insert_tuple(attributes);
-        ll->serialize(1,"test","table");
         std::vector<Tuple> res=ll->get_tuple({"Name","Alice"});
         std::cout<<res.size()<<std::endl;
-        std::cout<<ll->tuples.size()<<std::endl;
-        std::cout<<ll->tuples[0].get_attribute("Name")<<std::endl;
+        std::cout<<ll->slot_count()<<std::endl;
+        std::cout<<res[0].get_attribute("Name")<<std::endl;
         
-        std::cout<<ll->tuples[0].get_attribute("City")<<std::endl;
+        std::cout<<res[0].get_attribute("City")<<std::endl;
+        my_table->Update_page(1, ll);
 
     return 0;
 }
@@ -1,5 +1,6 @@
 #include "DataBase.hpp"
 #include "ExcuetionEngine.hpp"
+#include "ThreadPool.hpp"
 #include <iostream>
 #include <cstring>
 #include <vector>
@@ -7,21 +8,41 @@
 #include <iomanip>
 #include <string>
 using namespace std;
-void printTuples(const std::vector<Tuple>& tuples);
-std::pair<std::string, std::string> extractFirstAndLast(const std::string& input);
+void printRows(Operator& root);
 
 int main(int argc, char* argv[]){
 
-    DataBase db (argv[1]);
+    PoolOptions pool_options;
+    pool_options.size = argc > 2 ? std::stoi(argv[2]) : DEFAULT_POOL_SIZE;
+    IoBackend backend = IO_PREAD;
+    bool direct_io = false;
+    size_t work_memory = ExecutionEngine::DEFAULT_WORK_MEMORY;
+    for (int i = 3; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "mmap") {
+            backend = IO_MMAP;
+        } else if (flag == "direct") {
+            direct_io = true;
+        } else if (flag.rfind("trace=", 0) == 0) {
+            pool_options.tracePath = flag.substr(6);
+        } else if (flag.rfind("threads=", 0) == 0) {
+            ThreadPool::configure(std::stoul(flag.substr(8)));
+        } else if (flag.rfind("work_mem=", 0) == 0) {
+            work_memory = std::stoul(flag.substr(9)) << 10;
+        } else if (!ReplacementPolicy::parse(flag, pool_options.policy)) {
+            std::cerr << "Unknown option: " << flag << std::endl;
+        }
+    }
+    DataBase db (argv[1], pool_options, backend, direct_io);
     db.createDatabase();
     ExecutionEngine Eg(db);
+    Eg.workMemory = work_memory;
     QueryAnalyzer analyzer = QueryAnalyzer();
      while(true)
     {
         string query;
         cout<<"Enter your query: ";
-        getline(cin, query);
-        if(query=="exit")
+        if(!getline(cin, query) || query=="exit")
         {
             break;
         }
@@ -64,23 +85,18 @@ int main(int argc, char* argv[]){
     }
 
     else if(queryInfo.type == "SELECT"){
-        if (queryInfo.condition.size() == 0){
-            std::vector<Tuple> r =Eg.select(queryInfo.tableName,{" "," "});
-            printTuples(r);
-        }
-        else{
-            std::pair p =extractFirstAndLast(queryInfo.condition);
-            std::vector<Tuple> r =Eg.select(queryInfo.tableName,{p.first,p.second});
-            printTuples(r);
+        std::unique_ptr<Operator> root = Eg.plan(queryInfo, initialPlan);
+        if (root) {
+            printRows(*root);
         }
+    } else if(queryInfo.type == "CREATE_INDEX"){
+        Eg.createIndex(queryInfo.tableName, queryInfo.indexName, col[0], queryInfo.indexMethod);
     } else if(queryInfo.type == "DELETE"){
-        if (queryInfo.condition.size() == 0){
-            Eg.deleteRecord(queryInfo.tableName,{" "," "});
-
-        }
-        else{
-                Eg.deleteRecord(queryInfo.tableName,{" "," "});
-        }
+        Eg.deleteRecord(queryInfo.tableName, queryInfo.condition);
+    } else if(queryInfo.type == "UPDATE"){
+        Eg.update(queryInfo.tableName, col, queryInfo.condition);
+    } else if(queryInfo.type == "VACUUM"){
+        Eg.vacuum(queryInfo.tableName);
     }
 
     }
@@ -88,113 +104,25 @@ int main(int argc, char* argv[]){
     return 0;
 }
 
-void printTuples(const std::vector<Tuple>& tuples) {
-    if (tuples.empty()) {
-        std::cout << "No tuples to display.\n";
-        return;
-    }
-
-    
-    std::cout << std::left << std::setw(15) << "Key" << std::setw(15) << "Value" << "\n";
-    std::cout << std::setfill('-') << std::setw(30) << "" << std::setfill(' ') << "\n";
-
-    
-    for ( auto tuple : tuples) {
-        std::string s = "id";
-        if(tuple.get_attribute(s).size()!=0){
-        for (const auto& attr : tuple.attributes) {
-            
-            std::cout << std::left << std::setw(15) << attr.first << std::setw(15) ;
-            std::cout<<attr.second.second<< "\n";
+// Streams the rows of a plan to the client as they are produced.
+void printRows(Operator& root) {
+    size_t rows = 0;
+    Tuple tuple;
+    root.open();
+    while (root.next(tuple)) {
+        if (rows++ == 0) {
+            std::cout << std::left << std::setw(15) << "Key" << std::setw(15) << "Value" << "\n";
+            std::cout << std::setfill('-') << std::setw(30) << "" << std::setfill(' ') << "\n";
         }
+        for (const auto& attr : tuple.attributes) {
+            std::cout << std::left << std::setw(15) << attr.first << std::setw(15);
+            std::cout << attr.second.second << "\n";
         }
         std::cout << std::setfill('-') << std::setw(30) << "" << std::setfill(' ') << "\n";
     }
-}
-
-
-std::pair<std::string, std::string> extractFirstAndLast(const std::string& input) {
-    
-    size_t firstSpace = input.find(' ');
-    if (firstSpace == std::string::npos) {
-        throw std::invalid_argument("No spaces found in the string.");
-    }
-
-    
-    size_t lastSpace = input.rfind(' ');
-    if (lastSpace == std::string::npos || lastSpace == firstSpace) {
-        throw std::invalid_argument("Only one space found in the string.");
+    root.close();
+    if (rows == 0) {
+        std::cout << "No tuples to display.\n";
     }
-
-    
-    std::string first = input.substr(0, firstSpace);
-
-    
-    std::string last = input.substr(lastSpace + 1);
-
-    return {first, last};
 }
 
-
-
-
-
-
-
-  
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-        
-  
-  
-
-
-
-
-
-
-     
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-        
-
-
-
-
-
-
-
-
-
-
-
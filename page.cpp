@@ -1,225 +1,389 @@
 #include "page.hpp"
 #include "tuple.hpp"
-#include <fstream>
 #include <iostream>
 #include <utility>
-#include <cstring> 
+#include <cstring>
 #include <arpa/inet.h>
 #include <memory>
-Page::Page(int free,std::pair<int,int>)
-        : freespace(free),
-          ids_Range({0, 0})
+#include <algorithm>
+
+static uint16_t read_u16(const char* src) {
+    uint16_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return ntohs(value);
+}
+
+static void write_u16(char* dst, uint16_t value) {
+    value = htons(value);
+    std::memcpy(dst, &value, sizeof(value));
+}
+
+static int read_i32(const char* src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return static_cast<int>(ntohl(value));
+}
+
+static void write_i32(char* dst, int value) {
+    uint32_t network = htonl(static_cast<uint32_t>(value));
+    std::memcpy(dst, &network, sizeof(network));
+}
+
+// A Page is a view over PAGE_SIZE bytes owned by someone else, normally a pinned buffer frame.
+Page::Page(int page_id, char* data)
+        : pageId(page_id),
+          freespace(read_i32(data)),
+          ids_Range({read_i32(data + 4), read_i32(data + 8)}),
+          PageData(data)
           {
-        
-        std::memset(PageData, 0, PAGE_SIZE);
-    }
-    #pragma pack(push, 1)
-bool Page::insert_tuple(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes){
-    Tuple* t = new Tuple();
-    
-    if (freespace >= 50){
-        freespace -= 50;
-        for (const auto& attr : attributes) {
-        t->add_attribute(attr.first, attr.second.second);
-    }
-    t->add_attribute("id",std::to_string(tuples.size()+ ids_Range.first));
     }
-    tuples.push_back(*t);
+
+void Page::init(std::pair<int,int> ids) {
+    std::memset(PageData, 0, PAGE_SIZE);
+    freespace = PAGE_SIZE - HEADER_SIZE;
+    ids_Range = ids;
+    write_header(0, PAGE_SIZE);
 }
 
-bool Page::del_tuple(const std::pair<std::string, std::string>& attribute){
-        if(!(attribute.first == " " && attribute.second == " ")){
+void Page::assign_ids(std::pair<int,int> ids) {
+    ids_Range = ids;
+    write_header(slot_count(), data_start());
+}
 
-            tuples.clear();
-            std::cout<<"All - >"<<tuples.size()<<std::endl;
-        }
-        else{
-            std::vector<Tuple> res= get_tuple(attribute);
-            for(int i = 0;i<res.size();i++){
-                for(int j = 0;j<tuples.size();j++){
-                    if(tuples[j].get_attribute(attribute.first) == res[i].get_attribute(attribute.first)){
-                        tuples.erase(tuples.begin()+i);
-                    }
-                }
-            }
-        std::cout<<" ->"<<tuples.size()<<std::endl;
-        }
+// Header: freespace | next id to issue | last id of the block | slot count | start of record area.
+// The slot directory (offset, length) follows the header and records are packed from the end of the page.
+void Page::write_header(int slots, uint16_t start) {
+    write_i32(PageData, freespace);
+    write_i32(PageData + 4, ids_Range.first);
+    write_i32(PageData + 8, ids_Range.second);
+    write_u16(PageData + 12, static_cast<uint16_t>(slots));
+    write_u16(PageData + 14, start);
+}
+
+int Page::slot_count() const {
+    return read_u16(PageData + 12);
+}
+
+uint16_t Page::data_start() const {
+    return read_u16(PageData + 14);
+}
+
+uint16_t Page::slot_offset(int slot) const {
+    return read_u16(PageData + HEADER_SIZE + slot * SLOT_SIZE);
+}
+
+uint16_t Page::slot_length(int slot) const {
+    return read_u16(PageData + HEADER_SIZE + slot * SLOT_SIZE + 2);
+}
+
+void Page::set_slot(int slot, uint16_t offset, uint16_t length) {
+    write_u16(PageData + HEADER_SIZE + slot * SLOT_SIZE, offset);
+    write_u16(PageData + HEADER_SIZE + slot * SLOT_SIZE + 2, length);
+}
+
+int Page::contiguous_free() const {
+    return data_start() - (HEADER_SIZE + slot_count() * SLOT_SIZE);
 }
 
+int Page::next_slot() const {
+    int slots = slot_count();
+    for (int i = 0; i < slots; i++) {
+        if (slot_offset(i) == 0) {
+            return i;
+        }
+    }
+    return slots;
+}
 
-bool Page::serialize(int page_id, const std::string& dbName, const std::string& tableName) {
-    std::string filePath = dbName + "/" + tableName + ".HAD";
-    std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
-    
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file for writing: " << filePath << std::endl;
+bool Page::can_fit(size_t length) const {
+    int slot = next_slot();
+    if (slot >= MAX_SLOTS) {
         return false;
     }
+    size_t needed = length + (slot == slot_count() ? SLOT_SIZE : 0);
+    return needed <= static_cast<size_t>(freespace);
+}
 
-    size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-    file.seekp(offset);
+bool Page::insert_record(int slot, const std::string& record) {
+    int slots = slot_count();
+    if (slot < 0 || slot > slots || slot >= MAX_SLOTS || (slot < slots && slot_offset(slot) != 0)) {
+        return false;
+    }
 
-    
-    file.seekg(0, std::ios::end);
-    size_t file_size = file.tellg();
-    
-    file.seekp(file_size);
+    int needed = static_cast<int>(record.size()) + (slot == slots ? SLOT_SIZE : 0);
+    if (needed > freespace) {
+        return false;
+    }
+    if (needed > contiguous_free()) {
+        compact();
+    }
 
-    
-    if (offset + PAGE_SIZE > file_size) {
-        size_t bytes_to_write =PAGE_SIZE- file_size;
-        char padding[bytes_to_write];
-        memset(padding, 0, bytes_to_write);
-        file.write(padding, bytes_to_write);
+    uint16_t start = data_start() - static_cast<uint16_t>(record.size());
+    std::memcpy(PageData + start, record.data(), record.size());
+    if (slot == slots) {
+        slots++;
     }
-    file.seekp(offset);
+    set_slot(slot, start, static_cast<uint16_t>(record.size()));
+    freespace -= needed;
+    write_header(slots, start);
+    return true;
+}
 
-    
-    int fs_network = htonl(freespace);
-    
-    file.write(reinterpret_cast<const char*>(&fs_network), sizeof(int));
-    if (file.fail()) {
-        std::cerr << "Error: Could not write freespace to file: " << filePath << std::endl;
-        file.close();
+// Reads the page and slot of a marker record with the given tag.
+bool Page::marker(int slot, char tag, int& page_id, int& slot_id) const {
+    if (slot < 0 || slot >= slot_count() || slot_offset(slot) == 0 || slot_length(slot) < MARKER_SIZE) {
         return false;
     }
+    const char* record = PageData + slot_offset(slot);
+    if (record[0] != 0 || record[1] != tag) {
+        return false;
+    }
+    page_id = read_i32(record + 2);
+    slot_id = read_u16(record + 6);
+    return true;
+}
+
+bool Page::forwarded(int slot, int& page_id, int& target) const {
+    return marker(slot, FORWARD_TAG, page_id, target);
+}
+
+bool Page::relocated(int slot, int& home_page, int& home_slot) const {
+    return marker(slot, RELOCATED_TAG, home_page, home_slot);
+}
+
+std::string Page::forward_record(int page_id, int slot) {
+    std::string record(MARKER_SIZE, '\0');
+    record[1] = FORWARD_TAG;
+    write_i32(&record[2], page_id);
+    write_u16(&record[6], static_cast<uint16_t>(slot));
+    return record;
+}
 
-    int id_first_network = htonl(ids_Range.first);
-    file.write(reinterpret_cast<const char*>(&id_first_network), sizeof(int));
-    if (file.fail()) {
-        std::cerr << "Error: Could not write ids_Range.first to file: " << filePath << std::endl;
-        file.close();
+std::string Page::relocated_record(int home_page, int home_slot, const std::string& row) {
+    std::string record = forward_record(home_page, home_slot);
+    record[1] = RELOCATED_TAG;
+    return record + row;
+}
+
+// Where the row of a slot lies in the page; false for free slots and forwarding stubs.
+bool Page::row_span(int slot, uint16_t& offset, uint16_t& length) const {
+    if (slot < 0 || slot >= slot_count() || slot_offset(slot) == 0) {
         return false;
     }
+    offset = slot_offset(slot);
+    length = slot_length(slot);
+    if (PageData[offset] == 0) {
+        if (length < MARKER_SIZE || PageData[offset + 1] != RELOCATED_TAG) {
+            return false;
+        }
+        offset += MARKER_SIZE;
+        length -= MARKER_SIZE;
+    }
+    return true;
+}
 
-    int id_second_network = htonl(ids_Range.second);
-    file.write(reinterpret_cast<const char*>(&id_second_network), sizeof(int));
-    if (file.fail()) {
-        std::cerr << "Error: Could not write ids_Range.second to file: " << filePath << std::endl;
-        file.close();
+bool Page::get_record(int slot, std::string& record) const {
+    uint16_t offset, length;
+    if (!row_span(slot, offset, length)) {
         return false;
     }
+    record.assign(PageData + offset, length);
+    return true;
+}
 
-    const int dsize = PAGE_SIZE - 3 * sizeof(int);
-    std::string pageData(dsize, '\0'); 
-    size_t dataOffset = 0;
+bool Page::read_tuple(int slot, const std::vector<std::string>& columns, Tuple& tuple) const {
+    uint16_t offset, length;
+    if (!row_span(slot, offset, length)) {
+        return false;
+    }
+    tuple.Deserialize(PageData + offset, length, columns);
+    return true;
+}
 
-    for ( auto& tuple : tuples) {
-        std::string tupleData = tuple.Serialize();
-        if (dataOffset + TUPLE_SIZE > dsize) {
-            std::cerr << "Error: Page size exceeded." << std::endl;
+bool Page::row_id(int slot, long long& id) const {
+    uint16_t offset, length;
+    if (!row_span(slot, offset, length)) {
+        return false;
+    }
+    const char* at = PageData + offset;
+    const char* end = at + length;
+    while (end - at >= 4) {
+        size_t key_length = static_cast<uint8_t>(at[0]);
+        if (static_cast<size_t>(end - at) < key_length + 4) {
             return false;
         }
-        std::memcpy(&pageData[dataOffset], tupleData.data(), TUPLE_SIZE);
-        dataOffset += TUPLE_SIZE;
+        const char* value = at + key_length + 4;
+        size_t value_length = read_u16(at + key_length + 2);
+        if (value + value_length > end) {
+            return false;
+        }
+        if (key_length == 2 && at[1] == 'i' && at[2] == 'd') {
+            id = 0;
+            for (size_t i = 0; i < value_length; i++) {
+                if (value[i] < '0' || value[i] > '9' || i == 18) {
+                    return false;
+                }
+                id = id * 10 + (value[i] - '0');
+            }
+            return value_length > 0;
+        }
+        at = value + value_length;
     }
-    
-    
-    file.write(pageData.data(), dsize - tuples.size() * 50);
+    return false;
+}
 
-    
-    size_t data_written = 3 * sizeof(int) + dataOffset;
-    if (data_written < PAGE_SIZE) {
-        char padding[PAGE_SIZE - data_written];
-        memset(padding, 0, PAGE_SIZE - data_written);
-        file.write(padding, PAGE_SIZE - data_written);
+bool Page::update_record(int slot, const std::string& record) {
+    int slots = slot_count();
+    if (slot < 0 || slot >= slots || slot_offset(slot) == 0) {
+        return false;
     }
+    uint16_t offset = slot_offset(slot);
+    uint16_t length = slot_length(slot);
+    if (record.size() <= length) {
+        std::memcpy(PageData + offset, record.data(), record.size());
+        set_slot(slot, offset, static_cast<uint16_t>(record.size()));
+        freespace += length - static_cast<int>(record.size());
+        write_header(slots, data_start());
+        return true;
+    }
+    if (static_cast<int>(record.size()) > freespace + length) {
+        return false;
+    }
+    // The old record becomes a hole, and the new one goes below the record area as an insert would.
+    freespace += length;
+    set_slot(slot, 0, 0);
+    if (static_cast<int>(record.size()) > contiguous_free()) {
+        compact();
+    }
+    uint16_t start = data_start() - static_cast<uint16_t>(record.size());
+    std::memcpy(PageData + start, record.data(), record.size());
+    set_slot(slot, start, static_cast<uint16_t>(record.size()));
+    freespace -= static_cast<int>(record.size());
+    write_header(slots, start);
+    return true;
+}
+
+bool Page::delete_record(int slot) {
+    int slots = slot_count();
+    if (slot < 0 || slot >= slots || slot_offset(slot) == 0) {
+        return false;
+    }
+
+    uint16_t start = data_start();
+    uint16_t offset = slot_offset(slot);
+    uint16_t length = slot_length(slot);
+    if (offset == start) {
+        start += length;
+    }
+    freespace += length;
+    set_slot(slot, 0, 0);
 
-    file.close();
+
+    while (slots > 0 && slot_offset(slots - 1) == 0) {
+        slots--;
+        freespace += SLOT_SIZE;
+    }
+    if (slots == 0) {
+        start = PAGE_SIZE;
+    }
+    write_header(slots, start);
     return true;
-}  
-
-Page* Page::deserialize(Page* page,int page_id, const std::string& dbName, const std::string& tableName) {
-        std::string filePath = dbName + "/" + tableName + ".HAD";
-        std::ifstream file(filePath, std::ios::in | std::ios::binary);
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open file for reading: " << filePath << std::endl;
-            return nullptr;
-        }
+}
 
-        size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-        file.seekg(offset);
-        if (file.fail()) {
-            std::cerr << "Error: Could not seek to offset " << offset << " in file: " << filePath << std::endl;
-            file.close();
-            return nullptr;
+// Slides every live record towards the end of the page so all holes left by deletes
+// become one contiguous gap between the slot directory and the record area.
+void Page::compact() {
+    int slots = slot_count();
+    std::vector<std::pair<uint16_t, int>> live;
+    for (int i = 0; i < slots; i++) {
+        if (slot_offset(i) != 0) {
+            live.push_back({slot_offset(i), i});
         }
+    }
+    std::sort(live.begin(), live.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
 
-        size_t file_size = 0;
-        file.seekg(0, std::ios::end);
-        file_size = file.tellg();
-        
-        file.seekg(offset);
+    uint16_t end = PAGE_SIZE;
+    for (const auto& entry : live) {
+        uint16_t length = slot_length(entry.second);
+        end -= length;
+        std::memmove(PageData + end, PageData + entry.first, length);
+        set_slot(entry.second, end, length);
+    }
+    int directory_end = HEADER_SIZE + slots * SLOT_SIZE;
+    std::memset(PageData + directory_end, 0, end - directory_end);
+    write_header(slots, end);
+}
 
-        if (file_size < offset + PAGE_SIZE) {
-            std::cerr << "File is smaller than expected for page " << page_id << std::endl;
-            file.close();
-            return nullptr;
-        }
+bool Page::fragmented() const {
+    return contiguous_free() < freespace;
+}
 
-        int freespace_network;
-        if (!file.read(reinterpret_cast<char*>(&freespace_network), sizeof(int))) {
-            std::cerr << "Error: Could not read freespace from file: " << filePath << std::endl;
-            file.close();
-            return nullptr;
-        }
-        int freespace = ntohl(freespace_network);
+bool Page::insert_tuple(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes){
+    int slot = next_slot();
+    if (slot >= MAX_SLOTS || !ids_left()) {
+        std::cerr << "Error: No free slot left in page " << pageId << std::endl;
+        return false;
+    }
 
-        int id_first_network;
-        if (!file.read(reinterpret_cast<char*>(&id_first_network), sizeof(int))) {
-            std::cerr << "Error: Could not read ids_Range.first from file: " << filePath << std::endl;
-            file.close();
-            return nullptr;
-        }
-        int id_first = ntohl(id_first_network);
+    Tuple t;
+    for (const auto& attr : attributes) {
+        t.add_attribute(attr.first, attr.second.second);
+    }
+    t.add_attribute("id",std::to_string(ids_Range.first));
 
-        int id_second_network;
-        if (!file.read(reinterpret_cast<char*>(&id_second_network), sizeof(int))) {
-            std::cerr << "Error: Could not read ids_Range.second from file: " << filePath << std::endl;
-            file.close();
-            return nullptr;
-        }
-        int id_second = ntohl(id_second_network);
-
-        const size_t used_space = PAGE_SIZE - freespace;
-        const size_t tuples_size = used_space - 3 * sizeof(int);    
-        
-
-       const int dsize = PAGE_SIZE - 3 * sizeof(int);
-    std::string pageData(dsize, '\0');
-    file.read(&pageData[0], dsize);
-
-    
-    page->tuples.clear();
-    
-    size_t dataOffset = 0;
-    while (dataOffset + TUPLE_SIZE <= tuples_size) {
-        std::string tupleData(&pageData[dataOffset], TUPLE_SIZE);
-        Tuple tuple;
-        tuple.Deserialize(tupleData);
-        page->tuples.push_back(tuple);
-        dataOffset += TUPLE_SIZE;
-    }
-        page->freespace = freespace;
-        page->pageId = page_id;
-        page->ids_Range={id_first,id_second};
-        file.close();
-        return page;
+    std::string record = t.Serialize();
+    ids_Range.first++;
+    if (!insert_record(slot, record)) {
+        ids_Range.first--;
+        std::cerr << "Error: Record of " << record.size() << " bytes does not fit in page " << pageId << std::endl;
+        return false;
     }
+    return true;
+}
 
-std::vector<Tuple> Page::get_tuple(const std::pair<std::string, std::string>& attribute){
-        std::vector<Tuple> results;
-        if(!(attribute.first == " " && attribute.second == " ")){
-            for(auto tuple:tuples){
-                if(tuple.get_attribute(attribute.first) == attribute.second){
-                    results.push_back(tuple);
+// Deletes the rows whose stored bytes match accepts, or every row when match is empty, by freeing
+// their slots; the records stay where they are until the space is needed or the page is compacted.
+// With removed set, the record id of every deleted row is reported, with the named columns decoded
+// when columns is set, so indexes can drop their entries and the stubs of relocated rows can go.
+bool Page::del_tuple(const std::function<bool(const char*, size_t)>& match, std::vector<RemovedRow>* removed,
+                     const std::vector<std::string>* columns){
+        bool deleted = false;
+        int slots = slot_count();
+        for (int slot = slots - 1; slot >= 0; slot--) {
+            uint16_t offset, length;
+            if (!row_span(slot, offset, length) || (match && !match(PageData + offset, length))) {
+                continue;
+            }
+            RemovedRow row{pageId, slot, Tuple()};
+            if (removed != nullptr && columns != nullptr) {
+                row.tuple.Deserialize(PageData + offset, length, *columns);
+            }
+            relocated(slot, row.page, row.slot);
+            if (delete_record(slot)) {
+                deleted = true;
+                if (removed != nullptr) {
+                    removed->push_back(std::move(row));
                 }
             }
-            
-            return results;
         }
-        else{
-           
-            return tuples;
+        return deleted;
+}
+
+
+std::vector<Tuple> Page::get_tuple(const std::pair<std::string, std::string>& attribute){
+        std::vector<Tuple> results;
+        bool all = attribute.first == " " && attribute.second == " ";
+        int slots = slot_count();
+        for (int slot = 0; slot < slots; slot++) {
+            uint16_t offset, length;
+            if (!row_span(slot, offset, length)) {
+                continue;
+            }
+            Tuple tuple;
+            tuple.Deserialize(PageData + offset, length);
+            if (all || tuple.get_attribute(attribute.first) == attribute.second) {
+                results.push_back(std::move(tuple));
+            }
         }
-    }
\ No newline at end of file
+        return results;
+    }
@@ -5,28 +5,86 @@
 #include <string>
 #include <map>
 #include <utility>
+#include <cstdint>
+#include <functional>
 #define PAGE_SIZE 4096
 #include "tuple.hpp"
 
+class Buffer_Page;
 
+// A row a page gave up, under the record id it is known by: its own slot, or for a relocated row
+// the slot of its forwarding stub.
+struct RemovedRow {
+    int page;
+    int slot;
+    Tuple tuple;
+};
+
+// Records start with the length of their first key, which is never zero. A record starting with
+// a zero byte is one of two markers instead: a forwarding stub left in the slot of a row that
+// grew too large for its page, holding the page and slot the row moved to, or a relocated row,
+// headed by the page and slot of its stub. Record ids and index entries keep naming the stub, so
+// a row can move without them changing; scans read relocated rows where they are and skip stubs.
 class Page {
 public:
     
     int pageId;
     int freespace;  
-     std::vector<Tuple> tuples; 
+    // The next row id this page issues and the last id of its block; see Table::Renew_ids.
     std::pair<int,int> ids_Range;
-    char* PageData[PAGE_SIZE];
+    char* PageData;
+    Buffer_Page* frame = nullptr;
+    bool exclusive = false;
     
     bool insert_tuple(const std::vector<std::pair<std::string, std::pair<int, std::string>>>& attributes);
     std::vector<Tuple> get_tuple(const std::pair<std::string, std::string>& attribute);
-    bool update_tuple( std::pair<std::string, std::string>& attribute);
-    bool del_tuple(const std::pair<std::string, std::string>& attribute);
-    bool serialize(int page_id, const std::string& dbName, const std::string& tableName);
-    static Page* deserialize(Page* page,int page_id, const std::string& dbName, const std::string& tableName);
-    Page(int free,std::pair<int,int>);
+    bool del_tuple(const std::function<bool(const char*, size_t)>& match, std::vector<RemovedRow>* removed = nullptr,
+                   const std::vector<std::string>* columns = nullptr);
+
+    
+    int slot_count() const;
+    int next_slot() const;
+    bool can_fit(size_t length) const;
+    bool insert_record(int slot, const std::string& record);
+    // The row stored in a slot, without the header of a relocated row; false for stubs.
+    bool get_record(int slot, std::string& record) const;
+    // Decodes the named columns of one slot straight from the page, all of them when none are named.
+    bool read_tuple(int slot, const std::vector<std::string>& columns, Tuple& tuple) const;
+    // The id stored in the row of a slot, read without decoding the other columns.
+    bool row_id(int slot, long long& id) const;
+    bool delete_record(int slot);
+    // Replaces the record of a slot, in place when it is no longer; false when it does not fit.
+    bool update_record(int slot, const std::string& record);
+    bool forwarded(int slot, int& page_id, int& target) const;
+    bool relocated(int slot, int& home_page, int& home_slot) const;
+    static std::string forward_record(int page_id, int slot);
+    static std::string relocated_record(int home_page, int home_slot, const std::string& row);
+    void compact();
+    // True when freed records left holes that compact() would join to the free gap.
+    bool fragmented() const;
+    void init(std::pair<int,int> ids);
+    void assign_ids(std::pair<int,int> ids);
+    bool ids_left() const { return ids_Range.first <= ids_Range.second; }
+    Page(int page_id, char* data);
+
+    
+    static constexpr int HEADER_SIZE = 16;
+    static constexpr int SLOT_SIZE = 4;
+    static constexpr int MAX_SLOTS = (PAGE_SIZE - HEADER_SIZE) / SLOT_SIZE;
+    // Zero byte, tag, page, slot: a whole forwarding stub, or the header of a relocated row.
+    static constexpr int MARKER_SIZE = 8;
 private:
-    static const size_t TUPLE_SIZE = 50; 
+    static constexpr char FORWARD_TAG = 'F';
+    static constexpr char RELOCATED_TAG = 'R';
+
+    bool marker(int slot, char tag, int& page_id, int& slot_id) const;
+    bool row_span(int slot, uint16_t& offset, uint16_t& length) const;
+    uint16_t slot_offset(int slot) const;
+    uint16_t slot_length(int slot) const;
+    void set_slot(int slot, uint16_t offset, uint16_t length);
+    uint16_t data_start() const;
+    int contiguous_free() const;
+    void write_header(int slots, uint16_t start);
     
 };
 
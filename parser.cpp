@@ -1,4 +1,5 @@
 #include "parser.hpp"
+#include <climits>
 
 using namespace std;
 
@@ -6,35 +7,88 @@ using namespace std;
 Column::Column(const string& name, ColumnType type)
     : name(name), type(type) {}
 
+// The digits of a LIMIT or PARALLEL clause as a number no larger than max; false when they do
+// not fit, so a huge count is a syntax error instead of an exception out of the REPL.
+static bool parseCount(const string& digits, long max, long& value) {
+    value = 0;
+    for (char digit : digits) {
+        if (value > (max - (digit - '0')) / 10) {
+            return false;
+        }
+        value = value * 10 + (digit - '0');
+    }
+    return true;
+}
+
 QueryInfo SyntaxValidator::validateAndExtract(const string& query) {
     QueryInfo info;
     smatch matches;
 
-    static const regex selectPattern(R"(SELECT\s+((\*)|(\w+)|([\w\s,]+))\s+FROM\s+(\w+)(?:\s+WHERE\s+(.+))?)", regex_constants::icase);
+    static const regex selectPattern(R"(SELECT\s+((\*)|([\w.]+)|([\w\s,.()*]+))\s+FROM\s+(\w+)(?:\s+(?:INNER\s+)?JOIN\s+(\w+)\s+ON\s+([\w.]+)\s*=\s*([\w.]+))?(?:\s+WHERE\s+(.+?))?(?:\s+GROUP\s+BY\s+([\w\s,.]+?))?(?:\s+ORDER\s+BY\s+([\w\s,.()*]+?))?(?:\s+LIMIT\s+(\d+))?(?:\s+PARALLEL\s+(\d+))?)", regex_constants::icase);
     if (regex_match(query, matches, selectPattern)) {
         info.type = "SELECT";
         string columnPart = matches[1].str();
         info.tableName = matches[5].str();
-        info.condition = matches.size() > 6 && matches[6].matched ? matches[6].str() : "";
+        if (matches[6].matched) {
+            info.joinTable = matches[6].str();
+            info.joinLeft = matches[7].str();
+            info.joinRight = matches[8].str();
+        }
+        info.condition = matches[9].matched ? matches[9].str() : "";
+        info.groupBy = matches[10].matched ? splitAndTrim(matches[10].str()) : vector<string>{};
+        if (matches[12].matched && !parseCount(matches[12].str(), LONG_MAX, info.limit)) {
+            info.type = "UNKNOWN";
+        }
+        long parallelism = 0;
+        if (matches[13].matched && !parseCount(matches[13].str(), INT_MAX, parallelism)) {
+            info.type = "UNKNOWN";
+        }
+        info.parallelism = static_cast<int>(parallelism);
         info.columns = (columnPart == "*") ? vector<string>{"*"} : splitAndTrim(columnPart);
+
+        static const regex orderPattern(R"(([\w.]+|\w+\s*\(\s*[\w.*]+\s*\))(?:\s+(ASC|DESC))?)", regex_constants::icase);
+        for (const string& item : matches[11].matched ? splitAndTrim(matches[11].str()) : vector<string>{}) {
+            smatch order;
+            if (!regex_match(item, order, orderPattern)) {
+                info.type = "UNKNOWN";
+                break;
+            }
+            string direction = order[2].str();
+            info.orderBy.push_back({order[1].str(), !direction.empty() && toupper(direction[0]) == 'D'});
+        }
+
+        static const regex aggregatePattern(R"((COUNT|SUM|AVG|MIN|MAX)\s*\(\s*(\*|[\w.]+)\s*\))", regex_constants::icase);
+        for (const string& column : info.columns) {
+            smatch call;
+            if (regex_match(column, call, aggregatePattern)) {
+                string function = call[1].str();
+                transform(function.begin(), function.end(), function.begin(), ::toupper);
+                info.aggregates.push_back({function, call[2].str(), column});
+            } else if (column.find_first_of("()") != string::npos || (column.find('*') != string::npos && column != "*")) {
+                info.type = "UNKNOWN";
+            }
+        }
         return info;
     }
 
-    static const regex createIndexPattern(R"(CREATE\s+INDEX\s+(\w+)\s+ON\s+(\w+)\s*\((\w+)\))", regex_constants::icase);
+    static const regex createIndexPattern(R"(CREATE\s+INDEX\s+(\w+)\s+ON\s+(\w+)(?:\s+USING\s+(\w+))?\s*\((\w+)\)(?:\s+USING\s+(\w+))?)", regex_constants::icase);
     if (regex_match(query, matches, createIndexPattern)) {
         info.type = "CREATE_INDEX";
         info.indexName = matches[1].str();
         info.tableName = matches[2].str();
-        info.columns = {matches[3].str()};
+        info.columns = {matches[4].str()};
+        info.indexMethod = matches[3].matched ? matches[3].str() : (matches[5].matched ? matches[5].str() : "BTREE");
         return info;
     }
 
-    static const regex insertPattern(R"(INSERT\s+INTO\s+(\w+)\s*\(([\w\s,]+)\)\s*VALUES\s*\(([\w\s',]+)\))", regex_constants::icase);
+    static const regex insertPattern(R"(INSERT\s+INTO\s+(\w+)\s*\(([\w\s,]+)\)\s*VALUES\s*\(([\w\s',.+-]+)\))", regex_constants::icase);
     if (regex_match(query, matches, insertPattern)) {
         info.type = "INSERT";
         info.tableName = matches[1].str();
         info.columns = splitAndTrim(matches[2].str());
-        info.values = splitAndTrim(matches[3].str());
+        for (const string& value : splitAndTrim(matches[3].str())) {
+            info.values.push_back(unquote(value));
+        }
         return info;
     }
 
@@ -46,7 +100,7 @@ QueryInfo SyntaxValidator::validateAndExtract(const string& query) {
         return info;
     }
 
-    static const regex updatePattern(R"(UPDATE\s+(\w+)\s+SET\s+([\w\s=,]+)(?:\s+WHERE\s+(.+))?)", regex_constants::icase);
+    static const regex updatePattern(R"(UPDATE\s+(\w+)\s+SET\s+([\w\s=,'.+-]+?)(?:\s+WHERE\s+(.+))?)", regex_constants::icase);
     if (regex_match(query, matches, updatePattern)) {
         info.type = "UPDATE";
         info.tableName = matches[1].str();
@@ -55,6 +109,13 @@ QueryInfo SyntaxValidator::validateAndExtract(const string& query) {
         return info;
     }
 
+    static const regex vacuumPattern(R"(VACUUM\s+(\w+))", regex_constants::icase);
+    if (regex_match(query, matches, vacuumPattern)) {
+        info.type = "VACUUM";
+        info.tableName = matches[1].str();
+        return info;
+    }
+
     static const regex createTablePattern(R"(CREATE\s+TABLE\s+(\w+)\s*\(([\w\s,]+)\))", regex_constants::icase);
     if (regex_match(query, matches, createTablePattern)) {
         info.type = "CREATE";
@@ -67,6 +128,14 @@ QueryInfo SyntaxValidator::validateAndExtract(const string& query) {
     return info;
 }
 
+// A value quoted as 'abc' is stored as abc, so it matches the same literal in a WHERE clause.
+string SyntaxValidator::unquote(const string& value) {
+    if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') {
+        return value.substr(1, value.size() - 2);
+    }
+    return value;
+}
+
 vector<string> SyntaxValidator::splitAndTrim(const string& str, char delimiter) {
     vector<string> result;
     stringstream ss(str);
@@ -84,10 +153,32 @@ vector<ExecutionStep> ExecutionPlanGenerator::generatePlan(const QueryInfo& quer
 
         if (queryInfo.type == "SELECT") {
             plan.push_back({"Table Scan", queryInfo.tableName, "Sequential Scan of table"});
+            if (!queryInfo.joinTable.empty()) {
+                plan.push_back({"Table Scan", queryInfo.joinTable, "Sequential Scan of table"});
+                plan.push_back({"Hash Join", queryInfo.joinLeft + " = " + queryInfo.joinRight, "Joining on equal keys through an in-memory hash table"});
+            }
+            if (queryInfo.parallelism > 0) {
+                plan.push_back({"Parallel", to_string(queryInfo.parallelism), "Scanning page morsels on a thread pool"});
+            }
             if (!queryInfo.condition.empty()) {
                 plan.push_back({"Filter", queryInfo.condition, "Applying WHERE clause filters"});
             }
-            plan.push_back({"Projection", join(queryInfo.columns), "Selecting specific columns"});
+            if (!queryInfo.aggregates.empty() || !queryInfo.groupBy.empty()) {
+                plan.push_back({"Aggregate", join(queryInfo.groupBy), "Hash aggregation of " + join(queryInfo.columns)});
+            }
+            if (!queryInfo.orderBy.empty()) {
+                vector<string> order;
+                for (const auto& [column, descending] : queryInfo.orderBy) {
+                    order.push_back(column + (descending ? " DESC" : " ASC"));
+                }
+                plan.push_back({"Sort", join(order), queryInfo.limit >= 0 ? "Keeping the first rows in a heap" : "External merge sort"});
+            }
+            if (queryInfo.aggregates.empty() && queryInfo.groupBy.empty()) {
+                plan.push_back({"Projection", join(queryInfo.columns), "Selecting specific columns"});
+            }
+            if (queryInfo.limit >= 0) {
+                plan.push_back({"Limit", to_string(queryInfo.limit), "Stopping after the first rows"});
+            }
         }
         else if (queryInfo.type == "CREATE_INDEX") {
             plan.push_back({"Create Index", queryInfo.indexName, "Creating new index"});
@@ -115,6 +206,9 @@ vector<ExecutionStep> ExecutionPlanGenerator::generatePlan(const QueryInfo& quer
                 plan.push_back({"Warning", "Full table", "All rows will be updated"});
             }
         }
+        else if (queryInfo.type == "VACUUM") {
+            plan.push_back({"Vacuum", queryInfo.tableName, "Compacting pages and releasing empty trailing pages"});
+        }
         else if (queryInfo.type == "CREATE") {
             plan.push_back({"Create", queryInfo.tableName, "Creating new table"});
             
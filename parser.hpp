@@ -36,18 +36,35 @@ private:
     
 };
 
+// An aggregate of the select list: COUNT(*), or COUNT, SUM, AVG, MIN or MAX of a column.
+struct AggregateCall {
+    std::string function;
+    std::string argument;
+    std::string text;
+};
+
 struct QueryInfo {
     std::string type;
     std::string tableName;
+    std::string joinTable;
+    std::string joinLeft;
+    std::string joinRight;
     std::vector<std::string> columns;
     std::string condition;
+    std::vector<std::string> groupBy;
+    std::vector<AggregateCall> aggregates;
+    std::vector<std::pair<std::string, bool>> orderBy;  // column, descending
     std::vector<std::string> values;
     std::string indexName;
+    std::string indexMethod;
+    long limit = -1;
+    int parallelism = 0;
 };
 
 class SyntaxValidator {
 public:
     QueryInfo validateAndExtract(const std::string& query);
+    static std::string unquote(const std::string& value);
 
 private:
     std::vector<std::string> splitAndTrim(const std::string& str, char delimiter = ',');
@@ -0,0 +1,29 @@
+#!/bin/sh
+# LIMIT and PARALLEL counts too large to hold are syntax errors instead of exceptions that end the REPL,
+# and the REPL keeps answering after them.
+PROGRAM=${PROGRAM:-./program}
+DB=$(mktemp -d)
+trap 'rm -rf "$DB"' EXIT
+
+output=$("$PROGRAM" "$DB/db" 2>&1 <<'SQL'
+CREATE TABLE a (k INT)
+INSERT INTO a (k) VALUES (7)
+SELECT k FROM a PARALLEL 99999999999
+SELECT k FROM a PARALLEL 100000
+SELECT k FROM a LIMIT 99999999999999999999
+SELECT k FROM a LIMIT 9223372036854775807
+exit
+SQL
+)
+
+status=0
+expect() {
+    count=$(printf '%s\n' "$output" | grep -cF -- "$1")
+    if [ "$count" -ne "$2" ]; then
+        echo "clause_counts: expected '$1' $2 times, got $count"
+        status=1
+    fi
+}
+expect "Syntax Error: Invalid query format" 2
+expect "k              7" 2
+exit $status
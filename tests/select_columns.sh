@@ -0,0 +1,33 @@
+#!/bin/sh
+# SELECT lists naming a column the table does not have are rejected with an error, on one table
+# and on a join, instead of printing an empty value for every row.
+PROGRAM=${PROGRAM:-./program}
+DB=$(mktemp -d)
+trap 'rm -rf "$DB"' EXIT
+
+output=$("$PROGRAM" "$DB/db" 2>&1 <<'SQL'
+CREATE TABLE a (k INT, name VARCHAR)
+CREATE TABLE c (k INT, tag VARCHAR)
+INSERT INTO a (k, name) VALUES (1, x)
+INSERT INTO c (k, tag) VALUES (1, t)
+SELECT nosuch FROM a
+SELECT nosuch, name FROM a JOIN c ON a.k = c.k
+SELECT a.nosuch FROM a JOIN c ON a.k = c.k
+SELECT a.k, COUNT(*) FROM a JOIN c ON a.k = c.k GROUP BY a.k
+SELECT name FROM a
+exit
+SQL
+)
+
+status=0
+expect() {
+    if ! printf '%s\n' "$output" | grep -qF -- "$1"; then
+        echo "select_columns: expected '$1'"
+        status=1
+    fi
+}
+expect "Error: Unknown column nosuch"
+expect "Error: Unknown column a.nosuch"
+expect "COUNT(*)       1"
+expect "name           x"
+exit $status
@@ -0,0 +1,33 @@
+#!/bin/sh
+# INSERT values and UPDATE assignments take signed and decimal literals, so FLOAT columns can hold
+# fractions and any column a negative number.
+PROGRAM=${PROGRAM:-./program}
+DB=$(mktemp -d)
+trap 'rm -rf "$DB"' EXIT
+
+output=$("$PROGRAM" "$DB/db" 2>&1 <<'SQL'
+CREATE TABLE a (k INT, score FLOAT)
+INSERT INTO a (k, score) VALUES (1, -0.25)
+INSERT INTO a (k, score) VALUES (-2, 3.5)
+UPDATE a SET score = 1.5 WHERE k = 1
+UPDATE a SET score = -2 WHERE k = -2
+SELECT score FROM a WHERE k = 1
+SELECT k FROM a WHERE score < 0
+exit
+SQL
+)
+
+status=0
+expect() {
+    if ! printf '%s\n' "$output" | grep -qF -- "$1"; then
+        echo "signed_values: expected '$1'"
+        status=1
+    fi
+}
+if printf '%s\n' "$output" | grep -qF "Syntax Error"; then
+    echo "signed_values: a statement was rejected"
+    status=1
+fi
+expect "score          1.5"
+expect "k              -2"
+exit $status
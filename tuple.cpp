@@ -1,6 +1,8 @@
 #include "tuple.hpp"
 #include <cstring>
 #include <stdexcept>
+#include <algorithm>
+#include <string_view>
 
 void Tuple::add_attribute(const std::string& key, const std::string& value) {
     attributes.push_back(std::make_pair(key, std::make_pair(TYPE_STRING, value)));
@@ -32,49 +34,45 @@ void Tuple::update_attribute(const std::vector<std::pair<std::string, std::strin
 }
 
 std::string Tuple::Serialize() {
-    std::string data(TUPLE_SIZE, '\0'); 
-    size_t offset = 0;
+    std::string data;
 
     for (const auto& attr : attributes) {
-        
-        if (offset + 1 > TUPLE_SIZE) break;
-        uint8_t key_length = static_cast<uint8_t>(attr.first.size());
-        data[offset++] = static_cast<char>(key_length);
-
-        
-        size_t key_write_size = std::min(attr.first.size(), static_cast<size_t>(TUPLE_SIZE - offset));
-        std::memcpy(&data[offset], attr.first.data(), key_write_size);
-        offset += key_write_size;
+        size_t key_length = std::min(attr.first.size(), MAX_KEY_SIZE);
+        size_t value_length = attr.second.second.size();
+        if (value_length > MAX_VALUE_SIZE) {
+            throw std::length_error("Tuple: value of attribute '" + attr.first + "' is too long");
+        }
 
         
-        if (offset + 1 > TUPLE_SIZE) break;
-        uint8_t type = static_cast<uint8_t>(attr.second.first);
-        data[offset++] = static_cast<char>(type);
+        data.push_back(static_cast<char>(key_length));
+        data.append(attr.first.data(), key_length);
 
         
-        if (offset + 1 > TUPLE_SIZE) break;
-        uint8_t value_length = static_cast<uint8_t>(attr.second.second.size());
-        data[offset++] = static_cast<char>(value_length);
+        data.push_back(static_cast<char>(attr.second.first));
 
         
-        size_t value_write_size = std::min(attr.second.second.size(), static_cast<size_t>(TUPLE_SIZE - offset));
-        std::memcpy(&data[offset], attr.second.second.data(), value_write_size);
-        offset += value_write_size;
+        data.push_back(static_cast<char>((value_length >> 8) & 0xFF));
+        data.push_back(static_cast<char>(value_length & 0xFF));
+        data.append(attr.second.second.data(), value_length);
     }
 
     return data;
 }
 
 void Tuple::Deserialize(const std::string& data) {
+    Deserialize(data.data(), data.size());
+}
+
+void Tuple::Deserialize(const char* data, size_t length) {
     attributes.clear();
     size_t offset = 0;
 
-    while (offset + 3 <= TUPLE_SIZE) { 
+    while (offset + 4 <= length) { 
         
         uint8_t key_length = static_cast<uint8_t>(data[offset++]);
 
         
-        if (offset + key_length > TUPLE_SIZE) break;
+        if (offset + key_length + 3 > length) break;
         std::string key(&data[offset], key_length);
         offset += key_length;
 
@@ -82,14 +80,47 @@ void Tuple::Deserialize(const std::string& data) {
         uint8_t type = static_cast<uint8_t>(data[offset++]);
 
         
-        uint8_t value_length = static_cast<uint8_t>(data[offset++]);
+        size_t value_length = (static_cast<uint8_t>(data[offset]) << 8) | static_cast<uint8_t>(data[offset + 1]);
+        offset += 2;
 
         
-        if (offset + value_length > TUPLE_SIZE) break;
+        if (offset + value_length > length) break;
         std::string value(&data[offset], value_length);
         offset += value_length;
 
         
         attributes.push_back(std::make_pair(key, std::make_pair(static_cast<AttributeType>(type), value)));
     }
-}
\ No newline at end of file
+}
+
+// The attributes not asked for are stepped over by their lengths, never copied.
+void Tuple::Deserialize(const char* data, size_t length, const std::vector<std::string>& columns) {
+    if (columns.empty()) {
+        Deserialize(data, length);
+        return;
+    }
+    attributes.assign(columns.size(), {});
+    size_t found = 0;
+    size_t offset = 0;
+    while (offset + 4 <= length && found < columns.size()) {
+        uint8_t key_length = static_cast<uint8_t>(data[offset++]);
+        if (offset + key_length + 3 > length) break;
+        std::string_view key(&data[offset], key_length);
+        offset += key_length;
+        uint8_t type = static_cast<uint8_t>(data[offset++]);
+        size_t value_length = (static_cast<uint8_t>(data[offset]) << 8) | static_cast<uint8_t>(data[offset + 1]);
+        offset += 2;
+        if (offset + value_length > length) break;
+        for (size_t i = 0; i < columns.size(); i++) {
+            if (key == columns[i] && attributes[i].first.empty()) {
+                attributes[i] = {columns[i], {static_cast<AttributeType>(type), std::string(&data[offset], value_length)}};
+                found++;
+            }
+        }
+        offset += value_length;
+    }
+    if (found < columns.size()) {
+        attributes.erase(std::remove_if(attributes.begin(), attributes.end(), [](const auto& attr) { return attr.first.empty(); }),
+                         attributes.end());
+    }
+}
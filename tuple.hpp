@@ -23,9 +23,13 @@ public:
     void update_attribute(const std::vector<std::pair<std::string, std::string>>& attrs);
     std::string Serialize(); 
     void Deserialize(const std::string& data); 
+    void Deserialize(const char* data, size_t length);
+    // Only the named attributes, in the order named; all of them when none are named.
+    void Deserialize(const char* data, size_t length, const std::vector<std::string>& columns);
 
 private:
-    static const size_t TUPLE_SIZE = 50; 
+    static constexpr size_t MAX_KEY_SIZE = 255;
+    static constexpr size_t MAX_VALUE_SIZE = 65535;
     
 };
 